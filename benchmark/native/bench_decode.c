@@ -0,0 +1,170 @@
+/*
+ * libmedia native decoder benchmark
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/**
+ * 使用 decode.c 回放包 fixture，统计解码吞吐
+ * 
+ * bench_decode <fixture.lmpk> [thread_count] [loop]
+ */
+
+#include "config.h"
+#include "./fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+
+#include "../../packages/avcodec/src/clib/stats/stats.h"
+
+typedef struct DecoderContext DecoderContext;
+
+DecoderContext* decoder_create();
+int decoder_context_open(DecoderContext* decoder, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts);
+int decoder_context_decode(DecoderContext* decoder, AVPacket* packet);
+int decoder_context_flush(DecoderContext* decoder);
+int decoder_context_receive(DecoderContext* decoder, AVFrame* frame);
+int decoder_context_set_stats(DecoderContext* decoder, CodecStats* stats);
+void decoder_context_close(DecoderContext* decoder);
+void decoder_destroy(DecoderContext* decoder);
+
+static int receive_all(DecoderContext* decoder, AVFrame* frame, int64_t* frames) {
+  int ret;
+  while ((ret = decoder_context_receive(decoder, frame)) > 0) {
+    (*frames)++;
+    av_frame_unref(frame);
+  }
+  return ret;
+}
+
+int main(int argc, char** argv) {
+  FixturePacketFile fixture;
+  AVCodecParameters* codecpar;
+  AVRational time_base;
+  DecoderContext* decoder;
+  AVPacket* packet;
+  AVFrame* frame;
+  CodecStats stats;
+  int thread_count = argc > 2 ? atoi(argv[2]) : 1;
+  int loop = argc > 3 ? atoi(argv[3]) : 1;
+  int64_t frames = 0;
+  double start;
+  double time = 0;
+  int ret = 0;
+  int i, j;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <fixture.lmpk> [thread_count] [loop]\n", argv[0]);
+    return 1;
+  }
+
+  if (fixture_read_packets(argv[1], &fixture) < 0) {
+    return 1;
+  }
+
+  codecpar = avcodec_parameters_alloc();
+  codecpar->codec_type = fixture.header.codec_type;
+  codecpar->codec_id = fixture.header.codec_id;
+  codecpar->format = fixture.header.format;
+  codecpar->profile = fixture.header.profile;
+  codecpar->level = fixture.header.level;
+  codecpar->width = fixture.header.width;
+  codecpar->height = fixture.header.height;
+  codecpar->sample_rate = fixture.header.sample_rate;
+  if (fixture.header.channels > 0) {
+    av_channel_layout_default(&codecpar->ch_layout, fixture.header.channels);
+  }
+  if (fixture.header.extradata_size > 0) {
+    codecpar->extradata = av_mallocz(fixture.header.extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+    memcpy(codecpar->extradata, fixture.extradata, fixture.header.extradata_size);
+    codecpar->extradata_size = fixture.header.extradata_size;
+  }
+  time_base.num = fixture.header.time_base_num;
+  time_base.den = fixture.header.time_base_den;
+
+  memset(&stats, 0, sizeof(stats));
+
+  packet = av_packet_alloc();
+  frame = av_frame_alloc();
+  decoder = decoder_create();
+  decoder_context_set_stats(decoder, &stats);
+
+  for (i = 0; i < loop && ret >= 0; i++) {
+    // 每一轮重新打开解码器，保证每轮都从关键帧开始
+    if ((ret = decoder_context_open(decoder, codecpar, &time_base, thread_count, NULL)) < 0) {
+      fprintf(stderr, "open decoder failed: %s\n", av_err2str(ret));
+      break;
+    }
+
+    start = bench_now();
+
+    for (j = 0; j < fixture.nb_packets; j++) {
+      // 不带 buf 的包由 avcodec_send_packet 拷贝，和 wasm 侧每次拷贝一份包数据的开销一致
+      packet->data = fixture.packets[j].data;
+      packet->size = fixture.packets[j].size;
+      packet->flags = fixture.packets[j].flags;
+      packet->pts = fixture.packets[j].pts;
+      packet->dts = fixture.packets[j].dts;
+
+      if ((ret = decoder_context_decode(decoder, packet)) < 0) {
+        break;
+      }
+      if ((ret = receive_all(decoder, frame, &frames)) < 0) {
+        break;
+      }
+    }
+
+    if (ret >= 0 && (ret = decoder_context_flush(decoder)) >= 0) {
+      ret = receive_all(decoder, frame, &frames);
+    }
+
+    time += bench_now() - start;
+
+    decoder_context_close(decoder);
+  }
+
+  if (ret >= 0) {
+    bench_report("decoder", avcodec_get_name(fixture.header.codec_id), frames, time);
+    #if ENABLE_CODEC_STATS
+    fprintf(
+      stderr,
+      "send: %.3fms, receive: %.3fms, bytes in: %lld, eagain: %d, errors: %d\n",
+      stats.send_time,
+      stats.receive_time,
+      (long long)stats.bytes_in,
+      stats.eagain,
+      stats.errors
+    );
+    #endif
+  }
+
+  decoder_destroy(decoder);
+  av_frame_free(&frame);
+  av_packet_free(&packet);
+  avcodec_parameters_free(&codecpar);
+  fixture_free_packets(&fixture);
+
+  return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * libmedia native encoder benchmark
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/**
+ * 使用 encode.c 编码合成的 YUV420P 帧，统计编码吞吐
+ * 
+ * bench_encode <codec> <width> <height> <frames> [bitrate] [preset] [thread_count]
+ * 
+ * codec 为编码库名字，例如 libx264、libvpx-vp9，preset 取值 0 - 3 对应 EncoderPreset
+ */
+
+#include "config.h"
+#include "./fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+
+#include "../../packages/avcodec/src/clib/stats/stats.h"
+
+// 合成帧的数量，编码时循环使用，生成帧的开销不计入耗时
+#define SOURCE_FRAMES 60
+
+typedef struct EncoderContext EncoderContext;
+
+EncoderContext* encoder_create();
+int encoder_context_open(EncoderContext* encoder, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts);
+void encoder_context_set_gop_size(EncoderContext* encoder, int gop);
+void encoder_context_set_preset(EncoderContext* encoder, int preset);
+int encoder_context_set_stats(EncoderContext* encoder, CodecStats* stats);
+int encoder_context_encode(EncoderContext* encoder, AVFrame* frame);
+int encoder_context_flush(EncoderContext* encoder);
+int encoder_context_receive(EncoderContext* encoder, AVPacket* packet);
+void encoder_destroy(EncoderContext* encoder);
+
+/**
+ * 生成带运动的渐变图案，避免静止画面让编码器走捷径
+ */
+static AVFrame* create_source_frame(int width, int height, int index) {
+  AVFrame* frame = av_frame_alloc();
+  int x, y;
+
+  frame->width = width;
+  frame->height = height;
+  frame->format = AV_PIX_FMT_YUV420P;
+
+  if (av_frame_get_buffer(frame, 0) < 0) {
+    av_frame_free(&frame);
+    return NULL;
+  }
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      frame->data[0][y * frame->linesize[0] + x] = (x + y + index * 3) & 0xff;
+    }
+  }
+  for (y = 0; y < height / 2; y++) {
+    for (x = 0; x < width / 2; x++) {
+      frame->data[1][y * frame->linesize[1] + x] = (128 + y + index * 2) & 0xff;
+      frame->data[2][y * frame->linesize[2] + x] = (64 + x + index * 5) & 0xff;
+    }
+  }
+
+  return frame;
+}
+
+static int receive_all(EncoderContext* encoder, AVPacket* packet, int64_t* packets) {
+  int ret;
+  while ((ret = encoder_context_receive(encoder, packet)) > 0) {
+    (*packets)++;
+    av_packet_unref(packet);
+  }
+  return ret;
+}
+
+int main(int argc, char** argv) {
+  const AVCodec* codec;
+  AVCodecParameters* codecpar;
+  AVRational time_base = { 1, 30 };
+  EncoderContext* encoder;
+  AVFrame* sources[SOURCE_FRAMES];
+  AVPacket* packet;
+  CodecStats stats;
+  int64_t packets = 0;
+  int width, height, count;
+  int64_t bitrate;
+  int preset;
+  int thread_count;
+  double start;
+  double time;
+  int ret = 0;
+  int i;
+
+  if (argc < 5) {
+    fprintf(stderr, "usage: %s <codec> <width> <height> <frames> [bitrate] [preset] [thread_count]\n", argv[0]);
+    return 1;
+  }
+
+  width = atoi(argv[2]) & ~1;
+  height = atoi(argv[3]) & ~1;
+  count = atoi(argv[4]);
+  bitrate = argc > 5 ? atoll(argv[5]) : 2000000;
+  preset = argc > 6 ? atoi(argv[6]) : 0;
+  thread_count = argc > 7 ? atoi(argv[7]) : 1;
+
+  codec = avcodec_find_encoder_by_name(argv[1]);
+  if (!codec || codec->type != AVMEDIA_TYPE_VIDEO) {
+    fprintf(stderr, "not found video encoder %s\n", argv[1]);
+    return 1;
+  }
+  // encode.c 按 codec id 查找编码器，提示实际使用的编码库和指定的不一致
+  if (avcodec_find_encoder(codec->id) != codec) {
+    fprintf(stderr, "warning: %s is not the default encoder of %s, using %s\n", argv[1], avcodec_get_name(codec->id), avcodec_find_encoder(codec->id)->name);
+  }
+
+  for (i = 0; i < SOURCE_FRAMES; i++) {
+    sources[i] = create_source_frame(width, height, i);
+    if (!sources[i]) {
+      fprintf(stderr, "alloc source frame failed\n");
+      return 1;
+    }
+  }
+
+  codecpar = avcodec_parameters_alloc();
+  codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+  codecpar->codec_id = codec->id;
+  codecpar->format = AV_PIX_FMT_YUV420P;
+  codecpar->width = width;
+  codecpar->height = height;
+  codecpar->bit_rate = bitrate;
+
+  memset(&stats, 0, sizeof(stats));
+
+  encoder = encoder_create();
+  encoder_context_set_stats(encoder, &stats);
+  encoder_context_set_gop_size(encoder, 60);
+  encoder_context_set_preset(encoder, preset);
+
+  if ((ret = encoder_context_open(encoder, codecpar, &time_base, thread_count, NULL)) < 0) {
+    fprintf(stderr, "open encoder failed: %s\n", av_err2str(ret));
+    goto end;
+  }
+
+  packet = av_packet_alloc();
+
+  start = bench_now();
+
+  for (i = 0; i < count; i++) {
+    AVFrame* frame = sources[i % SOURCE_FRAMES];
+    frame->pts = i;
+    if ((ret = encoder_context_encode(encoder, frame)) < 0) {
+      break;
+    }
+    if ((ret = receive_all(encoder, packet, &packets)) < 0) {
+      break;
+    }
+  }
+  if (ret >= 0 && (ret = encoder_context_flush(encoder)) >= 0) {
+    ret = receive_all(encoder, packet, &packets);
+  }
+
+  time = bench_now() - start;
+
+  av_packet_free(&packet);
+
+  if (ret >= 0) {
+    bench_report("encoder", argv[1], count, time);
+    #if ENABLE_CODEC_STATS
+    fprintf(
+      stderr,
+      "packets: %lld, bytes out: %lld, send: %.3fms, receive: %.3fms\n",
+      (long long)packets,
+      (long long)stats.bytes_out,
+      stats.send_time,
+      stats.receive_time
+    );
+    #endif
+  }
+
+end:
+  encoder_destroy(encoder);
+  avcodec_parameters_free(&codecpar);
+  for (i = 0; i < SOURCE_FRAMES; i++) {
+    av_frame_free(&sources[i]);
+  }
+
+  return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * libmedia native resampler benchmark
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/**
+ * 使用 resample.c 回放 PCM fixture，统计重采样吞吐
+ * 
+ * bench_resample <fixture.lmpcm> <sample_rate> [channels] [frame_size] [loop]
+ * 
+ * 输出为 float planar，和播放器送给 AudioWorklet 的格式一致，frames 为输入的样本数
+ */
+
+#include "./fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavutil/channel_layout.h>
+#include <libavutil/mem.h>
+#include <libavutil/samplefmt.h>
+
+struct PCMBuffer {
+  uint8_t **data;
+  int linesize;
+  int nbSamples;
+  int maxnbSamples;
+  int channels;
+  int sampleRate;
+  enum AVSampleFormat format;
+  int64_t timestamp;
+  double duration;
+};
+
+int resample_init();
+int resample_set_input_parameters(int samplerate, int nb_channels, enum AVSampleFormat format, AVChannelLayout* ch_layout);
+int resample_set_output_parameters(int samplerate, int nb_channels, enum AVSampleFormat format, AVChannelLayout* ch_layout);
+int resample_process(uint8_t **input, struct PCMBuffer* output, int nb_samples);
+int resample_destroy();
+
+int main(int argc, char** argv) {
+  FixturePCMFile fixture;
+  struct PCMBuffer output;
+  AVChannelLayout src_layout;
+  AVChannelLayout dst_layout;
+  int sample_rate;
+  int channels;
+  int frame_size;
+  int loop;
+  int64_t samples = 0;
+  char name[64];
+  double start;
+  double time;
+  int ret = 0;
+  int i;
+  int64_t pos;
+
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <fixture.lmpcm> <sample_rate> [channels] [frame_size] [loop]\n", argv[0]);
+    return 1;
+  }
+
+  if (fixture_read_pcm(argv[1], &fixture) < 0) {
+    return 1;
+  }
+
+  sample_rate = atoi(argv[2]);
+  channels = argc > 3 ? atoi(argv[3]) : fixture.channels;
+  frame_size = argc > 4 ? atoi(argv[4]) : 1024;
+  loop = argc > 5 ? atoi(argv[5]) : 1;
+
+  av_channel_layout_default(&src_layout, fixture.channels);
+  av_channel_layout_default(&dst_layout, channels);
+
+  memset(&output, 0, sizeof(output));
+
+  resample_set_input_parameters(fixture.sample_rate, fixture.channels, AV_SAMPLE_FMT_FLT, &src_layout);
+  resample_set_output_parameters(sample_rate, channels, AV_SAMPLE_FMT_FLTP, &dst_layout);
+
+  if (resample_init() < 0) {
+    fprintf(stderr, "init resampler failed\n");
+    fixture_free_pcm(&fixture);
+    return 1;
+  }
+
+  start = bench_now();
+
+  for (i = 0; i < loop && ret >= 0; i++) {
+    for (pos = 0; pos < fixture.nb_samples; pos += frame_size) {
+      int nb_samples = (int)(fixture.nb_samples - pos < frame_size ? fixture.nb_samples - pos : frame_size);
+      uint8_t* input = (uint8_t*)(fixture.data + pos * fixture.channels);
+      if ((ret = resample_process(&input, &output, nb_samples)) < 0) {
+        break;
+      }
+      samples += nb_samples;
+    }
+  }
+
+  time = bench_now() - start;
+
+  resample_destroy();
+
+  if (ret >= 0) {
+    snprintf(name, sizeof(name), "%d_%d_to_%d_%d", fixture.sample_rate, fixture.channels, sample_rate, channels);
+    bench_report("resampler", name, samples, time);
+  }
+
+  if (output.data) {
+    av_freep(&output.data[0]);
+    av_freep(&output.data);
+  }
+  fixture_free_pcm(&fixture);
+
+  return ret < 0 ? 1 : 0;
+}
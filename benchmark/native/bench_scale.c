@@ -0,0 +1,144 @@
+/*
+ * libmedia native scaler benchmark
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/**
+ * 使用 scale.c 缩放合成帧，统计缩放吞吐
+ * 
+ * bench_scale <src_width> <src_height> <dst_width> <dst_height> <frames> [src_format] [dst_format] [flags]
+ * 
+ * format 为 ffmpeg 的像素格式名字，默认 yuv420p 转 rgba，flags 默认 SWS_BILINEAR
+ */
+
+#include "./fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+
+int scale_set_input_parameters(int width, int height, int pix_fmt);
+int scale_set_output_parameters(int width, int height, int pix_fmt);
+int scale_init(int flags, int thread_count);
+int scale_process(AVFrame* src, AVFrame* dst);
+int scale_destroy();
+
+int main(int argc, char** argv) {
+  AVFrame* src;
+  AVFrame* dst;
+  enum AVPixelFormat src_format = AV_PIX_FMT_YUV420P;
+  enum AVPixelFormat dst_format = AV_PIX_FMT_RGBA;
+  int src_width, src_height, dst_width, dst_height, count;
+  int flags = SWS_BILINEAR;
+  char name[64];
+  double start;
+  double time;
+  int ret = 0;
+  int i;
+
+  if (argc < 6) {
+    fprintf(stderr, "usage: %s <src_width> <src_height> <dst_width> <dst_height> <frames> [src_format] [dst_format] [flags]\n", argv[0]);
+    return 1;
+  }
+
+  src_width = atoi(argv[1]);
+  src_height = atoi(argv[2]);
+  dst_width = atoi(argv[3]);
+  dst_height = atoi(argv[4]);
+  count = atoi(argv[5]);
+  if (argc > 6) {
+    src_format = av_get_pix_fmt(argv[6]);
+  }
+  if (argc > 7) {
+    dst_format = av_get_pix_fmt(argv[7]);
+  }
+  if (argc > 8) {
+    flags = atoi(argv[8]);
+  }
+
+  if (src_format == AV_PIX_FMT_NONE || dst_format == AV_PIX_FMT_NONE) {
+    fprintf(stderr, "invalid pixel format\n");
+    return 1;
+  }
+
+  src = av_frame_alloc();
+  src->width = src_width;
+  src->height = src_height;
+  src->format = src_format;
+  if (av_frame_get_buffer(src, 0) < 0) {
+    fprintf(stderr, "alloc source frame failed\n");
+    return 1;
+  }
+  for (i = 0; i < AV_NUM_DATA_POINTERS && src->buf[i]; i++) {
+    int j;
+    for (j = 0; j < src->buf[i]->size; j++) {
+      src->buf[i]->data[j] = (j * 7 + i * 31) & 0xff;
+    }
+  }
+
+  dst = av_frame_alloc();
+
+  scale_set_input_parameters(src_width, src_height, src_format);
+  scale_set_output_parameters(dst_width, dst_height, dst_format);
+
+  if (scale_init(flags, 1) < 0) {
+    fprintf(stderr, "init scaler failed\n");
+    ret = -1;
+    goto end;
+  }
+
+  start = bench_now();
+
+  for (i = 0; i < count; i++) {
+    if ((ret = scale_process(src, dst)) < 0) {
+      break;
+    }
+  }
+
+  time = bench_now() - start;
+
+  scale_destroy();
+
+  if (ret >= 0) {
+    snprintf(
+      name,
+      sizeof(name),
+      "%s_%dx%d_%s_%dx%d",
+      av_get_pix_fmt_name(src_format),
+      src_width,
+      src_height,
+      av_get_pix_fmt_name(dst_format),
+      dst_width,
+      dst_height
+    );
+    bench_report("scaler", name, count, time);
+  }
+
+end:
+  av_frame_free(&src);
+  av_frame_free(&dst);
+
+  return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * libmedia native stretch and pitch benchmark
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/**
+ * 使用 stretchpitch.cpp 回放 PCM fixture，统计变速变调吞吐
+ * 
+ * bench_stretchpitch <fixture.lmpcm> [tempo] [pitch] [frame_size] [loop]
+ * 
+ * frames 为输入的样本数
+ */
+
+#include "./fixture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+extern "C" {
+  void stretchpitch_init();
+  void stretchpitch_set_channels(int channels);
+  void stretchpitch_set_samplerate(int sampleRate);
+  void stretchpitch_set_tempo(double tempo);
+  void stretchpitch_set_pitch(double pitch);
+  void stretchpitch_send_samples(float* input, int nSamples);
+  int stretchpitch_receive_samples(float* output, int maxSamples);
+  void stretchpitch_flush();
+  void stretchpitch_clear();
+  void stretchpitch_destroy();
+}
+
+int main(int argc, char** argv) {
+  FixturePCMFile fixture;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <fixture.lmpcm> [tempo] [pitch] [frame_size] [loop]\n", argv[0]);
+    return 1;
+  }
+
+  if (fixture_read_pcm(argv[1], &fixture) < 0) {
+    return 1;
+  }
+
+  double tempo = argc > 2 ? atof(argv[2]) : 1.5;
+  double pitch = argc > 3 ? atof(argv[3]) : 1.0;
+  int frame_size = argc > 4 ? atoi(argv[4]) : 1024;
+  int loop = argc > 5 ? atoi(argv[5]) : 1;
+
+  std::vector<float> output(frame_size * 4 * fixture.channels);
+  int64_t samples = 0;
+  int64_t received = 0;
+
+  stretchpitch_init();
+  stretchpitch_set_channels(fixture.channels);
+  stretchpitch_set_samplerate(fixture.sample_rate);
+  stretchpitch_set_tempo(tempo);
+  stretchpitch_set_pitch(pitch);
+
+  double start = bench_now();
+
+  for (int i = 0; i < loop; i++) {
+    for (int64_t pos = 0; pos < fixture.nb_samples; pos += frame_size) {
+      int nb_samples = (int)(fixture.nb_samples - pos < frame_size ? fixture.nb_samples - pos : frame_size);
+      stretchpitch_send_samples(fixture.data + pos * fixture.channels, nb_samples);
+      int ret;
+      while ((ret = stretchpitch_receive_samples(output.data(), frame_size * 4)) > 0) {
+        received += ret;
+      }
+      samples += nb_samples;
+    }
+    stretchpitch_flush();
+    int ret;
+    while ((ret = stretchpitch_receive_samples(output.data(), frame_size * 4)) > 0) {
+      received += ret;
+    }
+    stretchpitch_clear();
+  }
+
+  double time = bench_now() - start;
+
+  stretchpitch_destroy();
+
+  char name[64];
+  snprintf(name, sizeof(name), "tempo_%.2f_pitch_%.2f_%d", tempo, pitch, fixture.channels);
+  bench_report("stretchpitch", name, samples, time);
+
+  fprintf(stderr, "received %lld samples\n", (long long)received);
+
+  fixture_free_pcm(&fixture);
+
+  return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * libmedia native benchmark fixture
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include "./fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int write_int32(FILE* file, int32_t value) {
+  return fwrite(&value, sizeof(value), 1, file) == 1 ? 0 : -1;
+}
+
+static int read_int32(FILE* file, int32_t* value) {
+  return fread(value, sizeof(*value), 1, file) == 1 ? 0 : -1;
+}
+
+int fixture_write_packet_header(FILE* file, const FixturePacketHeader* header, const uint8_t* extradata) {
+  if (write_int32(file, FIXTURE_PACKET_MAGIC) < 0 || write_int32(file, FIXTURE_VERSION) < 0) {
+    return -1;
+  }
+  if (fwrite(header, sizeof(*header), 1, file) != 1) {
+    return -1;
+  }
+  if (header->extradata_size > 0 && fwrite(extradata, header->extradata_size, 1, file) != 1) {
+    return -1;
+  }
+  return 0;
+}
+
+int fixture_write_packet(FILE* file, const FixturePacket* packet) {
+  if (write_int32(file, packet->size) < 0 || write_int32(file, packet->flags) < 0) {
+    return -1;
+  }
+  if (fwrite(&packet->pts, sizeof(packet->pts), 1, file) != 1
+    || fwrite(&packet->dts, sizeof(packet->dts), 1, file) != 1
+  ) {
+    return -1;
+  }
+  if (packet->size > 0 && fwrite(packet->data, packet->size, 1, file) != 1) {
+    return -1;
+  }
+  return 0;
+}
+
+int fixture_read_packets(const char* path, FixturePacketFile* fixture) {
+  FILE* file;
+  int32_t magic;
+  int32_t version;
+  int capacity = 0;
+  FixturePacket packet;
+
+  memset(fixture, 0, sizeof(*fixture));
+
+  file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "cannot open fixture %s\n", path);
+    return -1;
+  }
+
+  if (read_int32(file, &magic) < 0 || magic != FIXTURE_PACKET_MAGIC
+    || read_int32(file, &version) < 0 || version != FIXTURE_VERSION
+    || fread(&fixture->header, sizeof(fixture->header), 1, file) != 1
+  ) {
+    fprintf(stderr, "invalid packet fixture %s\n", path);
+    fclose(file);
+    return -1;
+  }
+
+  if (fixture->header.extradata_size > 0) {
+    fixture->extradata = calloc(1, fixture->header.extradata_size + 64);
+    if (fread(fixture->extradata, fixture->header.extradata_size, 1, file) != 1) {
+      fclose(file);
+      fixture_free_packets(fixture);
+      return -1;
+    }
+  }
+
+  while (read_int32(file, &packet.size) == 0) {
+    if (read_int32(file, &packet.flags) < 0
+      || fread(&packet.pts, sizeof(packet.pts), 1, file) != 1
+      || fread(&packet.dts, sizeof(packet.dts), 1, file) != 1
+    ) {
+      break;
+    }
+    // 解码器要求数据后面有 padding
+    packet.data = calloc(1, packet.size + 64);
+    if (packet.size > 0 && fread(packet.data, packet.size, 1, file) != 1) {
+      free(packet.data);
+      break;
+    }
+    if (fixture->nb_packets == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      fixture->packets = realloc(fixture->packets, capacity * sizeof(FixturePacket));
+    }
+    fixture->packets[fixture->nb_packets++] = packet;
+  }
+
+  fclose(file);
+  return 0;
+}
+
+void fixture_free_packets(FixturePacketFile* fixture) {
+  int i;
+  for (i = 0; i < fixture->nb_packets; i++) {
+    free(fixture->packets[i].data);
+  }
+  free(fixture->packets);
+  free(fixture->extradata);
+  memset(fixture, 0, sizeof(*fixture));
+}
+
+int fixture_write_pcm_header(FILE* file, int32_t sample_rate, int32_t channels, int64_t nb_samples) {
+  if (write_int32(file, FIXTURE_PCM_MAGIC) < 0
+    || write_int32(file, FIXTURE_VERSION) < 0
+    || write_int32(file, sample_rate) < 0
+    || write_int32(file, channels) < 0
+    || fwrite(&nb_samples, sizeof(nb_samples), 1, file) != 1
+  ) {
+    return -1;
+  }
+  return 0;
+}
+
+int fixture_read_pcm(const char* path, FixturePCMFile* fixture) {
+  FILE* file;
+  int32_t magic;
+  int32_t version;
+
+  memset(fixture, 0, sizeof(*fixture));
+
+  file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "cannot open fixture %s\n", path);
+    return -1;
+  }
+
+  if (read_int32(file, &magic) < 0 || magic != FIXTURE_PCM_MAGIC
+    || read_int32(file, &version) < 0 || version != FIXTURE_VERSION
+    || read_int32(file, &fixture->sample_rate) < 0
+    || read_int32(file, &fixture->channels) < 0
+    || fread(&fixture->nb_samples, sizeof(fixture->nb_samples), 1, file) != 1
+  ) {
+    fprintf(stderr, "invalid pcm fixture %s\n", path);
+    fclose(file);
+    return -1;
+  }
+
+  fixture->data = malloc(fixture->nb_samples * fixture->channels * sizeof(float));
+  if (!fixture->data
+    || fread(fixture->data, sizeof(float) * fixture->channels, fixture->nb_samples, file) != (size_t)fixture->nb_samples
+  ) {
+    fprintf(stderr, "pcm fixture %s truncated\n", path);
+    fclose(file);
+    fixture_free_pcm(fixture);
+    return -1;
+  }
+
+  fclose(file);
+  return 0;
+}
+
+void fixture_free_pcm(FixturePCMFile* fixture) {
+  free(fixture->data);
+  memset(fixture, 0, sizeof(*fixture));
+}
+
+double bench_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void bench_report(const char* module, const char* name, int64_t frames, double time) {
+  fprintf(
+    stdout,
+    "{\"module\":\"%s\",\"name\":\"%s\",\"target\":\"native\",\"frames\":%lld,\"time\":%.3f,\"fps\":%.2f}\n",
+    module,
+    name,
+    (long long)frames,
+    time,
+    time > 0 ? frames * 1000.0 / time : 0
+  );
+  fflush(stdout);
+}
@@ -0,0 +1,116 @@
+/*
+ * libmedia native benchmark fixture
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef __BENCH_FIXTURE_H__
+
+  #define __BENCH_FIXTURE_H__
+
+  #include <stdio.h>
+  #include <stdint.h>
+
+  #ifdef __cplusplus
+  extern "C" {
+  #endif
+
+  /**
+   * fixture 文件都是小端序，和 wasm 一致，js 侧可以直接读取同一份文件
+   * 
+   * 包 fixture（.lmpk）
+   *   header: 'LMPK' | version | FixturePacketHeader | extradata
+   *   record: int32 size | int32 flags | int64 pts | int64 dts | data
+   * 
+   * PCM fixture（.lmpcm）
+   *   header: 'LMPC' | version | int32 sample_rate | int32 channels | int64 nb_samples
+   *   data: float32 交错存储
+   */
+  #define FIXTURE_PACKET_MAGIC 0x4B504D4C
+  #define FIXTURE_PCM_MAGIC 0x43504D4C
+  #define FIXTURE_VERSION 1
+
+  typedef struct FixturePacketHeader {
+    int32_t codec_type;
+    int32_t codec_id;
+    int32_t format;
+    int32_t profile;
+    int32_t level;
+    int32_t width;
+    int32_t height;
+    int32_t sample_rate;
+    int32_t channels;
+    int32_t time_base_num;
+    int32_t time_base_den;
+    int32_t extradata_size;
+  } FixturePacketHeader;
+
+  typedef struct FixturePacket {
+    int32_t size;
+    int32_t flags;
+    int64_t pts;
+    int64_t dts;
+    uint8_t* data;
+  } FixturePacket;
+
+  typedef struct FixturePacketFile {
+    FixturePacketHeader header;
+    uint8_t* extradata;
+    FixturePacket* packets;
+    int nb_packets;
+  } FixturePacketFile;
+
+  typedef struct FixturePCMFile {
+    int32_t sample_rate;
+    int32_t channels;
+    int64_t nb_samples;
+    float* data;
+  } FixturePCMFile;
+
+  int fixture_write_packet_header(FILE* file, const FixturePacketHeader* header, const uint8_t* extradata);
+  int fixture_write_packet(FILE* file, const FixturePacket* packet);
+  /**
+   * 把整个包 fixture 读入内存，计时不包含 IO
+   */
+  int fixture_read_packets(const char* path, FixturePacketFile* fixture);
+  void fixture_free_packets(FixturePacketFile* fixture);
+
+  int fixture_write_pcm_header(FILE* file, int32_t sample_rate, int32_t channels, int64_t nb_samples);
+  int fixture_read_pcm(const char* path, FixturePCMFile* fixture);
+  void fixture_free_pcm(FixturePCMFile* fixture);
+
+  /**
+   * 单调时钟，毫秒
+   */
+  double bench_now();
+
+  /**
+   * 输出一行 json 结果，wasm 的 benchmark 使用同样的字段，方便对比
+   * 
+   * {"module":"decoder","name":"h264","target":"native","frames":1000,"time":1234.5,"fps":810.2}
+   */
+  void bench_report(const char* module, const char* name, int64_t frames, double time);
+
+  #ifdef __cplusplus
+  }
+  #endif
+#endif
@@ -0,0 +1,6 @@
+#ifndef __WASMATOMIC_H__
+
+  #define __WASMATOMIC_H__
+
+  #include <stdatomic.h>
+#endif
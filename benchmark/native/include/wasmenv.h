@@ -0,0 +1,13 @@
+#ifndef __WASMENV_H__
+
+  #define __WASMENV_H__
+
+  /**
+   * 原生构建时导出函数就是普通的 C 函数
+   */
+  #ifdef __cplusplus
+    #define EM_PORT_API(rettype) extern "C" rettype
+  #else
+    #define EM_PORT_API(rettype) rettype
+  #endif
+#endif
@@ -0,0 +1,13 @@
+#ifndef __WASMPTHREAD_H__
+
+  #define __WASMPTHREAD_H__
+
+  #include <pthread.h>
+
+  /**
+   * 原生平台总是支持线程
+   */
+  static inline int wasm_pthread_support() {
+    return 1;
+  }
+#endif
@@ -0,0 +1,289 @@
+/*
+ * libmedia native benchmark fixture recorder
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/**
+ * 从媒体文件录制 benchmark 使用的 fixture
+ * 
+ * record <input> <output.lmpk> video|audio
+ *   把对应流的压缩包原样写入包 fixture，用于 bench_decode
+ * 
+ * record <input> <output.lmpcm> pcm
+ *   解码第一个音频流并转为 float 交错 PCM，用于 bench_resample 和 bench_stretchpitch
+ */
+
+#include "./fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+#include <libavutil/opt.h>
+
+static int record_packets(AVFormatContext* format, int stream_index, const char* output) {
+  AVStream* stream = format->streams[stream_index];
+  AVCodecParameters* codecpar = stream->codecpar;
+  FixturePacketHeader header;
+  FixturePacket record;
+  AVPacket* packet;
+  FILE* file;
+  int count = 0;
+  int ret;
+
+  file = fopen(output, "wb");
+  if (!file) {
+    fprintf(stderr, "cannot open %s\n", output);
+    return AVERROR(EIO);
+  }
+
+  memset(&header, 0, sizeof(header));
+  header.codec_type = codecpar->codec_type;
+  header.codec_id = codecpar->codec_id;
+  header.format = codecpar->format;
+  header.profile = codecpar->profile;
+  header.level = codecpar->level;
+  header.width = codecpar->width;
+  header.height = codecpar->height;
+  header.sample_rate = codecpar->sample_rate;
+  header.channels = codecpar->ch_layout.nb_channels;
+  header.time_base_num = stream->time_base.num;
+  header.time_base_den = stream->time_base.den;
+  header.extradata_size = codecpar->extradata_size;
+
+  if (fixture_write_packet_header(file, &header, codecpar->extradata) < 0) {
+    fclose(file);
+    return AVERROR(EIO);
+  }
+
+  packet = av_packet_alloc();
+
+  while ((ret = av_read_frame(format, packet)) >= 0) {
+    if (packet->stream_index == stream_index) {
+      record.size = packet->size;
+      record.flags = packet->flags;
+      record.pts = packet->pts;
+      record.dts = packet->dts;
+      record.data = packet->data;
+      if (fixture_write_packet(file, &record) < 0) {
+        av_packet_unref(packet);
+        ret = AVERROR(EIO);
+        break;
+      }
+      count++;
+    }
+    av_packet_unref(packet);
+  }
+
+  av_packet_free(&packet);
+  fclose(file);
+
+  if (ret < 0 && ret != AVERROR_EOF) {
+    return ret;
+  }
+
+  fprintf(stderr, "recorded %d packets of %s\n", count, avcodec_get_name(codecpar->codec_id));
+
+  return 0;
+}
+
+static int write_pcm(FILE* file, SwrContext* swr, AVFrame* frame, int channels, int64_t* nb_samples) {
+  uint8_t* buffer = NULL;
+  int max = frame ? swr_get_out_samples(swr, frame->nb_samples) : swr_get_out_samples(swr, 0);
+  int ret;
+
+  if (max <= 0) {
+    return 0;
+  }
+
+  buffer = malloc(max * channels * sizeof(float));
+  if (!buffer) {
+    return AVERROR(ENOMEM);
+  }
+
+  ret = swr_convert(
+    swr,
+    &buffer,
+    max,
+    frame ? (const uint8_t**)frame->extended_data : NULL,
+    frame ? frame->nb_samples : 0
+  );
+
+  if (ret > 0) {
+    fwrite(buffer, sizeof(float) * channels, ret, file);
+    *nb_samples += ret;
+  }
+
+  free(buffer);
+
+  return ret < 0 ? ret : 0;
+}
+
+static int record_pcm(AVFormatContext* format, int stream_index, const char* output) {
+  AVStream* stream = format->streams[stream_index];
+  const AVCodec* codec;
+  AVCodecContext* dec_ctx = NULL;
+  SwrContext* swr = NULL;
+  AVPacket* packet = NULL;
+  AVFrame* frame = NULL;
+  FILE* file = NULL;
+  int64_t nb_samples = 0;
+  int channels;
+  int ret;
+
+  codec = avcodec_find_decoder(stream->codecpar->codec_id);
+  if (!codec) {
+    fprintf(stderr, "not found decoder for %s\n", avcodec_get_name(stream->codecpar->codec_id));
+    return AVERROR_DECODER_NOT_FOUND;
+  }
+
+  dec_ctx = avcodec_alloc_context3(codec);
+  if (!dec_ctx) {
+    return AVERROR(ENOMEM);
+  }
+  if ((ret = avcodec_parameters_to_context(dec_ctx, stream->codecpar)) < 0
+    || (ret = avcodec_open2(dec_ctx, codec, NULL)) < 0
+  ) {
+    goto end;
+  }
+
+  channels = dec_ctx->ch_layout.nb_channels;
+
+  ret = swr_alloc_set_opts2(
+    &swr,
+    &dec_ctx->ch_layout,
+    AV_SAMPLE_FMT_FLT,
+    dec_ctx->sample_rate,
+    &dec_ctx->ch_layout,
+    dec_ctx->sample_fmt,
+    dec_ctx->sample_rate,
+    0,
+    NULL
+  );
+  if (ret < 0 || (ret = swr_init(swr)) < 0) {
+    goto end;
+  }
+
+  file = fopen(output, "wb");
+  if (!file) {
+    ret = AVERROR(EIO);
+    goto end;
+  }
+
+  // 先写入占位的头，结束之后回填样本数
+  fixture_write_pcm_header(file, dec_ctx->sample_rate, channels, 0);
+
+  packet = av_packet_alloc();
+  frame = av_frame_alloc();
+
+  while (1) {
+    ret = av_read_frame(format, packet);
+    if (ret >= 0 && packet->stream_index != stream_index) {
+      av_packet_unref(packet);
+      continue;
+    }
+    // 读取结束之后发送空包刷出解码器缓存
+    ret = avcodec_send_packet(dec_ctx, ret >= 0 ? packet : NULL);
+    av_packet_unref(packet);
+    if (ret < 0 && ret != AVERROR_EOF) {
+      break;
+    }
+    while ((ret = avcodec_receive_frame(dec_ctx, frame)) >= 0) {
+      ret = write_pcm(file, swr, frame, channels, &nb_samples);
+      av_frame_unref(frame);
+      if (ret < 0) {
+        goto end;
+      }
+    }
+    if (ret == AVERROR_EOF) {
+      ret = write_pcm(file, swr, NULL, channels, &nb_samples);
+      break;
+    }
+    if (ret != AVERROR(EAGAIN)) {
+      break;
+    }
+  }
+
+  if (ret >= 0) {
+    fseek(file, 0, SEEK_SET);
+    fixture_write_pcm_header(file, dec_ctx->sample_rate, channels, nb_samples);
+    fprintf(stderr, "recorded %lld samples, %d channels, %d Hz\n", (long long)nb_samples, channels, dec_ctx->sample_rate);
+  }
+
+end:
+  if (file) {
+    fclose(file);
+  }
+  av_frame_free(&frame);
+  av_packet_free(&packet);
+  swr_free(&swr);
+  avcodec_free_context(&dec_ctx);
+  return ret;
+}
+
+int main(int argc, char** argv) {
+  AVFormatContext* format = NULL;
+  enum AVMediaType type;
+  int stream_index;
+  int ret;
+
+  if (argc < 4) {
+    fprintf(stderr, "usage: %s <input> <output> video|audio|pcm\n", argv[0]);
+    return 1;
+  }
+
+  type = strcmp(argv[3], "video") == 0 ? AVMEDIA_TYPE_VIDEO : AVMEDIA_TYPE_AUDIO;
+
+  if ((ret = avformat_open_input(&format, argv[1], NULL, NULL)) < 0) {
+    fprintf(stderr, "cannot open input %s: %s\n", argv[1], av_err2str(ret));
+    return 1;
+  }
+  if ((ret = avformat_find_stream_info(format, NULL)) < 0) {
+    avformat_close_input(&format);
+    return 1;
+  }
+
+  stream_index = av_find_best_stream(format, type, -1, -1, NULL, 0);
+  if (stream_index < 0) {
+    fprintf(stderr, "not found %s stream in %s\n", argv[3], argv[1]);
+    avformat_close_input(&format);
+    return 1;
+  }
+
+  if (strcmp(argv[3], "pcm") == 0) {
+    ret = record_pcm(format, stream_index, argv[2]);
+  }
+  else {
+    ret = record_packets(format, stream_index, argv[2]);
+  }
+
+  avformat_close_input(&format);
+
+  if (ret < 0) {
+    fprintf(stderr, "record failed: %s\n", av_err2str(ret));
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# 运行所有 native benchmark，每一项输出一行 json
+#
+# run.sh <fixtures dir>
+#
+# fixtures 目录中的 *.lmpk 全部用于解码测试，第一个 *.lmpcm 用于重采样和变速变调测试
+# fixture 使用 dist/native/record 从媒体文件录制
+
+NOW_PATH=$(cd $(dirname $0); pwd)
+
+PROJECT_ROOT_PATH=$(cd $NOW_PATH/../../; pwd)
+
+BIN_PATH=$PROJECT_ROOT_PATH/dist/native
+
+FIXTURE_PATH=$1
+
+if ! [ -n "$FIXTURE_PATH" ]; then
+  echo "usage: run.sh <fixtures dir>"
+  exit 1
+fi
+
+for fixture in $FIXTURE_PATH/*.lmpk; do
+  [ -e "$fixture" ] || continue
+  $BIN_PATH/bench_decode $fixture 1 3
+done
+
+for encoder in libx264 libx265 libvpx libvpx-vp9 libaom-av1; do
+  $BIN_PATH/bench_encode $encoder 1280 720 120 2000000 1 1 2>/dev/null
+done
+
+$BIN_PATH/bench_scale 1920 1080 1280 720 300 yuv420p yuv420p
+$BIN_PATH/bench_scale 1920 1080 1920 1080 300 yuv420p rgba
+$BIN_PATH/bench_scale 1920 1080 160 90 300 yuv420p rgba
+
+for pcm in $FIXTURE_PATH/*.lmpcm; do
+  [ -e "$pcm" ] || continue
+  $BIN_PATH/bench_resample $pcm 48000 2 1024 10
+  $BIN_PATH/bench_resample $pcm 44100 1 1024 10
+  $BIN_PATH/bench_stretchpitch $pcm 1.5 1.0 1024 3
+  $BIN_PATH/bench_stretchpitch $pcm 1.0 1.2 1024 3
+  break
+done
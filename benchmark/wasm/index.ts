@@ -0,0 +1,741 @@
+/*
+ * libmedia wasm benchmark
+ * 
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ * 
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ */
+
+/**
+ * 对比 wasm 各个版本（基础、atomic、simd）的吞吐
+ * 
+ * 读取和 benchmark/native 相同的 fixture（dist/native/record 录制），按相同的格式每项输出一行 json，
+ * target 字段为 wasm-baseline、wasm-atomic、wasm-simd，可以和 native 的结果放在一起对比
+ * 
+ * 需要在浏览器中运行，wasm 目录中需要有对应版本的产物（build-wasm-all.sh 会全部编译）
+ */
+
+import {
+  type WebAssemblyResource,
+  WebAssemblyRunner,
+  compileResource,
+  memcpyFromUint8Array
+} from '@libmedia/cheap'
+
+import {
+  type AVCodecParameters,
+  type AVFrame,
+  type AVPacket,
+  type AVPCMBuffer,
+  type WasmVariant,
+  AVCodecID,
+  AVMediaType,
+  AVPixelFormat,
+  AVSampleFormat,
+  AVChannelOrder,
+  getWasmUrl,
+  avMalloc,
+  avMallocz,
+  avFree,
+  createAVPacket,
+  destroyAVPacket,
+  addAVPacketData,
+  createAVFrame,
+  destroyAVFrame,
+  getVideoBuffer,
+  resetCodecParameters,
+  freeCodecParameters,
+  hasWasmExport
+} from '@libmedia/avutil'
+
+import {
+  WasmVideoDecoder,
+  WasmAudioDecoder,
+  WasmVideoEncoder
+} from '@libmedia/avcodec'
+
+import { VideoScaler } from '@libmedia/videoscale'
+import { Resampler } from '@libmedia/audioresample'
+import { StretchPitcher } from '@libmedia/audiostretchpitch'
+
+const FIXTURE_PACKET_MAGIC = 0x4B504D4C
+const FIXTURE_PCM_MAGIC = 0x43504D4C
+
+// 合成帧的数量，编码和缩放时循环使用
+const SOURCE_FRAMES = 60
+
+export interface PacketFixture {
+  codecType: AVMediaType
+  codecId: AVCodecID
+  format: int32
+  profile: int32
+  level: int32
+  width: int32
+  height: int32
+  sampleRate: int32
+  channels: int32
+  timeBase: { num: int32, den: int32 }
+  extradata: Uint8Array
+  packets: {
+    flags: int32
+    pts: int64
+    dts: int64
+    data: Uint8Array
+  }[]
+}
+
+export interface PCMFixture {
+  sampleRate: int32
+  channels: int32
+  nbSamples: int32
+  /**
+   * float32 交错存储
+   */
+  data: Uint8Array
+}
+
+export interface WasmBenchmarkOptions {
+  wasmBaseUrl: string
+  /**
+   * 包 fixture（.lmpk）
+   */
+  packetFixtures?: ArrayBuffer[]
+  /**
+   * PCM fixture（.lmpcm）
+   */
+  pcmFixture?: ArrayBuffer
+  /**
+   * 要测试的视频编码器，默认 h264
+   */
+  encoders?: AVCodecID[]
+  /**
+   * 对比的版本，默认基础版本和 simd 版本
+   */
+  variants?: WasmVariant[]
+  loop?: number
+}
+
+export function parsePacketFixture(buffer: ArrayBuffer): PacketFixture {
+  const view = new DataView(buffer)
+
+  if (view.getInt32(0, true) !== FIXTURE_PACKET_MAGIC) {
+    throw new Error('invalid packet fixture')
+  }
+
+  const fixture: PacketFixture = {
+    codecType: view.getInt32(8, true),
+    codecId: view.getInt32(12, true),
+    format: view.getInt32(16, true),
+    profile: view.getInt32(20, true),
+    level: view.getInt32(24, true),
+    width: view.getInt32(28, true),
+    height: view.getInt32(32, true),
+    sampleRate: view.getInt32(36, true),
+    channels: view.getInt32(40, true),
+    timeBase: {
+      num: view.getInt32(44, true),
+      den: view.getInt32(48, true)
+    },
+    extradata: null,
+    packets: []
+  }
+
+  const extradataSize = view.getInt32(52, true)
+  let pos = 56
+  fixture.extradata = new Uint8Array(buffer, pos, extradataSize)
+  pos += extradataSize
+
+  while (pos + 24 <= buffer.byteLength) {
+    const size = view.getInt32(pos, true)
+    fixture.packets.push({
+      flags: view.getInt32(pos + 4, true),
+      pts: view.getBigInt64(pos + 8, true),
+      dts: view.getBigInt64(pos + 16, true),
+      data: new Uint8Array(buffer, pos + 24, size)
+    })
+    pos += 24 + size
+  }
+
+  return fixture
+}
+
+export function parsePCMFixture(buffer: ArrayBuffer): PCMFixture {
+  const view = new DataView(buffer)
+
+  if (view.getInt32(0, true) !== FIXTURE_PCM_MAGIC) {
+    throw new Error('invalid pcm fixture')
+  }
+
+  const channels = view.getInt32(12, true)
+  const nbSamples = Number(view.getBigInt64(16, true))
+
+  return {
+    sampleRate: view.getInt32(8, true),
+    channels,
+    nbSamples,
+    data: new Uint8Array(buffer, 24, nbSamples * channels * 4)
+  }
+}
+
+function report(module: string, name: string, variant: WasmVariant, frames: number, time: number, extra?: Record<string, number>) {
+  console.log(JSON.stringify({
+    module,
+    name,
+    target: `wasm-${variant}`,
+    frames,
+    time: +time.toFixed(3),
+    fps: time > 0 ? +(frames * 1000 / time).toFixed(2) : 0,
+    ...extra
+  }))
+}
+
+/**
+ * 统计 fn 执行期间 js 到 wasm 的同步调用次数
+ */
+async function countInvoke(fn: () => Promise<void>) {
+  const invoke = WebAssemblyRunner.prototype.invoke
+  let calls = 0
+  WebAssemblyRunner.prototype.invoke = function (...args: any[]) {
+    calls++
+    return invoke.apply(this, args)
+  }
+  try {
+    await fn()
+  }
+  finally {
+    WebAssemblyRunner.prototype.invoke = invoke
+  }
+  return calls
+}
+
+function copyToWasm(data: Uint8Array) {
+  const p = avMalloc(data.length)
+  memcpyFromUint8Array(p, data.length, data)
+  return p
+}
+
+async function compile(url: string): Promise<WebAssemblyResource> {
+  return compileResource({
+    source: url
+  })
+}
+
+function createDecoderInput(fixture: PacketFixture) {
+  const codecpar = reinterpret_cast<pointer<AVCodecParameters>>(avMallocz(sizeof(AVCodecParameters)))
+  resetCodecParameters(codecpar)
+  codecpar.codecType = fixture.codecType
+  codecpar.codecId = fixture.codecId
+  codecpar.format = fixture.format
+  codecpar.profile = fixture.profile
+  codecpar.level = fixture.level
+  codecpar.width = fixture.width
+  codecpar.height = fixture.height
+  codecpar.sampleRate = fixture.sampleRate
+  if (fixture.channels) {
+    codecpar.chLayout.order = AVChannelOrder.AV_CHANNEL_ORDER_UNSPEC
+    codecpar.chLayout.nbChannels = fixture.channels
+  }
+  if (fixture.extradata.length) {
+    codecpar.extradata = copyToWasm(fixture.extradata)
+    codecpar.extradataSize = fixture.extradata.length
+  }
+
+  // 包在计时之前全部拷贝到 wasm 内存中，decode 不会消耗包，可以重复送入
+  const avpackets: pointer<AVPacket>[] = fixture.packets.map((packet) => {
+    const avpacket = createAVPacket()
+    addAVPacketData(avpacket, copyToWasm(packet.data), packet.data.length)
+    avpacket.flags = packet.flags
+    avpacket.pts = packet.pts
+    avpacket.dts = packet.dts
+    avpacket.timeBase.num = fixture.timeBase.num
+    avpacket.timeBase.den = fixture.timeBase.den
+    return avpacket
+  })
+
+  return {
+    codecpar,
+    avpackets
+  }
+}
+
+function destroyDecoderInput(codecpar: pointer<AVCodecParameters>, avpackets: pointer<AVPacket>[]) {
+  avpackets.forEach((avpacket) => {
+    destroyAVPacket(avpacket)
+  })
+  freeCodecParameters(codecpar)
+}
+
+export async function benchmarkDecoder(wasmBaseUrl: string, fixture: PacketFixture, variant: WasmVariant, loop: number = 1) {
+  const url = getWasmUrl(wasmBaseUrl, 'decoder', fixture.codecId, variant)
+  if (!url) {
+    return
+  }
+
+  const resource = await compile(url)
+
+  const { codecpar, avpackets } = createDecoderInput(fixture)
+
+  let frames = 0
+  let time = 0
+  const onReceiveAVFrame = (frame: pointer<AVFrame>) => {
+    frames++
+    destroyAVFrame(frame)
+  }
+
+  for (let i = 0; i < loop; i++) {
+    const decoder = fixture.codecType === AVMediaType.AVMEDIA_TYPE_VIDEO
+      ? new WasmVideoDecoder({
+        resource,
+        onReceiveAVFrame
+      })
+      : new WasmAudioDecoder({
+        resource,
+        onReceiveAVFrame
+      })
+
+    const ret = decoder instanceof WasmVideoDecoder
+      ? await decoder.open(codecpar, 1)
+      : await decoder.open(codecpar)
+
+    if (ret < 0) {
+      console.error(`open decoder ${url} failed, ret: ${ret}`)
+      decoder.close()
+      break
+    }
+
+    const start = performance.now()
+
+    for (let j = 0; j < avpackets.length; j++) {
+      if (decoder.decode(avpackets[j]) < 0) {
+        break
+      }
+    }
+    await decoder.flush()
+
+    time += performance.now() - start
+
+    decoder.close()
+  }
+
+  report('decoder', getCodecName(fixture.codecId), variant, frames, time)
+
+  destroyDecoderInput(codecpar, avpackets)
+}
+
+/**
+ * 对比逐个 decode 和 decodeBatch 的 js 到 wasm 调用次数和吞吐
+ * 
+ * 输出两行，name 后缀为 _decode 和 _batch{batchSize}，calls 为解码过程中的 wasm 调用次数
+ */
+export async function benchmarkDecodeBatch(
+  wasmBaseUrl: string,
+  fixture: PacketFixture,
+  variant: WasmVariant,
+  batchSize: int32 = 8,
+  loop: number = 1
+) {
+  const url = getWasmUrl(wasmBaseUrl, 'decoder', fixture.codecId, variant)
+  if (!url) {
+    return
+  }
+
+  const resource = await compile(url)
+
+  if (!hasWasmExport(resource, 'decoder_decode_batch')) {
+    console.warn(`decoder ${url} not support decode_batch, skip`)
+    return
+  }
+
+  const { codecpar, avpackets } = createDecoderInput(fixture)
+
+  for (const batch of [false, true]) {
+    let frames = 0
+    let time = 0
+    let calls = 0
+    const onReceiveAVFrame = (frame: pointer<AVFrame>) => {
+      frames++
+      destroyAVFrame(frame)
+    }
+
+    for (let i = 0; i < loop; i++) {
+      const decoder = fixture.codecType === AVMediaType.AVMEDIA_TYPE_VIDEO
+        ? new WasmVideoDecoder({
+          resource,
+          onReceiveAVFrame
+        })
+        : new WasmAudioDecoder({
+          resource,
+          onReceiveAVFrame
+        })
+
+      const ret = decoder instanceof WasmVideoDecoder
+        ? await decoder.open(codecpar, 1)
+        : await decoder.open(codecpar)
+
+      if (ret < 0) {
+        console.error(`open decoder ${url} failed, ret: ${ret}`)
+        decoder.close()
+        break
+      }
+
+      const start = performance.now()
+
+      calls += await countInvoke(async () => {
+        if (batch) {
+          for (let j = 0; j < avpackets.length; j += batchSize) {
+            if (decoder.decodeBatch(avpackets.slice(j, j + batchSize)) < 0) {
+              break
+            }
+          }
+        }
+        else {
+          for (let j = 0; j < avpackets.length; j++) {
+            if (decoder.decode(avpackets[j]) < 0) {
+              break
+            }
+          }
+        }
+        await decoder.flush()
+      })
+
+      time += performance.now() - start
+
+      decoder.close()
+    }
+
+    report(
+      'decoder',
+      `${getCodecName(fixture.codecId)}_${batch ? `batch${batchSize}` : 'decode'}`,
+      variant,
+      frames,
+      time,
+      {
+        calls
+      }
+    )
+  }
+
+  destroyDecoderInput(codecpar, avpackets)
+}
+
+function createSourceFrame(width: int32, height: int32, format: AVPixelFormat, index: int32) {
+  const frame = createAVFrame()
+  frame.width = width
+  frame.height = height
+  frame.format = format
+  getVideoBuffer(frame)
+
+  for (let i = 0; i < 3 && frame.data[i]; i++) {
+    const planeHeight = i ? height >>> 1 : height
+    const size = frame.linesize[i] * planeHeight
+    const pattern = new Uint8Array(size)
+    for (let j = 0; j < size; j++) {
+      pattern[j] = (j + index * (i + 3)) & 0xff
+    }
+    memcpyFromUint8Array(frame.data[i], size, pattern)
+  }
+  return frame
+}
+
+export async function benchmarkEncoder(
+  wasmBaseUrl: string,
+  codecId: AVCodecID,
+  variant: WasmVariant,
+  width: int32 = 1280,
+  height: int32 = 720,
+  count: int32 = 120
+) {
+  const url = getWasmUrl(wasmBaseUrl, 'encoder', codecId, variant)
+  if (!url) {
+    return
+  }
+
+  const resource = await compile(url)
+
+  const sources: pointer<AVFrame>[] = []
+  for (let i = 0; i < SOURCE_FRAMES; i++) {
+    sources.push(createSourceFrame(width, height, AVPixelFormat.AV_PIX_FMT_YUV420P, i))
+  }
+
+  const codecpar = reinterpret_cast<pointer<AVCodecParameters>>(avMallocz(sizeof(AVCodecParameters)))
+  resetCodecParameters(codecpar)
+  codecpar.codecType = AVMediaType.AVMEDIA_TYPE_VIDEO
+  codecpar.codecId = codecId
+  codecpar.format = AVPixelFormat.AV_PIX_FMT_YUV420P
+  codecpar.width = width
+  codecpar.height = height
+  codecpar.bitrate = 2000000n
+
+  let packets = 0
+  const encoder = new WasmVideoEncoder({
+    resource,
+    onReceiveAVPacket() {
+      packets++
+    }
+  })
+
+  const ret = await encoder.open(codecpar, { num: 1, den: 30 }, 1)
+
+  if (ret >= 0) {
+    const start = performance.now()
+    for (let i = 0; i < count; i++) {
+      const frame = sources[i % SOURCE_FRAMES]
+      frame.pts = static_cast<int64>(i)
+      frame.timeBase.num = 1
+      frame.timeBase.den = 30
+      if (encoder.encode(frame, i % 60 === 0) < 0) {
+        break
+      }
+    }
+    await encoder.flush()
+    report('encoder', getCodecName(codecId), variant, count, performance.now() - start)
+  }
+  else {
+    console.error(`open encoder ${url} failed, ret: ${ret}`)
+  }
+
+  encoder.close()
+  sources.forEach((frame) => {
+    destroyAVFrame(frame)
+  })
+  freeCodecParameters(codecpar)
+}
+
+export async function benchmarkScaler(
+  wasmBaseUrl: string,
+  variant: WasmVariant,
+  input: { width: int32, height: int32, format: AVPixelFormat },
+  output: { width: int32, height: int32, format: AVPixelFormat },
+  count: int32 = 300
+) {
+  const scaler = new VideoScaler({
+    resource: await compile(getWasmUrl(wasmBaseUrl, 'scaler', undefined, variant))
+  })
+
+  const src = createSourceFrame(input.width, input.height, input.format, 0)
+  const dst = createAVFrame()
+
+  if (await scaler.open(input, output) >= 0) {
+    const start = performance.now()
+    for (let i = 0; i < count; i++) {
+      if (scaler.scale(src, dst) < 0) {
+        break
+      }
+    }
+    report(
+      'scaler',
+      `${input.format}_${input.width}x${input.height}_${output.format}_${output.width}x${output.height}`,
+      variant,
+      count,
+      performance.now() - start
+    )
+  }
+
+  scaler.close()
+  destroyAVFrame(src)
+  destroyAVFrame(dst)
+}
+
+export async function benchmarkResampler(
+  wasmBaseUrl: string,
+  variant: WasmVariant,
+  fixture: PCMFixture,
+  sampleRate: int32,
+  channels: int32,
+  frameSize: int32 = 1024,
+  loop: number = 10
+) {
+  const resampler = new Resampler({
+    resource: await compile(getWasmUrl(wasmBaseUrl, 'resampler', undefined, variant))
+  })
+
+  const data = copyToWasm(fixture.data)
+  const input = reinterpret_cast<pointer<pointer<uint8>>>(avMalloc(sizeof(pointer)))
+  const output = reinterpret_cast<pointer<AVPCMBuffer>>(avMallocz(sizeof(AVPCMBuffer)))
+
+  const ret = await resampler.open(
+    {
+      channels: fixture.channels,
+      sampleRate: fixture.sampleRate,
+      format: AVSampleFormat.AV_SAMPLE_FMT_FLT
+    },
+    {
+      channels,
+      sampleRate,
+      format: AVSampleFormat.AV_SAMPLE_FMT_FLTP
+    }
+  )
+
+  if (ret >= 0) {
+    let samples = 0
+    const start = performance.now()
+    for (let i = 0; i < loop; i++) {
+      for (let pos = 0; pos < fixture.nbSamples; pos += frameSize) {
+        const nbSamples = Math.min(frameSize, fixture.nbSamples - pos)
+        accessof(input) <- reinterpret_cast<pointer<uint8>>(data + pos * fixture.channels * 4)
+        if (resampler.resample(input, output, nbSamples) < 0) {
+          break
+        }
+        samples += nbSamples
+      }
+    }
+    report(
+      'resampler',
+      `${fixture.sampleRate}_${fixture.channels}_to_${sampleRate}_${channels}`,
+      variant,
+      samples,
+      performance.now() - start
+    )
+  }
+
+  resampler.close()
+  if (output.data) {
+    avFree(output.data[0])
+    avFree(output.data)
+  }
+  avFree(output)
+  avFree(input)
+  avFree(data)
+}
+
+export async function benchmarkStretchPitcher(
+  wasmBaseUrl: string,
+  variant: WasmVariant,
+  fixture: PCMFixture,
+  tempo: double,
+  pitch: double,
+  frameSize: int32 = 1024,
+  loop: number = 3
+) {
+  const stretchpitcher = new StretchPitcher({
+    resource: await compile(getWasmUrl(wasmBaseUrl, 'stretchpitcher', undefined, variant))
+  })
+
+  const data = copyToWasm(fixture.data)
+  const output = reinterpret_cast<pointer<float>>(avMalloc(frameSize * 4 * fixture.channels * sizeof(float)))
+
+  await stretchpitcher.open({
+    channels: fixture.channels,
+    sampleRate: fixture.sampleRate
+  })
+  stretchpitcher.setTempo(tempo)
+  stretchpitcher.setPitch(pitch)
+
+  let samples = 0
+  const start = performance.now()
+  for (let i = 0; i < loop; i++) {
+    for (let pos = 0; pos < fixture.nbSamples; pos += frameSize) {
+      const nbSamples = Math.min(frameSize, fixture.nbSamples - pos)
+      stretchpitcher.sendSamples(reinterpret_cast<pointer<float>>(data + pos * fixture.channels * 4), nbSamples)
+      while (stretchpitcher.receiveSamples(output, frameSize * 4) > 0) {}
+      samples += nbSamples
+    }
+    stretchpitcher.flush()
+    while (stretchpitcher.receiveSamples(output, frameSize * 4) > 0) {}
+    stretchpitcher.clear()
+  }
+  report(
+    'stretchpitch',
+    `tempo_${tempo.toFixed(2)}_pitch_${pitch.toFixed(2)}_${fixture.channels}`,
+    variant,
+    samples,
+    performance.now() - start
+  )
+
+  stretchpitcher.close()
+  avFree(output)
+  avFree(data)
+}
+
+function getCodecName(codecId: AVCodecID) {
+  switch (codecId) {
+    case AVCodecID.AV_CODEC_ID_H264:
+      return 'h264'
+    case AVCodecID.AV_CODEC_ID_HEVC:
+      return 'hevc'
+    case AVCodecID.AV_CODEC_ID_VVC:
+      return 'vvc'
+    case AVCodecID.AV_CODEC_ID_AV1:
+      return 'av1'
+    case AVCodecID.AV_CODEC_ID_VP8:
+      return 'vp8'
+    case AVCodecID.AV_CODEC_ID_VP9:
+      return 'vp9'
+    case AVCodecID.AV_CODEC_ID_MPEG4:
+      return 'mpeg4'
+    case AVCodecID.AV_CODEC_ID_AAC:
+      return 'aac'
+    case AVCodecID.AV_CODEC_ID_MP3:
+      return 'mp3'
+    case AVCodecID.AV_CODEC_ID_OPUS:
+      return 'opus'
+    case AVCodecID.AV_CODEC_ID_FLAC:
+      return 'flac'
+    default:
+      return `${codecId}`
+  }
+}
+
+/**
+ * 依次运行所有模块在各个版本上的 benchmark
+ */
+export async function benchmarkWasm(options: WasmBenchmarkOptions) {
+  const variants = options.variants ?? ['baseline', 'simd']
+  const loop = options.loop ?? 3
+
+  const packetFixtures = (options.packetFixtures ?? []).map(parsePacketFixture)
+  const pcmFixture = options.pcmFixture ? parsePCMFixture(options.pcmFixture) : null
+
+  for (const variant of variants) {
+    for (const fixture of packetFixtures) {
+      await benchmarkDecoder(options.wasmBaseUrl, fixture, variant, loop)
+      await benchmarkDecodeBatch(options.wasmBaseUrl, fixture, variant, 8, loop)
+    }
+    for (const codecId of (options.encoders ?? [AVCodecID.AV_CODEC_ID_H264])) {
+      await benchmarkEncoder(options.wasmBaseUrl, codecId, variant)
+    }
+
+    await benchmarkScaler(
+      options.wasmBaseUrl,
+      variant,
+      { width: 1920, height: 1080, format: AVPixelFormat.AV_PIX_FMT_YUV420P },
+      { width: 1280, height: 720, format: AVPixelFormat.AV_PIX_FMT_YUV420P }
+    )
+    await benchmarkScaler(
+      options.wasmBaseUrl,
+      variant,
+      { width: 1920, height: 1080, format: AVPixelFormat.AV_PIX_FMT_YUV420P },
+      { width: 1920, height: 1080, format: AVPixelFormat.AV_PIX_FMT_RGBA }
+    )
+    await benchmarkScaler(
+      options.wasmBaseUrl,
+      variant,
+      { width: 1920, height: 1080, format: AVPixelFormat.AV_PIX_FMT_YUV420P },
+      { width: 160, height: 90, format: AVPixelFormat.AV_PIX_FMT_RGBA }
+    )
+
+    if (pcmFixture) {
+      await benchmarkResampler(options.wasmBaseUrl, variant, pcmFixture, 48000, 2)
+      await benchmarkResampler(options.wasmBaseUrl, variant, pcmFixture, 44100, 1)
+      await benchmarkStretchPitcher(options.wasmBaseUrl, variant, pcmFixture, 1.5, 1.0)
+      await benchmarkStretchPitcher(options.wasmBaseUrl, variant, pcmFixture, 1.0, 1.2)
+    }
+  }
+}
@@ -0,0 +1,102 @@
+#!/bin/bash
+
+# 使用宿主机的 gcc 编译 C 内核和 benchmark，用于 perf 分析和 native / wasm / wasm-simd 的吞吐对比
+#
+# ffmpeg 默认通过 pkg-config 查找系统库，也可以通过 FFMPEG_NATIVE_PATH 指定自己编译的 ffmpeg 安装目录
+# 源码和 wasm 构建是同一份，wasmenv.h 等 cheap 头文件使用 benchmark/native/include 中的宿主机实现
+
+echo "===== start native build====="
+
+NOW_PATH=$(cd $(dirname $0); pwd)
+
+PROJECT_ROOT_PATH=$(cd $NOW_PATH/../; pwd)
+
+PROJECT_SRC_PATH=$PROJECT_ROOT_PATH/packages
+
+PROJECT_OUTPUT_PATH=$PROJECT_ROOT_PATH/dist/native
+
+BENCHMARK_PATH=$PROJECT_ROOT_PATH/benchmark/native
+
+INCLUDE_PATH=$PROJECT_OUTPUT_PATH/include
+
+CC=${CC:-gcc}
+CXX=${CXX:-g++}
+
+if [ -n "$FFMPEG_NATIVE_PATH" ]; then
+  FFMPEG_CFLAGS="-I$FFMPEG_NATIVE_PATH/include"
+  FFMPEG_LIBS="-L$FFMPEG_NATIVE_PATH/lib -Wl,-rpath,$FFMPEG_NATIVE_PATH/lib -lavformat -lavcodec -lswscale -lswresample -lavutil"
+else
+  FFMPEG_CFLAGS=`pkg-config --cflags libavformat libavcodec libswscale libswresample libavutil`
+  FFMPEG_LIBS=`pkg-config --libs libavformat libavcodec libswscale libswresample libavutil`
+  if [ $? != 0 ]; then
+    echo "not found ffmpeg, install ffmpeg development packages or set FFMPEG_NATIVE_PATH"
+    exit 1
+  fi
+fi
+
+if [ ! -d $PROJECT_OUTPUT_PATH ]; then
+  mkdir -p $PROJECT_OUTPUT_PATH
+fi
+
+if [ ! -d $INCLUDE_PATH ]; then
+  mkdir -p $INCLUDE_PATH
+fi
+
+# 写入 config.h 配置，benchmark 总是开启调用统计
+$NOW_PATH/config.sh $INCLUDE_PATH
+sed -i 's/^#define ENABLE_CODEC_STATS .*/#define ENABLE_CODEC_STATS 1/' $INCLUDE_PATH/config.h
+
+# 保留帧指针和调试信息，方便 perf record --call-graph
+CFLAG="-O2 -g -fno-omit-frame-pointer -pthread -I$BENCHMARK_PATH/include -I$INCLUDE_PATH $FFMPEG_CFLAGS"
+# 内核代码按 clang 的默认行为编写，gcc 14 之后这两类告警默认是错误
+C_FLAG="-std=gnu11 -Wno-discarded-qualifiers -Wno-incompatible-pointer-types"
+
+set -e
+
+$CC $CFLAG $C_FLAG $BENCHMARK_PATH/record.c $BENCHMARK_PATH/fixture.c \
+  $FFMPEG_LIBS \
+  -o $PROJECT_OUTPUT_PATH/record
+
+$CC $CFLAG $C_FLAG $BENCHMARK_PATH/bench_decode.c $BENCHMARK_PATH/fixture.c \
+  $PROJECT_SRC_PATH/avcodec/src/clib/decode.c $PROJECT_SRC_PATH/avcodec/src/clib/logger/log.c \
+  $FFMPEG_LIBS \
+  -o $PROJECT_OUTPUT_PATH/bench_decode
+
+# encode.c 按媒体类型条件编译，benchmark 只测视频编码
+cp $INCLUDE_PATH/config.h $INCLUDE_PATH/config.h.bak
+echo "#define MEDIA_TYPE_VIDEO 1" >> $INCLUDE_PATH/config.h
+$CC $CFLAG $C_FLAG $BENCHMARK_PATH/bench_encode.c $BENCHMARK_PATH/fixture.c \
+  $PROJECT_SRC_PATH/avcodec/src/clib/encode.c $PROJECT_SRC_PATH/avcodec/src/clib/logger/log.c \
+  $FFMPEG_LIBS \
+  -o $PROJECT_OUTPUT_PATH/bench_encode
+mv $INCLUDE_PATH/config.h.bak $INCLUDE_PATH/config.h
+
+$CC $CFLAG $C_FLAG $BENCHMARK_PATH/bench_scale.c $BENCHMARK_PATH/fixture.c \
+  $PROJECT_SRC_PATH/videoscale/src/clib/scale.c \
+  $FFMPEG_LIBS \
+  -o $PROJECT_OUTPUT_PATH/bench_scale
+
+$CC $CFLAG $C_FLAG $BENCHMARK_PATH/bench_resample.c $BENCHMARK_PATH/fixture.c \
+  $PROJECT_SRC_PATH/audioresample/src/clib/resample.c \
+  $FFMPEG_LIBS \
+  -o $PROJECT_OUTPUT_PATH/bench_resample
+
+STRETCHPITCH_PATH=$PROJECT_SRC_PATH/audiostretchpitch/src/clib
+
+$CC $CFLAG $C_FLAG -c $BENCHMARK_PATH/fixture.c -o $PROJECT_OUTPUT_PATH/fixture.o
+$CXX $CFLAG $BENCHMARK_PATH/bench_stretchpitch.cpp $PROJECT_OUTPUT_PATH/fixture.o \
+  $STRETCHPITCH_PATH/stretchpitch.cpp \
+  $STRETCHPITCH_PATH/soundtouch/SoundTouch.cpp \
+  $STRETCHPITCH_PATH/soundtouch/FIFOSampleBuffer.cpp \
+  $STRETCHPITCH_PATH/soundtouch/RateTransposer.cpp \
+  $STRETCHPITCH_PATH/soundtouch/TDStretch.cpp \
+  $STRETCHPITCH_PATH/soundtouch/InterpolateLinear.cpp \
+  $STRETCHPITCH_PATH/soundtouch/InterpolateCubic.cpp \
+  $STRETCHPITCH_PATH/soundtouch/InterpolateShannon.cpp \
+  $STRETCHPITCH_PATH/soundtouch/AAFilter.cpp \
+  $STRETCHPITCH_PATH/soundtouch/FIRFilter.cpp \
+  -I "$STRETCHPITCH_PATH/soundtouch/include" \
+  -o $PROJECT_OUTPUT_PATH/bench_stretchpitch
+rm $PROJECT_OUTPUT_PATH/fixture.o
+
+echo "===== build native finished  ====="
@@ -79,6 +79,7 @@ emcc $CFLAG --no-entry -Wl,--no-check-features $CLIB_PATH/stretchpitch.cpp \
   $CLIB_PATH/soundtouch/InterpolateShannon.cpp \
   $CLIB_PATH/soundtouch/AAFilter.cpp \
   $CLIB_PATH/soundtouch/FIRFilter.cpp \
+  $CLIB_PATH/soundtouch/wasm_simd_optimized.cpp \
   -I "$PROJECT_ROOT_PATH/packages/cheap/include" \
   -I "$CLIB_PATH/soundtouch/include" \
   -s WASM=1 \
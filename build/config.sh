@@ -12,4 +12,11 @@ echo "#include <libavcodec/avcodec.h>" > $path/config.h
 echo "" >> $path/config.h
 
 echo "#define ENABLE_FFMPEG_LOG_LEVEL 0" >> $path/config.h
-echo "#define ENABLE_DEBUG 0" >> $path/config.h
\ No newline at end of file
+echo "#define ENABLE_DEBUG 0" >> $path/config.h
+
+# 编解码调用耗时统计，开启之后 decode.c / encode.c 会统计每次调用的耗时和数据量
+ENABLE_CODEC_STATS=`sed '/^enable_codec_stats=/!d;s/.*=//' $NOW_PATH/config`
+if ! [ -n "$ENABLE_CODEC_STATS" ]; then
+  ENABLE_CODEC_STATS=0
+fi
+echo "#define ENABLE_CODEC_STATS $ENABLE_CODEC_STATS" >> $path/config.h
\ No newline at end of file
@@ -0,0 +1,147 @@
+import AVTranscoder, { SegmentTranscoder } from '@libmedia/avtranscoder'
+import { IOReader, IOError } from '@libmedia/common/io'
+import { createAVIFormatContext, demux } from '@libmedia/avformat'
+import IIsobmffFormat from '@libmedia/avformat/IIsobmffFormat'
+import IMatroskaFormat from '@libmedia/avformat/IMatroskaFormat'
+
+async function openFile(readFile: File) {
+  const iformatContext = createAVIFormatContext()
+
+  const ioReader = new IOReader()
+
+  iformatContext.ioReader = ioReader
+  iformatContext.iformat = /\.(mkv|webm)$/.test(readFile.name) ? new IMatroskaFormat() : new IIsobmffFormat()
+
+  let readPos = 0
+  const readFileLength = readFile.size
+
+  ioReader.onFlush = async (buffer) => {
+    if (readPos >= readFileLength) {
+      return IOError.END
+    }
+    const len = Math.min(buffer.length, readFileLength - readPos)
+
+    buffer.set(new Uint8Array(await (readFile.slice(readPos, readPos + len).arrayBuffer())), 0)
+
+    readPos += len
+
+    return len
+  }
+  ioReader.onSeek = (pos) => {
+    readPos = Number(pos)
+    return 0
+  }
+
+  ioReader.onSize = () => {
+    return BigInt(readFile.size)
+  }
+
+  await demux.open(iformatContext)
+  await demux.analyzeStreams(iformatContext)
+
+  return iformatContext
+}
+
+function createOutput() {
+  let size = 0
+  return {
+    write(buffer: Uint8Array) {
+      size += buffer.length
+    },
+    appendBufferByPosition(buffer: Uint8Array, pos: number) {
+      size += buffer.length
+    },
+    seek(pos: number) {
+
+    },
+    close() {
+
+    },
+    getSize() {
+      return size
+    }
+  }
+}
+
+const video = {
+  codec: 'h264' as const,
+  bitrate: 3000000,
+  preset: 'balanced' as const
+}
+
+/**
+ * 对比分段并行转码在不同实例数下相对顺序转码的加速比
+ */
+export async function benchmarkSegmentTranscode(file: File, workers: number[] = [1, 2, 4]) {
+  const getWasm = (type: string, codecId?: number) => {
+    // 返回对应的 wasm 地址
+    return ''
+  }
+
+  const transcoder = new AVTranscoder({
+    getWasm
+  })
+  await transcoder.ready()
+
+  let start = performance.now()
+
+  const output = createOutput()
+  await new Promise<void>(async (resolve) => {
+    const taskId = await transcoder.addTask({
+      input: {
+        file
+      },
+      output: {
+        file: output,
+        format: 'mp4',
+        video
+      }
+    })
+    const onEnd = (id: string) => {
+      if (id === taskId) {
+        transcoder.off(AVTranscoder.Events.TASK_ENDED, onEnd)
+        resolve()
+      }
+    }
+    transcoder.on(AVTranscoder.Events.TASK_ENDED, onEnd)
+    transcoder.startTask(taskId)
+  })
+
+  const sequentialCost = performance.now() - start
+
+  await transcoder.destroy()
+
+  console.log(`sequential: ${sequentialCost.toFixed(2)}ms, size: ${output.getSize()}`)
+
+  for (let i = 0; i < workers.length; i++) {
+    const formatContext = await openFile(file)
+
+    const segmentTranscoder = new SegmentTranscoder({
+      getWasm,
+      workers: workers[i]
+    })
+    // 实例启动时间不计入
+    await segmentTranscoder.ready()
+
+    start = performance.now()
+
+    const output = createOutput()
+    const ret = await segmentTranscoder.transcode(formatContext, {
+      input: {
+        file
+      },
+      output: {
+        file: output,
+        format: 'mp4',
+        video
+      }
+    })
+
+    const cost = performance.now() - start
+
+    console.log(`workers: ${workers[i]}, ret: ${ret}, ${cost.toFixed(2)}ms, speedup: ${(sequentialCost / cost).toFixed(2)}x, size: ${output.getSize()}`)
+
+    await segmentTranscoder.destroy()
+    await formatContext.destroy()
+  }
+}
@@ -0,0 +1,146 @@
+import AVTranscoder, { SmartCutter } from '@libmedia/avtranscoder'
+import { IOReader, IOError } from '@libmedia/common/io'
+import { createAVIFormatContext, demux } from '@libmedia/avformat'
+import IIsobmffFormat from '@libmedia/avformat/IIsobmffFormat'
+import IMatroskaFormat from '@libmedia/avformat/IMatroskaFormat'
+
+async function openFile(readFile: File) {
+  const iformatContext = createAVIFormatContext()
+
+  const ioReader = new IOReader()
+
+  iformatContext.ioReader = ioReader
+  iformatContext.iformat = /\.(mkv|webm)$/.test(readFile.name) ? new IMatroskaFormat() : new IIsobmffFormat()
+
+  let readPos = 0
+  const readFileLength = readFile.size
+
+  ioReader.onFlush = async (buffer) => {
+    if (readPos >= readFileLength) {
+      return IOError.END
+    }
+    const len = Math.min(buffer.length, readFileLength - readPos)
+
+    buffer.set(new Uint8Array(await (readFile.slice(readPos, readPos + len).arrayBuffer())), 0)
+
+    readPos += len
+
+    return len
+  }
+  ioReader.onSeek = (pos) => {
+    readPos = Number(pos)
+    return 0
+  }
+
+  ioReader.onSize = () => {
+    return BigInt(readFile.size)
+  }
+
+  await demux.open(iformatContext)
+  await demux.analyzeStreams(iformatContext)
+
+  return iformatContext
+}
+
+function createOutput() {
+  let size = 0
+  return {
+    write(buffer: Uint8Array) {
+      size += buffer.length
+    },
+    appendBufferByPosition(buffer: Uint8Array, pos: number) {
+      size += buffer.length
+    },
+    seek(pos: number) {
+
+    },
+    close() {
+
+    },
+    getSize() {
+      return size
+    }
+  }
+}
+
+const video = {
+  bitrate: 3000000,
+  preset: 'balanced' as const
+}
+
+/**
+ * 对比整段重编码裁剪和智能裁剪（只重编码边界 gop）的耗时
+ */
+export async function benchmarkSmartCut(file: File, start: number, duration: number) {
+  const getWasm = (type: string, codecId?: number) => {
+    // 返回对应的 wasm 地址
+    return ''
+  }
+
+  const transcoder = new AVTranscoder({
+    getWasm
+  })
+  await transcoder.ready()
+
+  let begin = performance.now()
+
+  const output = createOutput()
+  await new Promise<void>(async (resolve) => {
+    const taskId = await transcoder.addTask({
+      input: {
+        file
+      },
+      start,
+      duration,
+      output: {
+        file: output,
+        format: 'mp4',
+        video
+      }
+    })
+    const onEnd = (id: string) => {
+      if (id === taskId) {
+        transcoder.off(AVTranscoder.Events.TASK_ENDED, onEnd)
+        resolve()
+      }
+    }
+    transcoder.on(AVTranscoder.Events.TASK_ENDED, onEnd)
+    transcoder.startTask(taskId)
+  })
+
+  const reencodeCost = performance.now() - begin
+
+  await transcoder.destroy()
+
+  console.log(`re-encode: ${reencodeCost.toFixed(2)}ms, size: ${output.getSize()}`)
+
+  const formatContext = await openFile(file)
+
+  const smartCutter = new SmartCutter({
+    getWasm
+  })
+  await smartCutter.ready()
+
+  begin = performance.now()
+
+  const smartOutput = createOutput()
+  const ret = await smartCutter.cut(formatContext, {
+    input: {
+      file
+    },
+    start,
+    duration,
+    output: {
+      file: smartOutput,
+      format: 'mp4',
+      video
+    }
+  })
+
+  const smartCost = performance.now() - begin
+
+  console.log(`smart cut: ret: ${ret}, ${smartCost.toFixed(2)}ms, speedup: ${(reencodeCost / smartCost).toFixed(2)}x, size: ${smartOutput.getSize()}`)
+
+  await smartCutter.destroy()
+  await formatContext.destroy()
+}
@@ -0,0 +1,157 @@
+import { StretchPitcher } from '@libmedia/audiostretchpitch'
+import { avMalloc, avFree } from '@libmedia/avutil'
+import { compileResource, mapFloat32Array } from '@libmedia/cheap'
+
+// 每次送入的采样数
+const FRAME_SIZE = 1024
+
+function createSignal(channels: number, sampleRate: number, seconds: number) {
+  const nbSamples = sampleRate * seconds
+  const signal = new Float32Array(nbSamples * channels)
+  for (let i = 0; i < nbSamples; i++) {
+    for (let c = 0; c < channels; c++) {
+      // 每个声道不同频率的正弦叠加少量噪声
+      signal[i * channels + c] = 0.5 * Math.sin(2 * Math.PI * (220 * (c + 1)) * i / sampleRate)
+        + 0.05 * (Math.random() - 0.5)
+    }
+  }
+  return signal
+}
+
+async function process(
+  wasmUrl: string,
+  signal: Float32Array,
+  channels: number,
+  sampleRate: number,
+  setup: (stretchpitcher: StretchPitcher) => void
+) {
+  const resource = await compileResource({
+    source: wasmUrl
+  })
+
+  const stretchpitcher = new StretchPitcher({
+    resource
+  })
+  await stretchpitcher.open({
+    channels,
+    sampleRate
+  })
+  setup(stretchpitcher)
+
+  const buffer = reinterpret_cast<pointer<float>>(avMalloc(FRAME_SIZE * channels * 4))
+  const output: Float32Array[] = []
+
+  const receive = () => {
+    while (true) {
+      const nbSamples = stretchpitcher.receiveSamples(buffer, FRAME_SIZE)
+      if (nbSamples <= 0) {
+        break
+      }
+      output.push(mapFloat32Array(buffer, nbSamples * channels).slice())
+    }
+  }
+
+  const start = performance.now()
+
+  for (let i = 0; i < signal.length; i += FRAME_SIZE * channels) {
+    const data = signal.subarray(i, Math.min(i + FRAME_SIZE * channels, signal.length))
+    mapFloat32Array(buffer, data.length).set(data)
+    stretchpitcher.sendSamples(buffer, data.length / channels)
+    receive()
+  }
+  stretchpitcher.flush()
+  receive()
+
+  const cost = performance.now() - start
+
+  avFree(buffer)
+  stretchpitcher.close()
+
+  const result = new Float32Array(output.reduce((size, item) => size + item.length, 0))
+  let pos = 0
+  output.forEach((item) => {
+    result.set(item, pos)
+    pos += item.length
+  })
+
+  return {
+    cost,
+    result
+  }
+}
+
+/**
+ * 对比 stretchpitch 标量版本和 SIMD128 版本的耗时，并检查两者输出的差异在浮点误差范围内
+ * 
+ * SIMD128 版本改变了互相关的求和顺序，输出不是逐位相同的；互相关几乎相等时选出的最佳重叠位置可能不同，
+ * 这时对应片段的差异会超过误差范围
+ * 
+ * @param scalarWasmUrl 标量版本的 wasm 地址（stretchpitch.wasm，或者定义 SOUNDTOUCH_DISABLE_WASM_SIMD 编译的 simd 版本）
+ * @param simdWasmUrl SIMD128 版本的 wasm 地址（stretchpitch-simd.wasm）
+ */
+export async function benchmarkStretchPitch(
+  scalarWasmUrl: string,
+  simdWasmUrl: string,
+  channels: number[] = [1, 2, 6],
+  tempos: number[] = [0.75, 1.25, 2]
+) {
+  const sampleRate = 48000
+  // 允许的最大绝对误差
+  const tolerance = 1e-3
+
+  for (let i = 0; i < channels.length; i++) {
+    const signal = createSignal(channels[i], sampleRate, 30)
+
+    for (let j = 0; j < tempos.length; j++) {
+      const setup = (stretchpitcher: StretchPitcher) => stretchpitcher.setTempo(tempos[j])
+      const scalar = await process(scalarWasmUrl, signal, channels[i], sampleRate, setup)
+      const simd = await process(simdWasmUrl, signal, channels[i], sampleRate, setup)
+
+      let maxDiff = 0
+      const length = Math.min(scalar.result.length, simd.result.length)
+      for (let k = 0; k < length; k++) {
+        maxDiff = Math.max(maxDiff, Math.abs(scalar.result[k] - simd.result[k]))
+      }
+
+      console.log(`channels: ${channels[i]}, tempo: ${tempos[j]}, scalar: ${scalar.cost.toFixed(2)}ms, simd: ${simd.cost.toFixed(2)}ms, speedup: ${(scalar.cost / simd.cost).toFixed(2)}x, `
+        + `samples: ${scalar.result.length}/${simd.result.length}, max diff: ${maxDiff.toExponential(2)}, ${maxDiff <= tolerance && scalar.result.length === simd.result.length ? 'pass' : 'fail'}`)
+    }
+  }
+}
+
+/**
+ * 对比变速（RateTransposer 的抗混叠 FIR 滤波）标量版本和 SIMD128 版本每秒处理的采样数
+ * 
+ * FIR 滤波的 SIMD128 版本累加顺序和标量版本相同，输出逐位一致
+ * 
+ * @param scalarWasmUrl 标量版本的 wasm 地址
+ * @param simdWasmUrl SIMD128 版本的 wasm 地址
+ */
+export async function benchmarkRateTransposer(
+  scalarWasmUrl: string,
+  simdWasmUrl: string,
+  channels: number[] = [1, 2, 4, 6, 8],
+  rate: number = 1.25
+) {
+  const sampleRate = 48000
+  const seconds = 30
+
+  for (let i = 0; i < channels.length; i++) {
+    const signal = createSignal(channels[i], sampleRate, seconds)
+    const setup = (stretchpitcher: StretchPitcher) => stretchpitcher.setRate(rate)
+
+    const scalar = await process(scalarWasmUrl, signal, channels[i], sampleRate, setup)
+    const simd = await process(simdWasmUrl, signal, channels[i], sampleRate, setup)
+
+    let exact = scalar.result.length === simd.result.length
+    for (let k = 0; exact && k < scalar.result.length; k++) {
+      exact = scalar.result[k] === simd.result[k]
+    }
+
+    const scalarSpeed = sampleRate * seconds / scalar.cost * 1000
+    const simdSpeed = sampleRate * seconds / simd.cost * 1000
+
+    console.log(`channels: ${channels[i]}, rate: ${rate}, scalar: ${(scalarSpeed / 1e6).toFixed(2)}M samples/s, simd: ${(simdSpeed / 1e6).toFixed(2)}M samples/s, `
+      + `speedup: ${(simdSpeed / scalarSpeed).toFixed(2)}x, ${exact ? 'bit-exact' : 'mismatch'}`)
+  }
+}
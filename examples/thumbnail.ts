@@ -0,0 +1,100 @@
+import { ThumbnailExtractor } from '@libmedia/avtranscoder'
+import { IOReader, IOError } from '@libmedia/common/io'
+import { AVMediaType, getWasmUrl } from '@libmedia/avutil'
+import { compileResource } from '@libmedia/cheap'
+import { createAVIFormatContext, demux } from '@libmedia/avformat'
+import IIsobmffFormat from '@libmedia/avformat/IIsobmffFormat'
+import IMatroskaFormat from '@libmedia/avformat/IMatroskaFormat'
+
+async function openFile(readFile: File) {
+  const iformatContext = createAVIFormatContext()
+
+  const ioReader = new IOReader()
+
+  iformatContext.ioReader = ioReader
+  iformatContext.iformat = /\.(mkv|webm)$/.test(readFile.name) ? new IMatroskaFormat() : new IIsobmffFormat()
+
+  let readPos = 0
+  const readFileLength = readFile.size
+
+  ioReader.onFlush = async (buffer) => {
+    if (readPos >= readFileLength) {
+      return IOError.END
+    }
+    const len = Math.min(buffer.length, readFileLength - readPos)
+
+    buffer.set(new Uint8Array(await (readFile.slice(readPos, readPos + len).arrayBuffer())), 0)
+
+    readPos += len
+
+    return len
+  }
+  ioReader.onSeek = (pos) => {
+    readPos = Number(pos)
+    return 0
+  }
+
+  ioReader.onSize = () => {
+    return BigInt(readFile.size)
+  }
+
+  await demux.open(iformatContext)
+  await demux.analyzeStreams(iformatContext)
+
+  return iformatContext
+}
+
+/**
+ * 对一组本地文件生成缩略图并统计吞吐量（张/秒）
+ */
+export async function benchmarkThumbnail(files: File[], wasmBaseUrl: string, count: number = 20, width: number = 160) {
+
+  const scalerResource = await compileResource({
+    source: getWasmUrl(wasmBaseUrl, 'scaler')
+  })
+
+  let total = 0
+  let totalTime = 0
+
+  for (let i = 0; i < files.length; i++) {
+    const iformatContext = await openFile(files[i])
+    const stream = iformatContext.getStreamByMediaType(AVMediaType.AVMEDIA_TYPE_VIDEO)
+
+    if (!stream) {
+      iformatContext.destroy()
+      continue
+    }
+
+    const decoderResource = await compileResource({
+      source: getWasmUrl(wasmBaseUrl, 'decoder', stream.codecpar.codecId)
+    })
+
+    const extractor = new ThumbnailExtractor({
+      decoderResource,
+      scalerResource
+    })
+
+    const start = performance.now()
+
+    const ret = await extractor.extract(iformatContext, {
+      count,
+      width,
+      onThumbnail(frame, index, timestamp) {
+        // 这里拿到 RGBA 的缩略图，可以写入 sprite 图
+      }
+    })
+
+    const cost = performance.now() - start
+
+    if (ret > 0) {
+      total += ret
+      totalTime += cost
+    }
+
+    console.log(`${files[i].name}: ${ret} thumbnails in ${cost.toFixed(2)}ms, ${(ret * 1000 / cost).toFixed(2)} thumbnails/s`)
+
+    iformatContext.destroy()
+  }
+
+  console.log(`total: ${total} thumbnails in ${totalTime.toFixed(2)}ms, ${(total * 1000 / totalTime).toFixed(2)} thumbnails/s`)
+}
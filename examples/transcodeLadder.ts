@@ -0,0 +1,104 @@
+import AVTranscoder from '@libmedia/avtranscoder'
+
+const renditions = [
+  { width: 1280, height: 720, bitrate: 3000000 },
+  { width: 854, height: 480, bitrate: 1500000 },
+  { width: 640, height: 360, bitrate: 800000 }
+]
+
+function createOutput() {
+  let size = 0
+  return {
+    write(buffer: Uint8Array) {
+      size += buffer.length
+    },
+    appendBufferByPosition(buffer: Uint8Array, pos: number) {
+
+    },
+    seek(pos: number) {
+
+    },
+    close() {
+
+    }
+  }
+}
+
+async function runTask(transcoder: AVTranscoder, options: Parameters<AVTranscoder['addTask']>[0]) {
+  const taskId = await transcoder.addTask(options)
+  await new Promise<void>((resolve) => {
+    const onEnd = (id: string) => {
+      if (id === taskId) {
+        transcoder.off(AVTranscoder.Events.TASK_ENDED, onEnd)
+        resolve()
+      }
+    }
+    transcoder.on(AVTranscoder.Events.TASK_ENDED, onEnd)
+    transcoder.startTask(taskId)
+  })
+}
+
+/**
+ * 对比码率阶梯模式（一次解码多路编码）和每一路单独转码的耗时
+ */
+export async function benchmarkLadder(file: File) {
+  const transcoder = new AVTranscoder({
+    getWasm: (type, codecId) => {
+      // 返回对应的 wasm 地址
+      return ''
+    }
+  })
+  await transcoder.ready()
+
+  let start = performance.now()
+
+  await runTask(transcoder, {
+    input: {
+      file
+    },
+    output: {
+      file: createOutput(),
+      format: 'mp4',
+      audio: {
+        disable: true
+      },
+      video: {
+        codec: 'h264',
+        width: 1920,
+        height: 1080,
+        bitrate: 6000000,
+        ladder: renditions
+      }
+    }
+  })
+
+  const ladderCost = performance.now() - start
+
+  start = performance.now()
+
+  const sizes = [{ width: 1920, height: 1080, bitrate: 6000000 }, ...renditions]
+  for (let i = 0; i < sizes.length; i++) {
+    await runTask(transcoder, {
+      input: {
+        file
+      },
+      output: {
+        file: createOutput(),
+        format: 'mp4',
+        audio: {
+          disable: true
+        },
+        video: {
+          codec: 'h264',
+          ...sizes[i]
+        }
+      }
+    })
+  }
+
+  const separateCost = performance.now() - start
+
+  console.log(`ladder: ${ladderCost.toFixed(2)}ms, separate: ${separateCost.toFixed(2)}ms, saved: ${((1 - ladderCost / separateCost) * 100).toFixed(2)}%`)
+
+  await transcoder.destroy()
+}
@@ -23,15 +23,71 @@
  *
  */
 
-import { type WebAssemblyResource, WebAssemblyRunner } from '@libmedia/cheap'
+import { type AVPCMBuffer, hasWasmExport } from '@libmedia/avutil'
+import { type WebAssemblyResource, WebAssemblyRunner, mapFloat32Array } from '@libmedia/cheap'
 
 export interface StretchPitchParameters {
   channels: int32
   sampleRate: int32
 }
 
+/**
+ * 变速处理的质量档位
+ */
+export const enum StretchPitchQuality {
+  /**
+   * 音乐，WSOLA 参数根据 tempo 自动计算，完整搜索最佳重叠位置
+   */
+  MUSIC,
+  /**
+   * 语音，低延时，使用较短的处理序列和搜索窗口
+   */
+  SPEECH,
+  /**
+   * 低开销，缩小搜索窗口并开启快速搜索，适合 tempo 接近 1 的场景
+   */
+  CHEAP
+}
+
+interface QualityPreset {
+  sequenceMs: int32
+  seekWindowMs: int32
+  overlapMs: int32
+  quickSeek: boolean
+}
+
+// sequenceMs 和 seekWindowMs 为 0 表示根据 tempo 自动计算
+const QualityPresets: Record<StretchPitchQuality, QualityPreset> = {
+  [StretchPitchQuality.MUSIC]: {
+    sequenceMs: 0,
+    seekWindowMs: 0,
+    overlapMs: 8,
+    quickSeek: false
+  },
+  [StretchPitchQuality.SPEECH]: {
+    sequenceMs: 40,
+    seekWindowMs: 15,
+    overlapMs: 8,
+    quickSeek: false
+  },
+  [StretchPitchQuality.CHEAP]: {
+    sequenceMs: 0,
+    seekWindowMs: 10,
+    overlapMs: 8,
+    quickSeek: true
+  }
+}
+
 export type StretchPitchOptions = {
   resource: WebAssemblyResource
+  /**
+   * 共享模块模式，传入已经 run 过的 WebAssemblyRunner，多个 StretchPitcher 共用同一个 wasm 实例
+   * 
+   * 每个 StretchPitcher 创建独立的处理句柄，close 时不会销毁 runner
+   * 
+   * 旧版本编译的 wasm 只有单实例接口，这时会忽略 runner 使用独立的实例
+   */
+  runner?: WebAssemblyRunner
 }
 
 export default class StretchPitcher {
@@ -40,77 +96,280 @@ export default class StretchPitcher {
 
   private options: StretchPitchOptions
 
+  private context: pointer<void>
+
+  /**
+   * 旧版本编译的 wasm 没有句柄接口，只能使用全局单实例接口
+   */
+  private legacy: boolean
+
+  private ownRunner: boolean
+
+  private channels: int32
+
+  /**
+   * 单实例接口只支持交错格式，平面格式的采样在这里中转
+   */
+  private buffer: pointer<float>
+
+  private bufferSize: int32
 
   constructor(options: StretchPitchOptions) {
     this.options = options
-    this.processor = new WebAssemblyRunner(this.options.resource)
+    this.legacy = !hasWasmExport(this.options.resource, 'stretchpitch_create')
+    this.ownRunner = this.legacy || !this.options.runner
+    this.processor = this.ownRunner ? new WebAssemblyRunner(this.options.resource) : this.options.runner
+    this.context = nullptr
+    this.channels = 0
+    this.buffer = nullptr
+    this.bufferSize = 0
+  }
+
+  private invoke<T = void>(method: string, ...args: any[]) {
+    if (this.legacy) {
+      return this.processor.invoke<T>(`stretchpitch_${method}`, ...args)
+    }
+    return this.processor.invoke<T>(`stretchpitch_context_${method}`, this.context, ...args)
+  }
+
+  private hasExport(method: string) {
+    return hasWasmExport(this.options.resource, this.legacy ? `stretchpitch_${method}` : `stretchpitch_context_${method}`)
   }
 
+  private getBuffer(nbSamples: int32) {
+    const size = nbSamples * this.channels
+    if (this.bufferSize < size) {
+      if (this.buffer) {
+        free(this.buffer)
+      }
+      this.buffer = reinterpret_cast<pointer<float>>(malloc(sizeof(float) * static_cast<size>(size)))
+      this.bufferSize = size
+    }
+    return this.buffer
+  }
+
+  /**
+   * 所有声道在同一个实例中处理
+   * 
+   * @param parameters 
+   */
   public async open(parameters: StretchPitchParameters) {
-    await this.processor.run()
-    this.processor.invoke('stretchpitch_init')
-    this.processor.invoke('stretchpitch_set_channels', parameters.channels)
-    this.processor.invoke('stretchpitch_set_samplerate', parameters.sampleRate)
+    if (this.ownRunner) {
+      await this.processor.run()
+    }
+    if (this.legacy) {
+      this.processor.invoke('stretchpitch_init')
+    }
+    else {
+      this.context = this.processor.invoke<pointer<void>>('stretchpitch_create')
+    }
+    this.channels = parameters.channels
+    this.invoke('set_channels', parameters.channels)
+    this.invoke('set_samplerate', parameters.sampleRate)
   }
 
   public setRate(rate: double) {
-    this.processor.invoke('stretchpitch_set_rate', rate)
+    this.invoke('set_rate', rate)
   }
 
   public setRateChange(change: double) {
-    this.processor.invoke('stretchpitch_set_rate_change', change)
+    this.invoke('set_rate_change', change)
   }
 
   public setTempo(tempo: double) {
-    this.processor.invoke('stretchpitch_set_tempo', tempo)
+    this.invoke('set_tempo', tempo)
   }
 
   public setTempoChange(change: double) {
-    this.processor.invoke('stretchpitch_set_tempo_change', change)
+    this.invoke('set_tempo_change', change)
   }
 
   public setPitch(pitch: double) {
-    this.processor.invoke('stretchpitch_set_pitch', pitch)
+    this.invoke('set_pitch', pitch)
   }
 
   public setPitchOctaves(pitch: double) {
-    this.processor.invoke('stretchpitch_set_pitch_octaves', pitch)
+    this.invoke('set_pitch_octaves', pitch)
   }
 
   public setPitchSemiTones(pitch: double) {
-    this.processor.invoke('stretchpitch_set_pitch_semi_tones', pitch)
+    this.invoke('set_pitch_semi_tones', pitch)
+  }
+
+  /**
+   * 开启或关闭快速搜索最佳重叠位置，旧版本 wasm 不支持时忽略
+   * 
+   * @param enable 
+   */
+  public setQuickSeek(enable: boolean) {
+    if (this.hasExport('set_quick_seek')) {
+      this.invoke('set_quick_seek', enable ? 1 : 0)
+    }
+  }
+
+  /**
+   * 设置 WSOLA 处理参数，旧版本 wasm 不支持时忽略
+   * 
+   * @param sequenceMs 处理序列长度（毫秒），0 为根据 tempo 自动计算，负数保持不变
+   * @param seekWindowMs 搜索最佳重叠位置的窗口长度（毫秒），0 为根据 tempo 自动计算，负数保持不变
+   * @param overlapMs 序列之间的重叠长度（毫秒），小于等于 0 保持不变
+   */
+  public setParameters(sequenceMs: int32, seekWindowMs: int32, overlapMs: int32) {
+    if (this.hasExport('set_parameters')) {
+      this.invoke('set_parameters', sequenceMs, seekWindowMs, overlapMs)
+    }
+  }
+
+  /**
+   * 切换质量档位，会覆盖之前 setQuickSeek 和 setParameters 的设置
+   * 
+   * @param quality 
+   */
+  public setQuality(quality: StretchPitchQuality) {
+    const preset = QualityPresets[quality]
+    this.setParameters(preset.sequenceMs, preset.seekWindowMs, preset.overlapMs)
+    this.setQuickSeek(preset.quickSeek)
   }
 
+  /**
+   * 送入交错格式的采样
+   * 
+   * @param input 
+   * @param nbSamples 每个声道的采样数
+   */
   public sendSamples(input: pointer<float>, nbSamples: int32) {
-    this.processor.invoke('stretchpitch_send_samples', input, nbSamples)
+    this.invoke('send_samples', input, nbSamples)
   }
 
+  /**
+   * 取出交错格式的采样
+   * 
+   * @param output 
+   * @param maxSamples 每个声道最多取出的采样数
+   * @returns 取出的每个声道的采样数
+   */
   public receiveSamples(output: pointer<float>, maxSamples: int32) {
-    return this.processor.invoke<int32>('stretchpitch_receive_samples', output, maxSamples)
+    return this.invoke<int32>('receive_samples', output, maxSamples)
+  }
+
+  /**
+   * 送入平面格式的采样
+   * 
+   * @param input 每个声道的数据指针
+   * @param nbSamples 每个声道的采样数
+   */
+  public sendPlanarSamples(input: pointer<pointer<float>>, nbSamples: int32) {
+    if (!this.legacy) {
+      this.invoke('send_planar_samples', input, nbSamples)
+      return
+    }
+    if (nbSamples <= 0) {
+      return
+    }
+    const buffer = this.getBuffer(nbSamples)
+    const interleaved = mapFloat32Array(buffer, nbSamples * this.channels)
+    for (let c = 0; c < this.channels; c++) {
+      const plane = mapFloat32Array(input[c], nbSamples)
+      for (let i = 0; i < nbSamples; i++) {
+        interleaved[i * this.channels + c] = plane[i]
+      }
+    }
+    this.invoke('send_samples', buffer, nbSamples)
+  }
+
+  /**
+   * 取出平面格式的采样
+   * 
+   * @param output 每个声道的数据指针
+   * @param maxSamples 每个声道最多取出的采样数
+   * @param offset 写入每个声道的起始采样位置
+   * @returns 取出的每个声道的采样数
+   */
+  public receivePlanarSamples(output: pointer<pointer<float>>, maxSamples: int32, offset: int32 = 0) {
+    if (!this.legacy) {
+      return this.invoke<int32>('receive_planar_samples', output, offset, maxSamples)
+    }
+    if (maxSamples <= 0) {
+      return 0
+    }
+    const buffer = this.getBuffer(maxSamples)
+    const ret = this.invoke<int32>('receive_samples', buffer, maxSamples)
+    if (ret > 0) {
+      const interleaved = mapFloat32Array(buffer, ret * this.channels)
+      for (let c = 0; c < this.channels; c++) {
+        const plane = mapFloat32Array(output[c], offset + ret)
+        for (let i = 0; i < ret; i++) {
+          plane[offset + i] = interleaved[i * this.channels + c]
+        }
+      }
+    }
+    return ret
+  }
+
+  /**
+   * 送入平面 float 格式的 AVPCMBuffer
+   * 
+   * @param buffer 
+   */
+  public sendAVPCMBuffer(buffer: pointer<AVPCMBuffer>) {
+    this.sendPlanarSamples(reinterpret_cast<pointer<pointer<float>>>(buffer.data), buffer.nbSamples)
+  }
+
+  /**
+   * 取出采样追加到平面 float 格式的 AVPCMBuffer 的 nbSamples 之后，最多填满 maxnbSamples
+   * 
+   * @param buffer 
+   * @returns 本次取出的每个声道的采样数
+   */
+  public receiveAVPCMBuffer(buffer: pointer<AVPCMBuffer>) {
+    const ret = this.receivePlanarSamples(
+      reinterpret_cast<pointer<pointer<float>>>(buffer.data),
+      buffer.maxnbSamples - buffer.nbSamples,
+      buffer.nbSamples
+    )
+    buffer.nbSamples += ret
+    return ret
   }
 
   public flush() {
-    this.processor.invoke('stretchpitch_flush')
+    this.invoke('flush')
   }
 
   public clear() {
-    this.processor.invoke('stretchpitch_clear')
+    this.invoke('clear')
   }
 
   public getUnprocessedSamplesCount() {
-    return this.processor.invoke<int32>('stretchpitch_get_unprocessed_samples_num')
+    return this.invoke<int32>('get_unprocessed_samples_num')
   }
 
   public getInputOutputSamplesRatio() {
-    return this.processor.invoke<int32>('stretchpitch_get_input_output_sample_ratio')
+    return this.invoke<int32>('get_input_output_sample_ratio')
   }
 
   public getLatency() {
-    return this.processor.invoke<int32>('get_latency')
+    // 旧版本 wasm 导出的是不带前缀的全局 get_latency
+    if (this.legacy) {
+      return hasWasmExport(this.options.resource, 'get_latency') ? this.processor.invoke<int32>('get_latency') : 0
+    }
+    return this.invoke<int32>('get_latency')
   }
 
   public close() {
-    this.processor.invoke('stretchpitch_destroy')
-    this.processor.destroy()
+    if (this.legacy) {
+      this.processor.invoke('stretchpitch_destroy')
+    }
+    else if (this.context) {
+      this.invoke('destroy')
+      this.context = nullptr
+    }
+    if (this.buffer) {
+      free(this.buffer)
+      this.buffer = nullptr
+      this.bufferSize = 0
+    }
+    if (this.ownRunner) {
+      this.processor.destroy()
+    }
   }
 }
@@ -103,6 +103,28 @@ void FIFOSampleBuffer::putSamples(const SAMPLETYPE *samples, uint nSamples)
 }
 
 
+// Adds 'numSamples' pcs of samples from separate per-channel buffers to the
+// sample buffer. The samples are interleaved straight into the buffer end so
+// that the caller doesn't need an intermediate interleaved copy.
+void FIFOSampleBuffer::putSamplesPlanar(const SAMPLETYPE *const *planes, uint nSamples)
+{
+    SAMPLETYPE *dest = ptrEnd(nSamples);
+
+    for (uint c = 0; c < channels; c ++)
+    {
+        const SAMPLETYPE *src = planes[c];
+        SAMPLETYPE *pos = dest + c;
+
+        for (uint i = 0; i < nSamples; i ++)
+        {
+            *pos = src[i];
+            pos += channels;
+        }
+    }
+    samplesInBuffer += nSamples;
+}
+
+
 // Increases the number of samples in the buffer without copying any actual
 // samples.
 //
@@ -219,6 +241,32 @@ uint FIFOSampleBuffer::receiveSamples(SAMPLETYPE *output, uint maxSamples)
 }
 
 
+// Output samples from beginning of the sample buffer into separate per-channel
+// buffers, starting at index 'offset' of each. Removes the samples from the
+// sample buffer. Returns number of samples copied.
+uint FIFOSampleBuffer::receiveSamplesPlanar(SAMPLETYPE *const *planes, uint maxSamples, uint offset)
+{
+    uint num;
+    const SAMPLETYPE *src;
+
+    num = (maxSamples > samplesInBuffer) ? samplesInBuffer : maxSamples;
+    src = ptrBegin();
+
+    for (uint c = 0; c < channels; c ++)
+    {
+        const SAMPLETYPE *pos = src + c;
+        SAMPLETYPE *dest = planes[c] + offset;
+
+        for (uint i = 0; i < num; i ++)
+        {
+            dest[i] = *pos;
+            pos += channels;
+        }
+    }
+    return receiveSamples(num);
+}
+
+
 // Removes samples from the beginning of the sample buffer without copying them
 // anywhere. Used to reduce the number of samples in the buffer, when accessing
 // the sample buffer with the 'ptrBegin' function.
@@ -322,6 +322,15 @@ FIRFilter * FIRFilter::newInstance()
     else
 #endif // SOUNDTOUCH_ALLOW_SSE
 
+#ifdef SOUNDTOUCH_ALLOW_WASM_SIMD
+    // SIMD128 is a compile-time feature in WebAssembly, no runtime detection needed
+    if (true)
+    {
+        return ::new FIRFilterSIMD;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_WASM_SIMD
+
     {
         // ISA optimizations not supported, use plain C version
         return ::new FIRFilter;
@@ -135,6 +135,29 @@ public:
 
 #endif // SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_WASM_SIMD
+    /// Class that implements WebAssembly SIMD128 optimized functions exclusive for floating point samples type.
+    /// Used also by AAFilter, which evaluates through FIRFilter::newInstance.
+    class FIRFilterSIMD : public FIRFilter
+    {
+    protected:
+        // filter coefficients pre-interleaved to 4 copies each (one vector per tap)
+        float *filterCoeffsUnalign;
+        float *filterCoeffsAlign;
+
+        virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const override;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const override;
+        virtual uint evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels) override;
+    public:
+        FIRFilterSIMD();
+        ~FIRFilterSIMD();
+
+        virtual void setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor) override;
+    };
+
+#endif // SOUNDTOUCH_ALLOW_WASM_SIMD
+
 }
 
 #endif  // FIRFilter_H
@@ -125,19 +125,37 @@ void RateTransposer::putSamples(const SAMPLETYPE *samples, uint nSamples)
 }
 
 
+// Adds 'nSamples' pcs of samples from separate per-channel buffers into
+// the input of the object.
+void RateTransposer::putSamplesPlanar(const SAMPLETYPE *const *planes, uint nSamples)
+{
+    if (nSamples == 0) return;
+
+    inputBuffer.putSamplesPlanar(planes, nSamples);
+    processInputBuffer();
+}
+
+
 // Transposes sample rate by applying anti-alias filter to prevent folding. 
 // Returns amount of samples returned in the "dest" buffer.
 // The maximum amount of samples that can be returned at a time is set by
 // the 'set_returnBuffer_size' function.
 void RateTransposer::processSamples(const SAMPLETYPE *src, uint nSamples)
 {
-    uint count;
-
     if (nSamples == 0) return;
 
     // Store samples to input buffer
     inputBuffer.putSamples(src, nSamples);
 
+    processInputBuffer();
+}
+
+
+// Transposes the samples stored in 'inputBuffer' into 'outputBuffer'.
+void RateTransposer::processInputBuffer()
+{
+    uint count;
+
     // If anti-alias filter is turned off, simply transpose without applying
     // the filter
     if (bUseAAFilter == false) 
@@ -122,6 +122,9 @@ protected:
     void processSamples(const SAMPLETYPE *src, 
                         uint numSamples);
 
+    /// Transposes the samples already stored in 'inputBuffer'.
+    void processInputBuffer();
+
 public:
     RateTransposer();
     virtual ~RateTransposer() override;
@@ -149,6 +152,10 @@ public:
     /// the input of the object.
     void putSamples(const SAMPLETYPE *samples, uint numSamples) override;
 
+    /// Adds 'numSamples' pcs of samples from separate per-channel buffers into
+    /// the input of the object.
+    void putSamplesPlanar(const SAMPLETYPE *const *planes, uint numSamples);
+
     /// Clears all the samples in the object
     void clear() override;
 
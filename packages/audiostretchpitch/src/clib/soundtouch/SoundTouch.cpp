@@ -308,6 +308,38 @@ void SoundTouch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 }
 
 
+// Adds 'numSamples' pcs of samples from separate per-channel buffers into
+// the input of the object.
+void SoundTouch::putSamplesPlanar(const SAMPLETYPE *const *planes, uint nSamples)
+{
+    if (bSrateSet == false) 
+    {
+        ST_THROW_RT_ERROR("SoundTouch : Sample rate not defined");
+    } 
+    else if (channels == 0) 
+    {
+        ST_THROW_RT_ERROR("SoundTouch : Number of channels not defined");
+    }
+
+    samplesExpectedOut += (double)nSamples / ((double)rate * (double)tempo);
+
+#ifndef SOUNDTOUCH_PREVENT_CLICK_AT_RATE_CROSSOVER
+    if (rate <= 1.0f) 
+    {
+        assert(output == pTDStretch);
+        pRateTransposer->putSamplesPlanar(planes, nSamples);
+        pTDStretch->moveSamples(*pRateTransposer);
+    } 
+    else 
+#endif
+    {
+        assert(output == pRateTransposer);
+        pTDStretch->putSamplesPlanar(planes, nSamples);
+        pRateTransposer->moveSamples(*pTDStretch);
+    }
+}
+
+
 // Flushes the last samples from the processing pipeline to the output.
 // Clears also the internal processing buffers.
 //
@@ -516,6 +548,20 @@ uint SoundTouch::receiveSamples(SAMPLETYPE *output, uint maxSamples)
 }
 
 
+/// Output samples from beginning of the sample buffer into separate per-channel
+/// buffers, written starting at index 'offset' of each.
+///
+/// \return Number of samples returned.
+uint SoundTouch::receiveSamplesPlanar(SAMPLETYPE *const *planes, uint maxSamples, uint offset)
+{
+    // 'output' is the last processor in the chain, read directly from its output buffer
+    FIFOSamplePipe *outBuffer = (output == pTDStretch) ? pTDStretch->getOutput() : pRateTransposer->getOutput();
+    uint ret = static_cast<FIFOSampleBuffer *>(outBuffer)->receiveSamplesPlanar(planes, maxSamples, offset);
+    samplesOutput += (long)ret;
+    return ret;
+}
+
+
 /// Adjusts book-keeping so that given number of samples are removed from beginning of the 
 /// sample buffer without copying them anywhere. 
 ///
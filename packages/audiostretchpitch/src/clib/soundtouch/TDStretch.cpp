@@ -734,6 +734,17 @@ void TDStretch::putSamples(const SAMPLETYPE *samples, uint nSamples)
 }
 
 
+// Adds 'numsamples' pcs of samples from separate per-channel buffers into
+// the input of the object.
+void TDStretch::putSamplesPlanar(const SAMPLETYPE *const *planes, uint nSamples)
+{
+    // Interleave the samples straight into the input buffer
+    inputBuffer.putSamplesPlanar(planes, nSamples);
+    // Process the samples in input buffer
+    processSamples();
+}
+
+
 
 /// Set new overlap length parameter & reallocate RefMidBuffer if necessary.
 void TDStretch::acceptNewOverlapLength(int newOverlapLength)
@@ -794,6 +805,16 @@ TDStretch * TDStretch::newInstance()
     else
 #endif // SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_WASM_SIMD
+    // SIMD128 is a compile-time feature in WebAssembly, no runtime detection needed
+    if (true)
+    {
+        return ::new TDStretchSIMD;
+    }
+    else
+#endif // SOUNDTOUCH_ALLOW_WASM_SIMD
+
     {
         // ISA optimizations not supported, use plain C version
         return ::new TDStretch;
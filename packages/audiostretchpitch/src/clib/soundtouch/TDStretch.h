@@ -229,6 +229,10 @@ public:
                                                     ///< contains both channels if stereo
             ) override;
 
+    /// Adds 'numSamples' pcs of samples from separate per-channel buffers into
+    /// the input of the object.
+    void putSamplesPlanar(const SAMPLETYPE *const *planes, uint numSamples);
+
     /// return nominal input sample requirement for triggering a processing batch
     int getInputSampleReq() const
     {
@@ -275,5 +279,19 @@ public:
 
 #endif /// SOUNDTOUCH_ALLOW_SSE
 
+
+#ifdef SOUNDTOUCH_ALLOW_WASM_SIMD
+    /// Class that implements WebAssembly SIMD128 optimized routines for floating point samples type.
+    class TDStretchSIMD : public TDStretch
+    {
+    protected:
+        double calcCrossCorr(const float *mixingPos, const float *compare, double &norm) override;
+        double calcCrossCorrAccumulate(const float *mixingPos, const float *compare, double &norm) override;
+        virtual void overlapStereo(float *output, const float *input) const override;
+        virtual void overlapMulti(float *output, const float *input) const override;
+    };
+
+#endif /// SOUNDTOUCH_ALLOW_WASM_SIMD
+
 }
 #endif  /// TDStretch_H
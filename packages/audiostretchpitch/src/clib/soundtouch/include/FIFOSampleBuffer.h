@@ -132,6 +132,12 @@ public:
     virtual void putSamples(uint numSamples   ///< Number of samples been inserted.
                             );
 
+    /// Adds 'numSamples' pcs of samples from separate per-channel buffers to
+    /// the sample buffer, interleaving them directly into the buffer end.
+    void putSamplesPlanar(const SAMPLETYPE *const *planes, ///< One pointer per channel.
+                          uint numSamples                   ///< Number of samples to insert.
+                          );
+
     /// Output samples from beginning of the sample buffer. Copies requested samples to 
     /// output buffer and removes them from the sample buffer. If there are less than 
     /// 'numsample' samples in the buffer, returns all that available.
@@ -149,6 +155,16 @@ public:
     virtual uint receiveSamples(uint maxSamples   ///< Remove this many samples from the beginning of pipe.
                                 ) override;
 
+    /// Output samples from beginning of the sample buffer into separate per-channel
+    /// buffers and removes them from the sample buffer. Samples are written starting
+    /// at index 'offset' of each channel buffer.
+    ///
+    /// \return Number of samples returned.
+    uint receiveSamplesPlanar(SAMPLETYPE *const *planes, ///< One pointer per channel.
+                              uint maxSamples,           ///< How many samples to receive at max.
+                              uint offset                ///< Write position in each channel buffer.
+                              );
+
     /// Returns number of samples currently available.
     virtual uint numSamples() const override;
 
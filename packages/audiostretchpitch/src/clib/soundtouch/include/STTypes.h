@@ -158,6 +158,13 @@ namespace soundtouch
             #define SOUNDTOUCH_ALLOW_SSE       1
         #endif
 
+        #if defined(__wasm_simd128__) && !defined(SOUNDTOUCH_DISABLE_WASM_SIMD)
+            // Allow WebAssembly SIMD128 optimizations when compiling with -msimd128.
+            // Define SOUNDTOUCH_DISABLE_WASM_SIMD to fall back to the plain C routines
+            // (e.g. for comparing against the scalar path).
+            #define SOUNDTOUCH_ALLOW_WASM_SIMD 1
+        #endif
+
     #endif  // SOUNDTOUCH_INTEGER_SAMPLES
 
     #if ((SOUNDTOUCH_ALLOW_SSE) || (__SSE__) || (SOUNDTOUCH_USE_NEON))
@@ -289,6 +289,15 @@ public:
                                                     ///< contains data for both channels.
             ) override;
 
+    /// Adds 'numSamples' pcs of samples from separate per-channel buffers into
+    /// the input of the object. Equivalent to 'putSamples' with interleaved data,
+    /// but the samples are interleaved straight into the internal processing buffer
+    /// so that the caller doesn't need an intermediate interleaved copy.
+    void putSamplesPlanar(
+            const SAMPLETYPE *const *planes,    ///< One pointer per channel.
+            uint numSamples                     ///< Number of samples in each channel buffer.
+            );
+
     /// Output samples from beginning of the sample buffer. Copies requested samples to
     /// output buffer and removes them from the sample buffer. If there are less than
     /// 'numsample' samples in the buffer, returns all that available.
@@ -298,6 +307,16 @@ public:
         uint maxSamples                 ///< How many samples to receive at max.
         ) override;
 
+    /// Output samples from beginning of the sample buffer into separate per-channel
+    /// buffers, written starting at index 'offset' of each, and removes them from
+    /// the sample buffer.
+    ///
+    /// \return Number of samples returned.
+    uint receiveSamplesPlanar(SAMPLETYPE *const *planes, ///< One pointer per channel.
+        uint maxSamples,                ///< How many samples to receive at max.
+        uint offset                     ///< Write position in each channel buffer.
+        );
+
     /// Adjusts book-keeping so that given number of samples are removed from beginning of the
     /// sample buffer without copying them anywhere.
     ///
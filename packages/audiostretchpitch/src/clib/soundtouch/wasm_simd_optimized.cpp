@@ -0,0 +1,402 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// WebAssembly SIMD128 optimized routines. All SIMD128 optimized functions 
+/// have been gathered into this single source code file, regardless to their 
+/// class or original source code file, in the same way as 'mmx_optimized.cpp'.
+///
+/// The optimizations are programmed using the clang 'wasm_simd128.h' intrinsics
+/// and are compiled in only when building with '-msimd128', see 
+/// SOUNDTOUCH_ALLOW_WASM_SIMD in 'STTypes.h'. WebAssembly has no runtime CPU 
+/// feature detection, the SIMD build is selected when loading the module.
+///
+/// The results are not bit-exact with the plain C routines where the 
+/// summation order changes (TDStretch cross-correlation, stereo overlap ramp), 
+/// the differences stay within float rounding tolerance. The FIR filter 
+/// routines keep the order and are bit-exact.
+///
+/// SoundTouch WWW: http://www.surina.net/soundtouch
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// License :
+//
+//  SoundTouch audio processing library
+//  Copyright (c) Olli Parviainen
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2.1 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "STTypes.h"
+
+#ifdef SOUNDTOUCH_ALLOW_WASM_SIMD
+// SIMD128 routines available only with float sample type
+
+using namespace soundtouch;
+
+#include <wasm_simd128.h>
+#include <math.h>
+#include <assert.h>
+
+// Sums the four lanes of a float vector
+static inline float horizontalSum(v128_t v)
+{
+    v = wasm_f32x4_add(v, wasm_i32x4_shuffle(v, v, 2, 3, 0, 1));
+    v = wasm_f32x4_add(v, wasm_i32x4_shuffle(v, v, 1, 0, 3, 2));
+    return wasm_f32x4_extract_lane(v, 0);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SIMD128 optimized functions of class 'TDStretchSIMD'
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "TDStretch.h"
+
+// Calculates cross correlation of two buffers
+double TDStretchSIMD::calcCrossCorr(const float *pV1, const float *pV2, double &anorm)
+{
+    int i;
+    float corr, norm;
+    v128_t vCorr0, vCorr1, vNorm0, vNorm1;
+
+    // Loop length is divisible by 8, process 2 vectors per round with
+    // separate accumulators for improved CPU-level parallellization.
+    int ilength = (channels * overlapLength) & -8;
+
+    vCorr0 = vCorr1 = vNorm0 = vNorm1 = wasm_f32x4_splat(0);
+
+    for (i = 0; i < ilength; i += 8)
+    {
+        v128_t vMix0 = wasm_v128_load(pV1 + i);
+        v128_t vMix1 = wasm_v128_load(pV1 + i + 4);
+        v128_t vCmp0 = wasm_v128_load(pV2 + i);
+        v128_t vCmp1 = wasm_v128_load(pV2 + i + 4);
+
+        vCorr0 = wasm_f32x4_add(vCorr0, wasm_f32x4_mul(vMix0, vCmp0));
+        vCorr1 = wasm_f32x4_add(vCorr1, wasm_f32x4_mul(vMix1, vCmp1));
+        vNorm0 = wasm_f32x4_add(vNorm0, wasm_f32x4_mul(vMix0, vMix0));
+        vNorm1 = wasm_f32x4_add(vNorm1, wasm_f32x4_mul(vMix1, vMix1));
+    }
+
+    corr = horizontalSum(wasm_f32x4_add(vCorr0, vCorr1));
+    norm = horizontalSum(wasm_f32x4_add(vNorm0, vNorm1));
+
+    anorm = norm;
+    return corr / sqrt((norm < 1e-9 ? 1.0 : norm));
+}
+
+
+/// Update cross-correlation by accumulating "norm" coefficient by previously calculated value
+double TDStretchSIMD::calcCrossCorrAccumulate(const float *pV1, const float *pV2, double &norm)
+{
+    int i;
+    float corr;
+    v128_t vCorr0, vCorr1;
+
+    // cancel first normalizer tap from previous round
+    for (i = 1; i <= channels; i ++)
+    {
+        norm -= pV1[-i] * pV1[-i];
+    }
+
+    int ilength = (channels * overlapLength) & -8;
+
+    vCorr0 = vCorr1 = wasm_f32x4_splat(0);
+
+    for (i = 0; i < ilength; i += 8)
+    {
+        vCorr0 = wasm_f32x4_add(vCorr0, wasm_f32x4_mul(wasm_v128_load(pV1 + i), wasm_v128_load(pV2 + i)));
+        vCorr1 = wasm_f32x4_add(vCorr1, wasm_f32x4_mul(wasm_v128_load(pV1 + i + 4), wasm_v128_load(pV2 + i + 4)));
+    }
+
+    corr = horizontalSum(wasm_f32x4_add(vCorr0, vCorr1));
+
+    // update normalizer with last samples of this round
+    for (int j = 0; j < channels; j ++)
+    {
+        i --;
+        norm += pV1[i] * pV1[i];
+    }
+
+    return corr / sqrt((norm < 1e-9 ? 1.0 : norm));
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'pInput'
+void TDStretchSIMD::overlapStereo(float *pOutput, const float *pInput) const
+{
+    int i;
+    float fScale;
+    v128_t vF1, vF2, vStep;
+
+    fScale = 1.0f / (float)overlapLength;
+
+    // Two stereo frames per vector, each lane pair having its own ramp value
+    vF1 = wasm_f32x4_make(0, 0, fScale, fScale);
+    vF2 = wasm_f32x4_make(1.0f, 1.0f, 1.0f - fScale, 1.0f - fScale);
+    vStep = wasm_f32x4_splat(2 * fScale);
+
+    for (i = 0; i + 4 <= 2 * overlapLength; i += 4)
+    {
+        v128_t vIn = wasm_v128_load(pInput + i);
+        v128_t vMid = wasm_v128_load(pMidBuffer + i);
+
+        wasm_v128_store(pOutput + i, wasm_f32x4_add(wasm_f32x4_mul(vIn, vF1), wasm_f32x4_mul(vMid, vF2)));
+
+        vF1 = wasm_f32x4_add(vF1, vStep);
+        vF2 = wasm_f32x4_sub(vF2, vStep);
+    }
+
+    // odd overlap length leaves one frame; calculateOverlapLength keeps it divisible by 8
+    if (i < 2 * overlapLength)
+    {
+        float f1 = wasm_f32x4_extract_lane(vF1, 0);
+        float f2 = wasm_f32x4_extract_lane(vF2, 0);
+
+        pOutput[i + 0] = pInput[i + 0] * f1 + pMidBuffer[i + 0] * f2;
+        pOutput[i + 1] = pInput[i + 1] * f1 + pMidBuffer[i + 1] * f2;
+    }
+}
+
+
+// Overlaps samples in 'midBuffer' with the samples in 'input'. 
+void TDStretchSIMD::overlapMulti(float *pOutput, const float *pInput) const
+{
+    int i;
+    float fScale;
+    float f1;
+    float f2;
+
+    fScale = 1.0f / (float)overlapLength;
+
+    f1 = 0;
+    f2 = 1.0f;
+
+    i = 0;
+    for (int i2 = 0; i2 < overlapLength; i2 ++)
+    {
+        v128_t vF1 = wasm_f32x4_splat(f1);
+        v128_t vF2 = wasm_f32x4_splat(f2);
+        int c = 0;
+
+        // same ramp value for all channels of the frame, 4 channels per round
+        for (; c + 4 <= channels; c += 4)
+        {
+            v128_t vIn = wasm_v128_load(pInput + i);
+            v128_t vMid = wasm_v128_load(pMidBuffer + i);
+
+            wasm_v128_store(pOutput + i, wasm_f32x4_add(wasm_f32x4_mul(vIn, vF1), wasm_f32x4_mul(vMid, vF2)));
+            i += 4;
+        }
+        for (; c < channels; c ++)
+        {
+            pOutput[i] = pInput[i] * f1 + pMidBuffer[i] * f2;
+            i ++;
+        }
+
+        f1 += fScale;
+        f2 -= fScale;
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// implementation of SIMD128 optimized functions of class 'FIRFilterSIMD'
+//
+// All routines compute several output samples per vector and accumulate the
+// taps in the same order as the plain C routines, so the results are
+// bit-exact with them.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "FIRFilter.h"
+
+FIRFilterSIMD::FIRFilterSIMD() : FIRFilter()
+{
+    filterCoeffsAlign = NULL;
+    filterCoeffsUnalign = NULL;
+}
+
+
+FIRFilterSIMD::~FIRFilterSIMD()
+{
+    delete[] filterCoeffsUnalign;
+    filterCoeffsAlign = NULL;
+    filterCoeffsUnalign = NULL;
+}
+
+
+// (overloaded) Calculates filter coefficients for SIMD128 routine
+void FIRFilterSIMD::setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor)
+{
+    uint i;
+
+    FIRFilter::setCoefficients(coeffs, newLength, uResultDivFactor);
+
+    // Ensure that filter coeffs array is aligned to 16-byte boundary
+    delete[] filterCoeffsUnalign;
+    filterCoeffsUnalign = new float[4 * newLength + 4];
+    filterCoeffsAlign = (float *)SOUNDTOUCH_ALIGN_POINTER_16(filterCoeffsUnalign);
+
+    // Interleave each (already scaled) coefficient to 4 lanes, so that the
+    // filter routines load one ready vector per tap
+    for (i = 0; i < newLength; i ++)
+    {
+        wasm_v128_store(filterCoeffsAlign + 4 * i, wasm_f32x4_splat(filterCoeffs[i]));
+    }
+}
+
+
+// SIMD128-optimized version of the filter routine for mono sound
+uint FIRFilterSIMD::evaluateFilterMono(float *dest, const float *src, uint numSamples) const
+{
+    int j, end;
+    int ilength = length & -8;
+
+    assert((length != 0) && (length == ilength) && (src != NULL) && (dest != NULL) && (filterCoeffsAlign != NULL));
+
+    end = numSamples - ilength;
+
+    // 8 output samples per round
+    for (j = 0; j + 8 <= end; j += 8)
+    {
+        const float *pSrc = src + j;
+        v128_t vSum0 = wasm_f32x4_splat(0);
+        v128_t vSum1 = wasm_f32x4_splat(0);
+
+        for (int i = 0; i < ilength; i ++)
+        {
+            v128_t vCoef = wasm_v128_load(filterCoeffsAlign + 4 * i);
+
+            vSum0 = wasm_f32x4_add(vSum0, wasm_f32x4_mul(wasm_v128_load(pSrc + i), vCoef));
+            vSum1 = wasm_f32x4_add(vSum1, wasm_f32x4_mul(wasm_v128_load(pSrc + i + 4), vCoef));
+        }
+
+        wasm_v128_store(dest + j, vSum0);
+        wasm_v128_store(dest + j + 4, vSum1);
+    }
+
+    // remaining output samples
+    for (; j < end; j ++)
+    {
+        const float *pSrc = src + j;
+        float sum = 0;
+
+        for (int i = 0; i < ilength; i ++)
+        {
+            sum += pSrc[i] * filterCoeffs[i];
+        }
+        dest[j] = sum;
+    }
+    return end;
+}
+
+
+// SIMD128-optimized version of the filter routine for stereo sound
+uint FIRFilterSIMD::evaluateFilterStereo(float *dest, const float *src, uint numSamples) const
+{
+    int j, end;
+    int ilength = length & -8;
+
+    assert((length != 0) && (length == ilength) && (src != NULL) && (dest != NULL) && (filterCoeffsAlign != NULL));
+
+    end = 2 * (numSamples - ilength);
+
+    // 4 stereo output frames per round, one vector holds 2 interleaved frames
+    for (j = 0; j + 8 <= end; j += 8)
+    {
+        const float *pSrc = src + j;
+        v128_t vSum0 = wasm_f32x4_splat(0);
+        v128_t vSum1 = wasm_f32x4_splat(0);
+
+        for (int i = 0; i < ilength; i ++)
+        {
+            v128_t vCoef = wasm_v128_load(filterCoeffsAlign + 4 * i);
+
+            vSum0 = wasm_f32x4_add(vSum0, wasm_f32x4_mul(wasm_v128_load(pSrc + 2 * i), vCoef));
+            vSum1 = wasm_f32x4_add(vSum1, wasm_f32x4_mul(wasm_v128_load(pSrc + 2 * i + 4), vCoef));
+        }
+
+        wasm_v128_store(dest + j, vSum0);
+        wasm_v128_store(dest + j + 4, vSum1);
+    }
+
+    // remaining output frames
+    for (; j < end; j += 2)
+    {
+        const float *pSrc = src + j;
+        float suml = 0;
+        float sumr = 0;
+
+        for (int i = 0; i < ilength; i ++)
+        {
+            suml += pSrc[2 * i] * filterCoeffsStereo[2 * i];
+            sumr += pSrc[2 * i + 1] * filterCoeffsStereo[2 * i + 1];
+        }
+        dest[j] = suml;
+        dest[j + 1] = sumr;
+    }
+    return numSamples - ilength;
+}
+
+
+// SIMD128-optimized version of the filter routine for multichannel sound
+uint FIRFilterSIMD::evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels)
+{
+    int j, end;
+    int ilength = length & -8;
+
+    assert((length != 0) && (src != NULL) && (dest != NULL) && (filterCoeffsAlign != NULL));
+
+    end = numChannels * (numSamples - ilength);
+
+    // channels of one output frame are contiguous, process them 4 at a time
+    for (j = 0; j < end; j += numChannels)
+    {
+        const float *pSrc = src + j;
+        uint c = 0;
+
+        for (; c + 4 <= numChannels; c += 4)
+        {
+            v128_t vSum = wasm_f32x4_splat(0);
+
+            for (int i = 0; i < ilength; i ++)
+            {
+                vSum = wasm_f32x4_add(vSum, wasm_f32x4_mul(
+                    wasm_v128_load(pSrc + i * numChannels + c),
+                    wasm_v128_load(filterCoeffsAlign + 4 * i)
+                ));
+            }
+            wasm_v128_store(dest + j + c, vSum);
+        }
+        for (; c < numChannels; c ++)
+        {
+            float sum = 0;
+
+            for (int i = 0; i < ilength; i ++)
+            {
+                sum += pSrc[i * numChannels + c] * filterCoeffs[i];
+            }
+            dest[j + c] = sum;
+        }
+    }
+    return numSamples - ilength;
+}
+
+#endif // SOUNDTOUCH_ALLOW_WASM_SIMD
@@ -102,3 +102,132 @@ EM_PORT_API(void) stretchpitch_destroy() {
   delete st;
 }
 
+
+/**
+ * 基于句柄的接口，每个句柄是一个独立的 SoundTouch 实例，同一个 wasm 实例中可以创建多个
+ * 
+ * 一个实例同时处理所有声道，声道之间共用一次 WSOLA 搜索，不会产生相位漂移
+ */
+typedef struct StretchPitchContext {
+  soundtouch::SoundTouch* st;
+} StretchPitchContext;
+
+EM_PORT_API(StretchPitchContext*) stretchpitch_create() {
+  StretchPitchContext* context = new StretchPitchContext();
+  context->st = new soundtouch::SoundTouch();
+  return context;
+}
+
+EM_PORT_API(void) stretchpitch_context_set_channels(StretchPitchContext* context, int channels) {
+  context->st->setChannels(channels);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_samplerate(StretchPitchContext* context, int sampleRate) {
+  context->st->setSampleRate(sampleRate);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_rate(StretchPitchContext* context, double rate) {
+  context->st->setRate(rate);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_rate_change(StretchPitchContext* context, double change) {
+  context->st->setRateChange(change);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_tempo(StretchPitchContext* context, double tempo) {
+  context->st->setTempo(tempo);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_tempo_change(StretchPitchContext* context, double change) {
+  context->st->setTempoChange(change);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_pitch(StretchPitchContext* context, double pitch) {
+  context->st->setPitch(pitch);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_pitch_octaves(StretchPitchContext* context, double newPitch) {
+  context->st->setPitchOctaves(newPitch);
+}
+
+EM_PORT_API(void) stretchpitch_context_set_pitch_semi_tones(StretchPitchContext* context, double newPitch) {
+  context->st->setPitchSemiTones(newPitch);
+}
+
+/**
+ * 开启或关闭 WSOLA 的快速搜索，快速搜索先粗略步进再在最优位置附近细化，计算量小很多，音质略有下降
+ */
+EM_PORT_API(void) stretchpitch_context_set_quick_seek(StretchPitchContext* context, int enable) {
+  context->st->setSetting(SETTING_USE_QUICKSEEK, enable);
+}
+
+/**
+ * 设置 WSOLA 的处理参数，单位毫秒
+ * 
+ * sequenceMs 和 seekWindowMs 传 0 表示根据 tempo 自动计算，传负数表示保持不变
+ */
+EM_PORT_API(void) stretchpitch_context_set_parameters(StretchPitchContext* context, int sequenceMs, int seekWindowMs, int overlapMs) {
+  context->st->setSetting(SETTING_SEQUENCE_MS, sequenceMs);
+  context->st->setSetting(SETTING_SEEKWINDOW_MS, seekWindowMs);
+  context->st->setSetting(SETTING_OVERLAP_MS, overlapMs);
+}
+
+/**
+ * 送入交错格式的采样
+ */
+EM_PORT_API(void) stretchpitch_context_send_samples(StretchPitchContext* context, float* input, int nSamples) {
+  context->st->putSamples(input, nSamples);
+}
+
+/**
+ * 取出交错格式的采样
+ */
+EM_PORT_API(int) stretchpitch_context_receive_samples(StretchPitchContext* context, float* output, int maxSamples) {
+  return context->st->receiveSamples(output, maxSamples);
+}
+
+/**
+ * 送入平面格式的采样，input 为每个声道的数据指针
+ * 
+ * 采样直接交错写入 soundtouch 的内部缓冲区，不经过中间缓冲
+ */
+EM_PORT_API(void) stretchpitch_context_send_planar_samples(StretchPitchContext* context, float** input, int nSamples) {
+  context->st->putSamplesPlanar(input, nSamples);
+}
+
+/**
+ * 取出平面格式的采样，写到每个声道 offset 开始的位置
+ * 
+ * 直接从 soundtouch 的输出缓冲区解交错，不经过中间缓冲
+ */
+EM_PORT_API(int) stretchpitch_context_receive_planar_samples(StretchPitchContext* context, float** output, int offset, int maxSamples) {
+  return context->st->receiveSamplesPlanar(output, maxSamples, offset);
+}
+
+EM_PORT_API(void) stretchpitch_context_flush(StretchPitchContext* context) {
+  context->st->flush();
+}
+
+EM_PORT_API(void) stretchpitch_context_clear(StretchPitchContext* context) {
+  context->st->clear();
+}
+
+EM_PORT_API(int) stretchpitch_context_get_unprocessed_samples_num(StretchPitchContext* context) {
+  return context->st->numUnprocessedSamples();
+}
+
+EM_PORT_API(int) stretchpitch_context_get_input_output_sample_ratio(StretchPitchContext* context) {
+  return context->st->getInputOutputSampleRatio();
+}
+
+EM_PORT_API(int) stretchpitch_context_get_latency(StretchPitchContext* context) {
+  return context->st->getSetting(SETTING_INITIAL_LATENCY);
+}
+
+EM_PORT_API(void) stretchpitch_context_destroy(StretchPitchContext* context) {
+  if (context) {
+    context->st->clear();
+    delete context->st;
+    delete context;
+  }
+}
@@ -1,5 +1,6 @@
 export {
   default as StretchPitcher,
+  StretchPitchQuality,
   type StretchPitchOptions,
   type StretchPitchParameters
 } from './StretchPitcher'
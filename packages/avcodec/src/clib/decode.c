@@ -1,16 +1,56 @@
 #include "config.h"
 #include "wasmenv.h"
 #include "./logger/log.h"
+#include "./stats/stats.h"
 #include <wasmatomic.h>
 
 #include <libavcodec/avcodec.h>
 #include <libavutil/frame.h>
 #include <libavutil/buffer.h>
 #include <libavutil/rational.h>
+#include <libavutil/channel_layout.h>
+#include <libswresample/swresample.h>
 
 #include <wasmpthread.h>
 
-static AVCodecContext* dec_ctx;
+typedef struct DecoderContext {
+  AVCodecContext* dec_ctx;
+  /**
+   * FF_THREAD_FRAME | FF_THREAD_SLICE 的组合，0 使用 ffmpeg 默认
+   */
+  int thread_type;
+  /**
+   * 快速解码等级，重新打开解码器时保持
+   */
+  int fast_decode;
+  /**
+   * 调用统计，js 侧分配，为 NULL 时不统计
+   */
+  CodecStats* stats;
+  /**
+   * 音频输出参数，sample_rate 为 0 时直接输出解码器的格式
+   * 
+   * 设置之后解码出的音频在这里转换成 planar float 的目标采样率和声道数，js 侧不需要再经过 resample 模块
+   */
+  int out_sample_rate;
+  AVChannelLayout out_ch_layout;
+  SwrContext* swr_ctx;
+  /**
+   * 转换之前的解码帧
+   */
+  AVFrame* audio_frame;
+  /**
+   * swr_ctx 当前的输入参数，解码器输出参数变化时重建
+   */
+  int swr_in_format;
+  int swr_in_sample_rate;
+  AVChannelLayout swr_in_ch_layout;
+} DecoderContext;
+
+/**
+ * 旧的无句柄接口使用的默认解码器上下文
+ */
+static DecoderContext default_decoder;
 
 struct AVBuffer {
   uint8_t *data; /**< data described by this buffer */
@@ -42,7 +82,35 @@ struct AVBuffer {
   int flags_internal;
 };
 
-int open_codec_context(AVCodecContext** dec_ctx, enum AVCodecID codec_id, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
+static void apply_fast_decode(AVCodecContext* dec_ctx, int level) {
+
+  if (!dec_ctx) {
+    return;
+  }
+
+  switch (level) {
+    // 跳过非参考帧的环路滤波，画质损失很小
+    case 1:
+      dec_ctx->skip_loop_filter = AVDISCARD_NONREF;
+      dec_ctx->skip_idct = AVDISCARD_DEFAULT;
+      dec_ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+      break;
+    // 跳过所有帧的环路滤波和非参考帧的 idct，用于高倍速和缩略图
+    case 2:
+    case 3:
+      dec_ctx->skip_loop_filter = AVDISCARD_ALL;
+      dec_ctx->skip_idct = AVDISCARD_NONREF;
+      dec_ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+      break;
+    default:
+      dec_ctx->skip_loop_filter = AVDISCARD_DEFAULT;
+      dec_ctx->skip_idct = AVDISCARD_DEFAULT;
+      dec_ctx->flags2 &= ~AV_CODEC_FLAG2_FAST;
+      break;
+  }
+}
+
+int open_codec_context(DecoderContext* decoder, AVCodecContext** dec_ctx, enum AVCodecID codec_id, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
 
   int ret;
 
@@ -72,9 +140,17 @@ int open_codec_context(AVCodecContext** dec_ctx, enum AVCodecID codec_id, AVCode
   }
   (*dec_ctx)->flags2 |= AV_CODEC_FLAG2_SHOW_ALL;
 
+  apply_fast_decode(*dec_ctx, decoder->fast_decode);
+  // lowres 会改变输出分辨率，只在打开时生效
+  if (decoder->fast_decode >= 3 && dec->max_lowres > 0) {
+    (*dec_ctx)->lowres = 1;
+  }
+
   if (wasm_pthread_support()) {
     if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-      // (*dec_ctx)->thread_type = FF_THREAD_SLICE;
+      if (decoder->thread_type) {
+        (*dec_ctx)->thread_type = decoder->thread_type;
+      }
       (*dec_ctx)->thread_count = thread_count;
     }
   }
@@ -93,16 +169,151 @@ int open_codec_context(AVCodecContext** dec_ctx, enum AVCodecID codec_id, AVCode
   return 0;
 }
 
-int receive_frame(const AVFrame* frame) {
+static void audio_output_reset(DecoderContext* decoder) {
+  swr_free(&decoder->swr_ctx);
+  av_channel_layout_uninit(&decoder->swr_in_ch_layout);
+  decoder->swr_in_format = AV_SAMPLE_FMT_NONE;
+  decoder->swr_in_sample_rate = 0;
+}
+
+/**
+ * 把 decoder->audio_frame 转换成输出格式写入 frame
+ * 
+ * 返回输出的采样数，重采样刚开始时可能为 0
+ */
+static int audio_output_convert(DecoderContext* decoder, AVFrame* frame) {
+  int ret;
+  int64_t out_pts = AV_NOPTS_VALUE;
+  AVFrame* in = decoder->audio_frame;
+  AVRational time_base = decoder->dec_ctx->pkt_timebase;
+
+  av_frame_unref(frame);
+
+  if (decoder->swr_ctx
+    && (in->format != decoder->swr_in_format
+      || in->sample_rate != decoder->swr_in_sample_rate
+      || av_channel_layout_compare(&in->ch_layout, &decoder->swr_in_ch_layout)
+    )
+  ) {
+    audio_output_reset(decoder);
+  }
+
+  // 已经是目标格式直接输出
+  if (!decoder->swr_ctx
+    && in->format == AV_SAMPLE_FMT_FLTP
+    && in->sample_rate == decoder->out_sample_rate
+    && !av_channel_layout_compare(&in->ch_layout, &decoder->out_ch_layout)
+  ) {
+    av_frame_move_ref(frame, in);
+    return frame->nb_samples;
+  }
+
+  if (!decoder->swr_ctx) {
+    ret = swr_alloc_set_opts2(
+      &decoder->swr_ctx,
+      &decoder->out_ch_layout,
+      AV_SAMPLE_FMT_FLTP,
+      decoder->out_sample_rate,
+      &in->ch_layout,
+      in->format,
+      in->sample_rate,
+      0,
+      NULL
+    );
+    if (ret < 0 || (ret = swr_init(decoder->swr_ctx)) < 0) {
+      format_log(ERROR, "Failed to init audio output resampler (%s)\n", av_err2str(ret));
+      audio_output_reset(decoder);
+      av_frame_unref(in);
+      return ret;
+    }
+    decoder->swr_in_format = in->format;
+    decoder->swr_in_sample_rate = in->sample_rate;
+    av_channel_layout_copy(&decoder->swr_in_ch_layout, &in->ch_layout);
+  }
+
+  frame->format = AV_SAMPLE_FMT_FLTP;
+  frame->sample_rate = decoder->out_sample_rate;
+  av_channel_layout_copy(&frame->ch_layout, &decoder->out_ch_layout);
+
+  // 在送入这一帧之前按重采样器中缓存的采样计算输出时间戳，和 ffmpeg aresample 的算法一致
+  if (in->pts != AV_NOPTS_VALUE && time_base.num && time_base.den) {
+    int64_t in_pts = av_rescale(in->pts, (int64_t)time_base.num * decoder->out_sample_rate * in->sample_rate, time_base.den);
+    out_pts = swr_next_pts(decoder->swr_ctx, in_pts);
+  }
+
+  ret = swr_convert_frame(decoder->swr_ctx, frame, in);
+  if (ret < 0) {
+    format_log(ERROR, "Error converting audio frame (%s)\n", av_err2str(ret));
+    av_frame_unref(in);
+    av_frame_unref(frame);
+    return ret;
+  }
+
+  av_frame_copy_props(frame, in);
+
+  if (out_pts != AV_NOPTS_VALUE) {
+    frame->pts = av_rescale_q(
+      (out_pts + in->sample_rate / 2) / in->sample_rate,
+      (AVRational){1, decoder->out_sample_rate},
+      time_base
+    );
+    frame->duration = av_rescale_q(frame->nb_samples, (AVRational){1, decoder->out_sample_rate}, time_base);
+  }
+
+  av_frame_unref(in);
+
+  if (!frame->nb_samples) {
+    av_frame_unref(frame);
+    return 0;
+  }
+
+  return frame->nb_samples;
+}
+
+int receive_frame(DecoderContext* decoder, AVFrame* frame) {
   // get all the available frames from the decoder
   int ret = 0;
 
-  ret = avcodec_receive_frame(dec_ctx, frame);
+  if (decoder->out_sample_rate && decoder->dec_ctx->codec_type == AVMEDIA_TYPE_AUDIO) {
+    // 转换之后没有输出的帧继续取下一帧，保证解码器中的帧都被取出
+    while (1) {
+      int nb_samples;
+
+      CODEC_STATS_START(start);
+
+      ret = avcodec_receive_frame(decoder->dec_ctx, decoder->audio_frame);
+
+      CODEC_STATS_ADD_TIME(decoder->stats, receive_time, start);
+      CODEC_STATS_RESULT(decoder->stats, ret);
+
+      if (ret < 0) {
+        break;
+      }
+
+      nb_samples = audio_output_convert(decoder, frame);
+      if (nb_samples < 0) {
+        return nb_samples;
+      }
+      if (nb_samples > 0) {
+        break;
+      }
+    }
+  }
+  else {
+    CODEC_STATS_START(start);
+
+    ret = avcodec_receive_frame(decoder->dec_ctx, frame);
+
+    CODEC_STATS_ADD_TIME(decoder->stats, receive_time, start);
+    CODEC_STATS_RESULT(decoder->stats, ret);
+  }
 
   if (ret < 0) {
 
     if (ret == AVERROR_EOF) {
-      avcodec_flush_buffers(dec_ctx);
+      avcodec_flush_buffers(decoder->dec_ctx);
+      // 重采样器中剩余的不足一帧的采样丢弃，下一段从干净的状态开始
+      audio_output_reset(decoder);
     }
     // those two return values are special and mean there is no output
     // frame available, but there were no errors during decoding
@@ -115,14 +326,43 @@ int receive_frame(const AVFrame* frame) {
     return ret;
   }
 
+  CODEC_STATS_ADD(decoder->stats, frames_out, 1);
+  CODEC_STATS_ADD(decoder->stats, bytes_out, codec_stats_frame_size(frame));
+
   return 1;
 }
 
+static int send_packet(DecoderContext* decoder, const AVPacket* packet) {
+  int ret;
+
+  // open 时没有传入时间基的用 packet 的时间基，音频输出转换按它计算减去重采样延迟之后的 pts
+  if (packet
+    && !decoder->dec_ctx->pkt_timebase.num
+    && packet->time_base.num
+    && packet->time_base.den
+  ) {
+    decoder->dec_ctx->pkt_timebase = packet->time_base;
+  }
+
+  CODEC_STATS_START(start);
+
+  ret = avcodec_send_packet(decoder->dec_ctx, packet);
+
+  CODEC_STATS_ADD_TIME(decoder->stats, send_time, start);
+  CODEC_STATS_RESULT(decoder->stats, ret);
+
+  if (packet && ret >= 0) {
+    CODEC_STATS_ADD(decoder->stats, frames_in, 1);
+    CODEC_STATS_ADD(decoder->stats, bytes_in, packet->size);
+  }
+
+  return ret;
+}
 
-int decode_packet(const AVPacket* packet) {
+int decode_packet(DecoderContext* decoder, const AVPacket* packet) {
   int ret;
   // submit the packet to the decoder
-  ret = avcodec_send_packet(dec_ctx, packet);
+  ret = send_packet(decoder, packet);
 
   if (ret < 0) {
     format_log(ERROR, "Error submitting a packet for decoding (%s)\n", av_err2str(ret));
@@ -131,35 +371,275 @@ int decode_packet(const AVPacket* packet) {
   return 0;
 }
 
-EM_PORT_API(int) decoder_open(AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
+/**
+ * 送入 n 个 packet 并把所有可取出的帧写入 out，最多 max_out 个
+ * 
+ * 已送入解码器的 packet 在 pkts 中置为 NULL，out 写满时剩余的 packet 保持原样，由调用方下一次再送入
+ * 出错时出错的 packet 同样置为 NULL（丢弃），之后的 packet 保持原样，调用方可以继续送入
+ * 
+ * 输出的帧数写入 nb_out，出错时为出错之前已经输出的帧数
+ * 
+ * 成功返回 0，出错返回负数；返回 AVERROR(EAGAIN) 时没有 packet 被丢弃，未置为 NULL 的 packet 需要重新送入
+ */
+int decode_batch(DecoderContext* decoder, AVPacket** pkts, int n, AVFrame** out, int max_out, int* nb_out) {
+  int ret;
+  int i;
+  int nb_frames = 0;
+
+  for (i = 0; i < n; i++) {
+    if (!pkts[i]) {
+      continue;
+    }
+    if (pkts[i]->buf) {
+      pkts[i]->buf->buffer->free = av_buffer_default_free;
+    }
+
+    while (1) {
+      ret = send_packet(decoder, pkts[i]);
+      if (ret != AVERROR(EAGAIN)) {
+        break;
+      }
+      // 解码器输出队列已满，先取出帧再重新送入
+      if (nb_frames == max_out) {
+        *nb_out = nb_frames;
+        return 0;
+      }
+      ret = receive_frame(decoder, out[nb_frames]);
+      if (ret < 0) {
+        goto fail;
+      }
+      if (ret == 0) {
+        // 输入队列已满却取不出帧，当前和之后的 packet 保持原样，由调用方重新送入
+        *nb_out = nb_frames;
+        return AVERROR(EAGAIN);
+      }
+      nb_frames++;
+    }
+
+    if (ret < 0) {
+      format_log(ERROR, "Error submitting a packet for decoding (%s)\n", av_err2str(ret));
+      goto fail;
+    }
+
+    pkts[i] = NULL;
+
+    while (nb_frames < max_out) {
+      ret = receive_frame(decoder, out[nb_frames]);
+      if (ret < 0) {
+        goto fail;
+      }
+      if (ret == 0) {
+        break;
+      }
+      nb_frames++;
+    }
+  }
+
+  *nb_out = nb_frames;
+  return 0;
+
+fail:
+  pkts[i] = NULL;
+  *nb_out = nb_frames;
+  return ret;
+}
+
+void decoder_init(DecoderContext* decoder) {
+  decoder->swr_in_format = AV_SAMPLE_FMT_NONE;
+}
+
+EM_PORT_API(DecoderContext*) decoder_create() {
+  DecoderContext* decoder = av_mallocz(sizeof(DecoderContext));
+  if (decoder) {
+    decoder_init(decoder);
+  }
+  return decoder;
+}
+
+EM_PORT_API(int) decoder_context_open(DecoderContext* decoder, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
   // setLogLevel(DEBUG);
-  return open_codec_context(&dec_ctx, codecpar->codec_id, codecpar, time_base, thread_count, opts);
+  return open_codec_context(decoder, &decoder->dec_ctx, codecpar->codec_id, codecpar, time_base, thread_count, opts);
 }
 
-EM_PORT_API(int) decoder_decode(AVPacket* packet) {
+EM_PORT_API(int) decoder_context_decode(DecoderContext* decoder, AVPacket* packet) {
   if (packet->buf) {
     packet->buf->buffer->free = av_buffer_default_free;
   }
-  return decode_packet(packet);
+  return decode_packet(decoder, packet);
+}
+
+EM_PORT_API(int) decoder_context_flush(DecoderContext* decoder) {
+  // flush 之后是新的一段，重采样器缓存的采样和 pts 延迟补偿从头开始
+  audio_output_reset(decoder);
+  return decode_packet(decoder, NULL);
+}
+
+EM_PORT_API(int) decoder_context_decode_batch(DecoderContext* decoder, AVPacket** pkts, int n, AVFrame** out, int max_out, int* nb_out) {
+  return decode_batch(decoder, pkts, n, out, max_out, nb_out);
+}
+
+EM_PORT_API(int) decoder_context_receive(DecoderContext* decoder, AVFrame* frame) {
+  return receive_frame(decoder, frame);
+}
+
+EM_PORT_API(void) decoder_context_close(DecoderContext* decoder) {
+  if (decoder->dec_ctx) {
+    avcodec_free_context(&decoder->dec_ctx);
+    decoder->dec_ctx = NULL;
+  }
+  audio_output_reset(decoder);
+  av_frame_free(&decoder->audio_frame);
+  // 输出参数随解码器一起失效，重新打开之后需要重新设置
+  decoder->out_sample_rate = 0;
+  av_channel_layout_uninit(&decoder->out_ch_layout);
+}
+
+EM_PORT_API(int) decoder_context_discard(DecoderContext* decoder, enum AVDiscard discard) {
+  if (decoder->dec_ctx) {
+    decoder->dec_ctx->skip_frame = discard;
+  }
+  return 0;
+}
+
+/**
+ * 设置快速解码等级，解码过程中可随时切换
+ * 
+ * 0 关闭，1 跳过非参考帧环路滤波，2 跳过全部环路滤波和非参考帧 idct
+ * 3 在 2 的基础上于下次打开时使用 lowres（编解码器支持时），输出分辨率减半
+ */
+EM_PORT_API(void) decoder_context_set_fast_decode(DecoderContext* decoder, int level) {
+  decoder->fast_decode = level;
+  apply_fast_decode(decoder->dec_ctx, level);
+}
+
+/**
+ * 设置调用统计的输出位置，stats 由调用方分配，解码器关闭之后不再写入
+ * 
+ * @return 编译时开启了 ENABLE_CODEC_STATS 返回 1，否则返回 0
+ */
+EM_PORT_API(int) decoder_context_set_stats(DecoderContext* decoder, CodecStats* stats) {
+  decoder->stats = stats;
+  return ENABLE_CODEC_STATS;
+}
+
+/**
+ * 设置音频输出为 planar float 的指定采样率和声道数，sample_rate 为 0 时取消，输出解码器原始格式
+ * 
+ * 输出帧的 pts 已经减去重采样器缓存的延迟，时间基取 open 传入的 time_base，没有传入时取第一个 packet 的 time_base
+ * 
+ * 需要在 open 之后调用
+ */
+EM_PORT_API(int) decoder_context_set_audio_output(DecoderContext* decoder, int sample_rate, int channels) {
+  audio_output_reset(decoder);
+  av_channel_layout_uninit(&decoder->out_ch_layout);
+  decoder->out_sample_rate = 0;
+
+  if (sample_rate <= 0 || channels <= 0) {
+    return 0;
+  }
+  if (!decoder->dec_ctx || decoder->dec_ctx->codec_type != AVMEDIA_TYPE_AUDIO) {
+    return AVERROR(EINVAL);
+  }
+  if (!decoder->audio_frame) {
+    decoder->audio_frame = av_frame_alloc();
+    if (!decoder->audio_frame) {
+      return AVERROR(ENOMEM);
+    }
+  }
+
+  av_channel_layout_default(&decoder->out_ch_layout, channels);
+  decoder->out_sample_rate = sample_rate;
+
+  return 0;
+}
+
+EM_PORT_API(void) decoder_context_set_thread_type(DecoderContext* decoder, int thread_type) {
+  decoder->thread_type = thread_type;
+}
+
+/**
+ * 解码器输出相对输入的延迟帧数
+ * 
+ * 帧线程每多一个线程多延迟一帧，再加上 B 帧重排序需要缓存的帧数
+ */
+EM_PORT_API(int) decoder_context_get_delay(DecoderContext* decoder) {
+  int delay = 0;
+  if (decoder->dec_ctx) {
+    delay = decoder->dec_ctx->has_b_frames;
+    if (decoder->dec_ctx->active_thread_type & FF_THREAD_FRAME) {
+      delay += decoder->dec_ctx->thread_count - 1;
+    }
+  }
+  return delay;
+}
+
+EM_PORT_API(int) decoder_context_get_thread_type(DecoderContext* decoder) {
+  if (decoder->dec_ctx) {
+    return decoder->dec_ctx->active_thread_type;
+  }
+  return 0;
+}
+
+EM_PORT_API(void) decoder_destroy(DecoderContext* decoder) {
+  if (decoder) {
+    decoder_context_close(decoder);
+    av_free(decoder);
+  }
+}
+
+EM_PORT_API(int) decoder_open(AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
+  static int default_decoder_inited = 0;
+  if (!default_decoder_inited) {
+    decoder_init(&default_decoder);
+    default_decoder_inited = 1;
+  }
+  return decoder_context_open(&default_decoder, codecpar, time_base, thread_count, opts);
+}
+
+EM_PORT_API(int) decoder_decode(AVPacket* packet) {
+  return decoder_context_decode(&default_decoder, packet);
 }
 
 EM_PORT_API(int) decoder_flush() {
-  return decode_packet(NULL);
+  return decoder_context_flush(&default_decoder);
+}
+
+EM_PORT_API(int) decoder_decode_batch(AVPacket** pkts, int n, AVFrame** out, int max_out, int* nb_out) {
+  return decoder_context_decode_batch(&default_decoder, pkts, n, out, max_out, nb_out);
 }
 
 EM_PORT_API(int) decoder_receive(AVFrame* frame) {
-  return receive_frame(frame);
+  return decoder_context_receive(&default_decoder, frame);
 }
 
 EM_PORT_API(void) decoder_close() {
-  if (dec_ctx) {
-    avcodec_free_context(&dec_ctx);
-    dec_ctx = NULL;
-  }
+  decoder_context_close(&default_decoder);
 }
 
 EM_PORT_API(int) decoder_discard(enum AVDiscard discard) {
-  if (dec_ctx) {
-    dec_ctx->skip_frame = discard;
-  }
+  return decoder_context_discard(&default_decoder, discard);
+}
+
+EM_PORT_API(int) decoder_set_audio_output(int sample_rate, int channels) {
+  return decoder_context_set_audio_output(&default_decoder, sample_rate, channels);
+}
+
+EM_PORT_API(void) decoder_set_thread_type(int thread_type) {
+  decoder_context_set_thread_type(&default_decoder, thread_type);
+}
+
+EM_PORT_API(int) decoder_get_delay() {
+  return decoder_context_get_delay(&default_decoder);
+}
+
+EM_PORT_API(int) decoder_get_thread_type() {
+  return decoder_context_get_thread_type(&default_decoder);
+}
+
+EM_PORT_API(int) decoder_set_stats(CodecStats* stats) {
+  return decoder_context_set_stats(&default_decoder, stats);
+}
+
+EM_PORT_API(void) decoder_set_fast_decode(int level) {
+  decoder_context_set_fast_decode(&default_decoder, level);
 }
\ No newline at end of file
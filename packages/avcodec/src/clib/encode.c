@@ -1,19 +1,75 @@
 #include "config.h"
 #include "wasmenv.h"
 #include "./logger/log.h"
+#include "./stats/stats.h"
 #include <wasmatomic.h>
 
 #include <libavcodec/avcodec.h>
 #include <libavutil/opt.h>
+#include <string.h>
+
+#include <wasmpthread.h>
 
 #if MEDIA_TYPE_AUDIO
 #include <libavutil/channel_layout.h>
 #endif
 
-static AVCodecContext* enc_ctx;
-int enc_ctx_max_b_frames = -1;
-int enc_ctx_flags = 0;
-int enc_ctx_flags2 = 0;
+/**
+ * 编码预设，统一映射到各个编码库的码控、lookahead、线程和 tune 参数
+ */
+enum EncoderPreset {
+  // 不做任何设置，使用编码库默认值
+  ENCODER_PRESET_NONE = 0,
+  // 实时（零延时），没有 B 帧和 lookahead，用于直播推流
+  ENCODER_PRESET_REALTIME,
+  // 速度和质量均衡
+  ENCODER_PRESET_BALANCED,
+  // 质量优先，用于离线转码存档
+  ENCODER_PRESET_ARCHIVAL
+};
+
+typedef struct EncoderContext {
+  AVCodecContext* enc_ctx;
+  int max_b_frames;
+  int flags;
+  int flags2;
+  int preset;
+  int64_t rc_max_rate;
+  int rc_buffer_size;
+  /**
+   * 打开时的码率，0 表示没有按码率打开（例如 crf 模式）
+   */
+  int64_t open_bit_rate;
+  /**
+   * 打开时的参数，重新打开编码器时使用
+   */
+  AVCodecParameters* codecpar;
+  AVRational time_base;
+  int thread_count;
+  AVDictionary* opts;
+  /**
+   * 调用统计，js 侧分配，为 NULL 时不统计
+   */
+  CodecStats* stats;
+} EncoderContext;
+
+/**
+ * 旧的无句柄接口使用的默认编码器上下文
+ */
+static EncoderContext default_encoder = {
+  .enc_ctx = NULL,
+  .max_b_frames = -1,
+  .flags = 0,
+  .flags2 = 0,
+  .preset = ENCODER_PRESET_NONE,
+  .rc_max_rate = 0,
+  .rc_buffer_size = 0,
+  .open_bit_rate = 0,
+  .codecpar = NULL,
+  .thread_count = 1,
+  .opts = NULL,
+  .stats = NULL
+};
 
 struct AVBuffer {
   uint8_t *data; /**< data described by this buffer */
@@ -45,7 +101,122 @@ struct AVBuffer {
   int flags_internal;
 };
 
-int open_codec_context(AVCodecContext** enc_ctx, enum AVCodecID codec_id, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
+static void set_preset_opt(AVDictionary** opts, const char* key, const char* value) {
+  // 调用方传入的参数优先
+  av_dict_set(opts, key, value, AV_DICT_DONT_OVERWRITE);
+}
+
+/**
+ * 把预设映射到具体编码库的私有参数上
+ * 
+ * 只写入调用方没有设置过的参数，未识别的编码库只设置 AVCodecContext 上的通用字段
+ */
+static void apply_preset(EncoderContext* encoder, AVCodecContext* enc_ctx, const AVCodec* enc, AVDictionary** opts) {
+  int preset = encoder->preset;
+
+  if (preset == ENCODER_PRESET_NONE) {
+    return;
+  }
+
+  #if MEDIA_TYPE_VIDEO
+  if (preset == ENCODER_PRESET_REALTIME && encoder->max_b_frames < 0) {
+    // B 帧需要等待后面的参考帧，实时模式下禁用（调用方设置过的保持不变）
+    enc_ctx->max_b_frames = 0;
+  }
+
+  if (!strcmp(enc->name, "libx264")) {
+    if (preset == ENCODER_PRESET_REALTIME) {
+      set_preset_opt(opts, "preset", "veryfast");
+      set_preset_opt(opts, "tune", "zerolatency");
+      set_preset_opt(opts, "rc-lookahead", "0");
+    }
+    else if (preset == ENCODER_PRESET_BALANCED) {
+      set_preset_opt(opts, "preset", "faster");
+      set_preset_opt(opts, "rc-lookahead", "20");
+    }
+    else {
+      set_preset_opt(opts, "preset", "slow");
+      set_preset_opt(opts, "rc-lookahead", "40");
+    }
+  }
+  else if (!strcmp(enc->name, "libx265")) {
+    if (preset == ENCODER_PRESET_REALTIME) {
+      set_preset_opt(opts, "preset", "ultrafast");
+      set_preset_opt(opts, "tune", "zerolatency");
+    }
+    else if (preset == ENCODER_PRESET_BALANCED) {
+      set_preset_opt(opts, "preset", "fast");
+    }
+    else {
+      set_preset_opt(opts, "preset", "slow");
+    }
+  }
+  else if (!strcmp(enc->name, "libopenh264")) {
+    if (preset == ENCODER_PRESET_REALTIME) {
+      set_preset_opt(opts, "rc_mode", "bitrate");
+      set_preset_opt(opts, "allow_skip_frames", "1");
+    }
+    else if (preset == ENCODER_PRESET_BALANCED) {
+      set_preset_opt(opts, "rc_mode", "bitrate");
+    }
+    else {
+      set_preset_opt(opts, "rc_mode", "quality");
+    }
+  }
+  else if (!strcmp(enc->name, "libkvazaar")) {
+    if (preset == ENCODER_PRESET_REALTIME) {
+      // owf 会让多帧并行编码，带来额外的延时
+      set_preset_opt(opts, "kvazaar-params", "preset=ultrafast,owf=0");
+    }
+    else if (preset == ENCODER_PRESET_BALANCED) {
+      set_preset_opt(opts, "kvazaar-params", "preset=veryfast");
+    }
+    else {
+      set_preset_opt(opts, "kvazaar-params", "preset=medium");
+    }
+  }
+  else if (!strcmp(enc->name, "libvpx") || !strcmp(enc->name, "libvpx-vp9")) {
+    if (preset == ENCODER_PRESET_REALTIME) {
+      set_preset_opt(opts, "deadline", "realtime");
+      set_preset_opt(opts, "cpu-used", "8");
+      set_preset_opt(opts, "lag-in-frames", "0");
+    }
+    else if (preset == ENCODER_PRESET_BALANCED) {
+      set_preset_opt(opts, "deadline", "good");
+      set_preset_opt(opts, "cpu-used", "4");
+      set_preset_opt(opts, "lag-in-frames", "16");
+    }
+    else {
+      set_preset_opt(opts, "deadline", "good");
+      set_preset_opt(opts, "cpu-used", "1");
+      set_preset_opt(opts, "lag-in-frames", "25");
+    }
+    if (!strcmp(enc->name, "libvpx-vp9")) {
+      set_preset_opt(opts, "row-mt", "1");
+    }
+  }
+  else if (!strcmp(enc->name, "libaom-av1")) {
+    if (preset == ENCODER_PRESET_REALTIME) {
+      set_preset_opt(opts, "usage", "realtime");
+      set_preset_opt(opts, "cpu-used", "8");
+      set_preset_opt(opts, "lag-in-frames", "0");
+    }
+    else if (preset == ENCODER_PRESET_BALANCED) {
+      set_preset_opt(opts, "usage", "good");
+      set_preset_opt(opts, "cpu-used", "6");
+      set_preset_opt(opts, "lag-in-frames", "19");
+    }
+    else {
+      set_preset_opt(opts, "usage", "good");
+      set_preset_opt(opts, "cpu-used", "3");
+      set_preset_opt(opts, "lag-in-frames", "35");
+    }
+    set_preset_opt(opts, "row-mt", "1");
+  }
+  #endif
+}
+
+int open_codec_context(EncoderContext* encoder, AVCodecContext** enc_ctx, enum AVCodecID codec_id, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
 
   int ret;
 
@@ -72,18 +243,33 @@ int open_codec_context(AVCodecContext** enc_ctx, enum AVCodecID codec_id, AVCode
   }
 
   (*enc_ctx)->time_base = *time_base;
-  (*enc_ctx)->flags = enc_ctx_flags;
-  (*enc_ctx)->flags2 = enc_ctx_flags2;
+  (*enc_ctx)->flags = encoder->flags;
+  (*enc_ctx)->flags2 = encoder->flags2;
   (*enc_ctx)->strict_std_compliance = -2;
 
-  if (enc_ctx_max_b_frames > -1) {
-    (*enc_ctx)->max_b_frames = enc_ctx_max_b_frames;
+  if (encoder->max_b_frames > -1) {
+    (*enc_ctx)->max_b_frames = encoder->max_b_frames;
+  }
+  if (encoder->rc_max_rate > 0) {
+    (*enc_ctx)->rc_max_rate = encoder->rc_max_rate;
+  }
+  if (encoder->rc_buffer_size > 0) {
+    (*enc_ctx)->rc_buffer_size = encoder->rc_buffer_size;
   }
 
   #if MEDIA_TYPE_VIDEO
   if (wasm_pthread_support()) {
     if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-      (*enc_ctx)->thread_type = FF_THREAD_SLICE;
+      /**
+       * 片级多线程没有额外的延时，帧级多线程吞吐更高但每个线程会多缓存一帧
+       * 只有非实时的预设才使用帧级多线程
+       */
+      if (encoder->preset == ENCODER_PRESET_BALANCED || encoder->preset == ENCODER_PRESET_ARCHIVAL) {
+        (*enc_ctx)->thread_type = FF_THREAD_FRAME;
+      }
+      else {
+        (*enc_ctx)->thread_type = FF_THREAD_SLICE;
+      }
       (*enc_ctx)->thread_count = thread_count;
     }
   }
@@ -100,19 +286,53 @@ int open_codec_context(AVCodecContext** enc_ctx, enum AVCodecID codec_id, AVCode
   }
   #endif
 
+  apply_preset(encoder, *enc_ctx, enc, opts);
+
   /* Init the encoders */
   if ((ret = avcodec_open2(*enc_ctx, enc, opts)) < 0) {
     format_log(ERROR, "Failed to open %s codec\n", avcodec_get_name(codec_id));
     return ret;
   }
 
+  encoder->open_bit_rate = (*enc_ctx)->bit_rate;
+
   return 0;
 }
 
-int receive_packet(const AVPacket* packet) {
+/**
+ * 编码库是否支持不重新打开直接修改码率和 VBV 参数
+ * 
+ * ffmpeg 的 libx264 封装在每一帧编码前比较 AVCodecContext 上的码率和 VBV 参数，变化时调用 x264_encoder_reconfig
+ * 只有 ABR 码控（打开时设置了码率并且没有指定 crf 或 qp）才会应用新的码率
+ * x264 不能在运行时开启 VBV，打开时没有设置最大码率的不能实时修改最大码率
+ */
+static int support_live_reconfigure(EncoderContext* encoder, int64_t max_rate) {
+  AVCodecContext* enc_ctx = encoder->enc_ctx;
+  double crf = -1;
+  int64_t qp = -1;
+
+  if (strcmp(enc_ctx->codec->name, "libx264") || encoder->open_bit_rate <= 0) {
+    return 0;
+  }
+
+  av_opt_get_double(enc_ctx->priv_data, "crf", 0, &crf);
+  av_opt_get_int(enc_ctx->priv_data, "qp", 0, &qp);
+  if (crf >= 0 || qp >= 0) {
+    return 0;
+  }
+
+  return max_rate <= 0 || enc_ctx->rc_max_rate > 0;
+}
+
+int receive_packet(EncoderContext* encoder, const AVPacket* packet) {
   int ret;
 
-  ret = avcodec_receive_packet(enc_ctx, packet);
+  CODEC_STATS_START(start);
+
+  ret = avcodec_receive_packet(encoder->enc_ctx, packet);
+
+  CODEC_STATS_ADD_TIME(encoder->stats, receive_time, start);
+  CODEC_STATS_RESULT(encoder->stats, ret);
 
   if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
     return 0;
@@ -123,10 +343,13 @@ int receive_packet(const AVPacket* packet) {
     return ret;
   }
 
+  CODEC_STATS_ADD(encoder->stats, frames_out, 1);
+  CODEC_STATS_ADD(encoder->stats, bytes_out, packet->size);
+
   return 1;
 }
 
-int encode_frame(const AVFrame* frame) {
+int encode_frame(EncoderContext* encoder, const AVFrame* frame) {
   int ret;
   int i;
 
@@ -147,7 +370,17 @@ int encode_frame(const AVFrame* frame) {
     }
   }
 
-  ret = avcodec_send_frame(enc_ctx, frame);
+  CODEC_STATS_START(start);
+
+  ret = avcodec_send_frame(encoder->enc_ctx, frame);
+
+  CODEC_STATS_ADD_TIME(encoder->stats, send_time, start);
+  CODEC_STATS_RESULT(encoder->stats, ret);
+
+  if (frame && ret >= 0) {
+    CODEC_STATS_ADD(encoder->stats, frames_in, 1);
+    CODEC_STATS_ADD(encoder->stats, bytes_in, codec_stats_frame_size(frame));
+  }
 
   if (ret < 0) {
     format_log(ERROR, "Error sending a frame for encoding, error: %d\n", ret);
@@ -157,92 +390,372 @@ int encode_frame(const AVFrame* frame) {
   return 0;
 }
 
+void encoder_init(EncoderContext* encoder) {
+  encoder->enc_ctx = NULL;
+  encoder->max_b_frames = -1;
+  encoder->flags = 0;
+  encoder->flags2 = 0;
+  encoder->preset = ENCODER_PRESET_NONE;
+  encoder->rc_max_rate = 0;
+  encoder->rc_buffer_size = 0;
+  encoder->open_bit_rate = 0;
+  encoder->codecpar = NULL;
+  encoder->time_base.num = 0;
+  encoder->time_base.den = 1;
+  encoder->thread_count = 1;
+  encoder->opts = NULL;
+  encoder->stats = NULL;
+}
+
+/**
+ * 创建一个编码器上下文，所有设置都作用在这个上下文上
+ * 
+ * 同一个 wasm 实例中可以创建多个上下文同时编码，例如一次解码输出多个码率
+ */
+EM_PORT_API(EncoderContext*) encoder_create() {
+  EncoderContext* encoder = av_mallocz(sizeof(EncoderContext));
+  if (encoder) {
+    encoder_init(encoder);
+  }
+  return encoder;
+}
+
+EM_PORT_API(int) encoder_context_open(EncoderContext* encoder, AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
+  int ret;
+
+  // 保存一份打开参数，reconfigure 需要重新打开编码器时使用
+  if (!encoder->codecpar) {
+    encoder->codecpar = avcodec_parameters_alloc();
+    if (!encoder->codecpar) {
+      return AVERROR(ENOMEM);
+    }
+  }
+  if ((ret = avcodec_parameters_copy(encoder->codecpar, codecpar)) < 0) {
+    return ret;
+  }
+  encoder->time_base = *time_base;
+  encoder->thread_count = thread_count;
+  av_dict_free(&encoder->opts);
+  if (opts && *opts) {
+    av_dict_copy(&encoder->opts, *opts, 0);
+  }
+
+  return open_codec_context(encoder, &encoder->enc_ctx, codecpar->codec_id, codecpar, time_base, thread_count, opts);
+}
+
+EM_PORT_API(void) encoder_context_set_flags(EncoderContext* encoder, int flags) {
+  encoder->flags = flags;
+}
+
+EM_PORT_API(void) encoder_context_set_flags2(EncoderContext* encoder, int flags) {
+  encoder->flags2 = flags;
+}
+
+EM_PORT_API(void) encoder_context_set_gop_size(EncoderContext* encoder, int gop) {
+  if (encoder->enc_ctx) {
+    encoder->enc_ctx->gop_size = gop;
+  }
+}
+
+#if MEDIA_TYPE_VIDEO 
+EM_PORT_API(void) encoder_context_set_max_b_frame(EncoderContext* encoder, int max) {
+  encoder->max_b_frames = max;
+}
+#endif
+
+/**
+ * 设置编码预设，需要在 open 之前调用
+ */
+EM_PORT_API(void) encoder_context_set_preset(EncoderContext* encoder, int preset) {
+  encoder->preset = preset;
+}
+
+/**
+ * 运行时修改目标码率，不需要重新打开编码器
+ * 
+ * 设置了最大码率（VBV）的按原来的比例一起调整
+ * libx264 按码率打开时会在下一帧编码时通过 x264_encoder_reconfig 生效，其他情况只在打开时读取码率
+ * 
+ * @return 1 已经实时生效，0 需要重新打开编码器才能生效，小于 0 出错
+ */
+EM_PORT_API(int) encoder_context_set_bitrate(EncoderContext* encoder, int bitrate) {
+  AVCodecContext* enc_ctx = encoder->enc_ctx;
+
+  if (!enc_ctx || bitrate <= 0) {
+    return AVERROR(EINVAL);
+  }
+
+  if (enc_ctx->bit_rate > 0 && enc_ctx->rc_max_rate > 0) {
+    enc_ctx->rc_max_rate = av_rescale(enc_ctx->rc_max_rate, bitrate, enc_ctx->bit_rate);
+    // 同步保存的副本，重新打开时和新码率配套
+    encoder->rc_max_rate = enc_ctx->rc_max_rate;
+    if (enc_ctx->rc_buffer_size > 0) {
+      enc_ctx->rc_buffer_size = (int)av_rescale(enc_ctx->rc_buffer_size, bitrate, enc_ctx->bit_rate);
+      encoder->rc_buffer_size = enc_ctx->rc_buffer_size;
+    }
+  }
+  enc_ctx->bit_rate = bitrate;
+  if (encoder->codecpar) {
+    encoder->codecpar->bit_rate = bitrate;
+  }
+
+  return support_live_reconfigure(encoder, 0);
+}
+
+/**
+ * 运行时修改码率、最大码率、VBV 缓冲区大小和分辨率，传 0 的参数保持不变
+ * 
+ * 编码库支持实时修改的（目前是 libx264 的码率和 VBV）在下一帧编码时生效
+ * 其他情况需要调用方先 flush 并取出所有缓存的包，再调用 encoder_context_reopen 用新的参数重新打开编码器
+ * 分辨率的修改 ffmpeg 的所有编码库封装都不支持实时生效，总是需要重新打开
+ * 
+ * @return 1 已经实时生效，0 需要重新打开编码器，小于 0 出错
+ */
+EM_PORT_API(int) encoder_context_reconfigure(EncoderContext* encoder, int bitrate, int max_rate, int buffer_size, int width, int height) {
+  AVCodecContext* enc_ctx = encoder->enc_ctx;
+  int live;
+
+  if (!enc_ctx || !encoder->codecpar) {
+    return AVERROR(EINVAL);
+  }
+
+  live = support_live_reconfigure(encoder, max_rate);
+
+  #if MEDIA_TYPE_VIDEO
+  if ((width > 0 && width != enc_ctx->width) || (height > 0 && height != enc_ctx->height)) {
+    live = 0;
+    if (width > 0) {
+      encoder->codecpar->width = width;
+    }
+    if (height > 0) {
+      encoder->codecpar->height = height;
+    }
+  }
+  #endif
+
+  if (bitrate > 0) {
+    enc_ctx->bit_rate = bitrate;
+    encoder->codecpar->bit_rate = bitrate;
+  }
+  if (max_rate > 0) {
+    enc_ctx->rc_max_rate = max_rate;
+    encoder->rc_max_rate = max_rate;
+  }
+  if (buffer_size > 0) {
+    enc_ctx->rc_buffer_size = buffer_size;
+    encoder->rc_buffer_size = buffer_size;
+  }
+
+  return live;
+}
+
+/**
+ * 使用 open 时保存的参数和 reconfigure 修改之后的参数重新打开编码器
+ * 
+ * 编码器中缓存的帧会被丢弃，调用之前需要先 flush
+ */
+EM_PORT_API(int) encoder_context_reopen(EncoderContext* encoder) {
+  int ret;
+  AVDictionary* opts = NULL;
+
+  if (!encoder->codecpar) {
+    return AVERROR(EINVAL);
+  }
+
+  if (encoder->enc_ctx) {
+    avcodec_free_context(&encoder->enc_ctx);
+    encoder->enc_ctx = NULL;
+  }
+
+  if (encoder->opts) {
+    av_dict_copy(&opts, encoder->opts, 0);
+  }
+
+  ret = open_codec_context(
+    encoder,
+    &encoder->enc_ctx,
+    encoder->codecpar->codec_id,
+    encoder->codecpar,
+    &encoder->time_base,
+    encoder->thread_count,
+    &opts
+  );
+
+  av_dict_free(&opts);
+
+  return ret;
+}
+
+/**
+ * 设置调用统计的输出位置，stats 由调用方分配，编码器关闭之后不再写入
+ * 
+ * @return 编译时开启了 ENABLE_CODEC_STATS 返回 1，否则返回 0
+ */
+EM_PORT_API(int) encoder_context_set_stats(EncoderContext* encoder, CodecStats* stats) {
+  encoder->stats = stats;
+  return ENABLE_CODEC_STATS;
+}
+
+EM_PORT_API(int) encoder_context_encode(EncoderContext* encoder, AVFrame* frame) {
+  return encode_frame(encoder, frame);
+}
+
+EM_PORT_API(int) encoder_context_flush(EncoderContext* encoder) {
+  return encode_frame(encoder, NULL);
+}
+
+EM_PORT_API(int) encoder_context_receive(EncoderContext* encoder, AVPacket* packet) {
+  return receive_packet(encoder, packet);
+}
+
+EM_PORT_API(uint8_t*) encoder_context_get_extradata(EncoderContext* encoder) {
+  if (encoder->enc_ctx) {
+    return encoder->enc_ctx->extradata;
+  }
+  return NULL;
+}
+
+EM_PORT_API(int) encoder_context_get_extradata_size(EncoderContext* encoder) {
+  if (encoder->enc_ctx) {
+    return encoder->enc_ctx->extradata_size;
+  }
+  return 0;
+}
+
+#if MEDIA_TYPE_AUDIO
+EM_PORT_API(int) encoder_context_get_framesize_size(EncoderContext* encoder) {
+  if (encoder->enc_ctx) {
+    return encoder->enc_ctx->frame_size;
+  }
+  return 0;
+}
+#endif
+
+#if MEDIA_TYPE_VIDEO 
+EM_PORT_API(int) encoder_context_get_color_space(EncoderContext* encoder) {
+  if (encoder->enc_ctx) {
+    return encoder->enc_ctx->colorspace;
+  }
+  return 0;
+}
+
+EM_PORT_API(int) encoder_context_get_color_primaries(EncoderContext* encoder) {
+  if (encoder->enc_ctx) {
+    return encoder->enc_ctx->color_primaries;
+  }
+  return 0;
+}
+
+EM_PORT_API(int) encoder_context_get_color_trc(EncoderContext* encoder) {
+  if (encoder->enc_ctx) {
+    return encoder->enc_ctx->color_trc;
+  }
+  return 0;
+}
+#endif
+
+EM_PORT_API(void) encoder_context_close(EncoderContext* encoder) {
+  if (encoder->enc_ctx) {
+    avcodec_free_context(&encoder->enc_ctx);
+    encoder->enc_ctx = NULL;
+  }
+  if (encoder->codecpar) {
+    avcodec_parameters_free(&encoder->codecpar);
+  }
+  av_dict_free(&encoder->opts);
+}
+
+EM_PORT_API(void) encoder_destroy(EncoderContext* encoder) {
+  if (encoder) {
+    encoder_context_close(encoder);
+    av_free(encoder);
+  }
+}
+
 EM_PORT_API(int) encoder_open(AVCodecParameters* codecpar, AVRational* time_base, int thread_count, AVDictionary** opts) {
-  return open_codec_context(&enc_ctx, codecpar->codec_id, codecpar, time_base, thread_count, opts);
+  return encoder_context_open(&default_encoder, codecpar, time_base, thread_count, opts);
 }
 
 EM_PORT_API(void) encoder_set_flags(int flags) {
-  enc_ctx_flags = flags;
+  encoder_context_set_flags(&default_encoder, flags);
 }
 
 EM_PORT_API(void) encoder_set_flags2(int flags) {
-  enc_ctx_flags2 = flags;
+  encoder_context_set_flags2(&default_encoder, flags);
 }
 
 EM_PORT_API(void) encoder_set_gop_size(int gop) {
-  if (enc_ctx) {
-    enc_ctx->gop_size = gop;
-  }
+  encoder_context_set_gop_size(&default_encoder, gop);
 }
 
 #if MEDIA_TYPE_VIDEO 
 EM_PORT_API(void) encoder_set_max_b_frame(int max) {
-  enc_ctx_max_b_frames = max;
+  encoder_context_set_max_b_frame(&default_encoder, max);
 }
 #endif
 
+EM_PORT_API(void) encoder_set_preset(int preset) {
+  encoder_context_set_preset(&default_encoder, preset);
+}
+
+EM_PORT_API(int) encoder_set_bitrate(int bitrate) {
+  return encoder_context_set_bitrate(&default_encoder, bitrate);
+}
+
+EM_PORT_API(int) encoder_reconfigure(int bitrate, int max_rate, int buffer_size, int width, int height) {
+  return encoder_context_reconfigure(&default_encoder, bitrate, max_rate, buffer_size, width, height);
+}
+
+EM_PORT_API(int) encoder_reopen() {
+  return encoder_context_reopen(&default_encoder);
+}
+
+EM_PORT_API(int) encoder_set_stats(CodecStats* stats) {
+  return encoder_context_set_stats(&default_encoder, stats);
+}
+
 EM_PORT_API(int) encoder_encode(AVFrame* frame) {
-  return encode_frame(frame);
+  return encoder_context_encode(&default_encoder, frame);
 }
 
 EM_PORT_API(int) encoder_flush() {
-  return encode_frame(NULL);
+  return encoder_context_flush(&default_encoder);
 }
 
 EM_PORT_API(int) encoder_receive(AVPacket* packet) {
-  return receive_packet(packet);
+  return encoder_context_receive(&default_encoder, packet);
 }
 
 EM_PORT_API(uint8_t*) encoder_get_extradata() {
-  if (enc_ctx) {
-    return enc_ctx->extradata;
-  }
-  return NULL;
+  return encoder_context_get_extradata(&default_encoder);
 }
 
 EM_PORT_API(int) encoder_get_extradata_size() {
-  if (enc_ctx) {
-    return enc_ctx->extradata_size;
-  }
-  return 0;
+  return encoder_context_get_extradata_size(&default_encoder);
 }
 
-
 #if MEDIA_TYPE_AUDIO
 EM_PORT_API(int) encoder_get_framesize_size() {
-  if (enc_ctx) {
-    return enc_ctx->frame_size;
-  }
-  return 0;
+  return encoder_context_get_framesize_size(&default_encoder);
 }
 #endif
 
 #if MEDIA_TYPE_VIDEO 
 EM_PORT_API(int) encoder_get_color_space() {
-  if (enc_ctx) {
-    return enc_ctx->colorspace;
-  }
-  return 0;
+  return encoder_context_get_color_space(&default_encoder);
 }
 
 EM_PORT_API(int) encoder_get_color_primaries() {
-  if (enc_ctx) {
-    return enc_ctx->color_primaries;
-  }
-  return 0;
+  return encoder_context_get_color_primaries(&default_encoder);
 }
 
 EM_PORT_API(int) encoder_get_color_trc() {
-  if (enc_ctx) {
-    return enc_ctx->color_trc;
-  }
-  return 0;
+  return encoder_context_get_color_trc(&default_encoder);
 }
 #endif
 
 EM_PORT_API(void) encoder_close() {
-  if (enc_ctx) {
-    avcodec_free_context(&enc_ctx);
-    enc_ctx = NULL;
-  }
+  encoder_context_close(&default_encoder);
+  // 旧接口下一次打开是新的会话，设置不再沿用
+  encoder_init(&default_encoder);
 }
\ No newline at end of file
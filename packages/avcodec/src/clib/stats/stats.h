@@ -0,0 +1,90 @@
+#ifndef __CODEC_STATS_H__
+
+  #define __CODEC_STATS_H__
+
+  #include <stdint.h>
+  #include "libavutil/error.h"
+
+  #ifndef ENABLE_CODEC_STATS
+    #define ENABLE_CODEC_STATS 0
+  #endif
+
+  /**
+   * 编解码调用统计，内存布局和 avcodec/src/struct/codecstats.ts 中的 CodecStats 保持一致
+   *
+   * 内存由 js 侧分配，通过 *_set_stats 传入，js 直接读取，不需要调用 wasm
+   */
+  typedef struct CodecStats {
+    /**
+     * avcodec_send_packet / avcodec_send_frame 累计耗时（毫秒）
+     */
+    double send_time;
+    /**
+     * avcodec_receive_frame / avcodec_receive_packet 累计耗时（毫秒）
+     */
+    double receive_time;
+    int64_t bytes_in;
+    int64_t bytes_out;
+    int64_t frames_in;
+    int64_t frames_out;
+    int32_t errors;
+    int32_t eagain;
+  } CodecStats;
+
+  #if ENABLE_CODEC_STATS
+    #ifdef __EMSCRIPTEN__
+      #include <emscripten.h>
+      #define codec_stats_now() emscripten_get_now()
+    #else
+      #include <time.h>
+      static inline double codec_stats_now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+      }
+    #endif
+
+    #include "libavutil/frame.h"
+
+    static inline int64_t codec_stats_frame_size(const AVFrame* frame) {
+      int64_t size = 0;
+      int i;
+      for (i = 0; i < AV_NUM_DATA_POINTERS; i++) {
+        if (frame->buf[i]) {
+          size += frame->buf[i]->size;
+        }
+      }
+      return size;
+    }
+
+    #define CODEC_STATS_START(name) double name = codec_stats_now()
+
+    #define CODEC_STATS_ADD_TIME(stats, field, start) \
+      if (stats) { \
+        (stats)->field += codec_stats_now() - (start); \
+      }
+
+    #define CODEC_STATS_ADD(stats, field, value) \
+      if (stats) { \
+        (stats)->field += (value); \
+      }
+
+    /**
+     * 统计调用结果，EAGAIN 和 EOF 不算错误
+     */
+    #define CODEC_STATS_RESULT(stats, ret) \
+      if (stats) { \
+        if ((ret) == AVERROR(EAGAIN)) { \
+          (stats)->eagain++; \
+        } \
+        else if ((ret) < 0 && (ret) != AVERROR_EOF) { \
+          (stats)->errors++; \
+        } \
+      }
+  #else
+    #define CODEC_STATS_START(name)
+    #define CODEC_STATS_ADD_TIME(stats, field, start)
+    #define CODEC_STATS_ADD(stats, field, value)
+    #define CODEC_STATS_RESULT(stats, ret)
+  #endif
+#endif
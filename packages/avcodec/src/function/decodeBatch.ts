@@ -0,0 +1,126 @@
+/*
+ * libmedia wasm decoder batch decode
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import { type AVPacket, type AVFrame, errorType } from '@libmedia/avutil'
+
+export interface DecodeBatchContext {
+  invoke: (method: string, ...args: any[]) => any
+  /**
+   * 复用的输出帧，输出之后对应位置置为 nullptr
+   */
+  frames: pointer<AVFrame>[]
+  allocAVFrame: () => pointer<AVFrame>
+  onReceiveAVFrame: (frame: pointer<AVFrame>) => void
+  /**
+   * packet 已送入解码器（或出错被丢弃）
+   */
+  onConsumed?: (avpacket: pointer<AVPacket>) => void
+}
+
+/**
+ * 批量同步解码
+ * 
+ * 一次 wasm 调用送入多个 avpacket 并取出所有已解码的帧，减少 js 和 wasm 之间的调用次数
+ * 
+ * 出错的 packet 被丢弃，之后的 packet 继续送入，所有 packet 处理完之后返回遇到的第一个错误
+ * 
+ * 解码器不再接收输入时停止送入并返回错误（没有其他错误时为 EAGAIN），
+ * 这时没有通过 onConsumed 通知的 packet 没有送入解码器，调用方需要重新送入
+ * 
+ * @param context 
+ * @param avpackets 
+ * @returns 
+ */
+export default function decodeBatch(context: DecodeBatchContext, avpackets: pointer<AVPacket>[]): int32 {
+  const count = avpackets.length
+
+  if (!count) {
+    return 0
+  }
+
+  // 一个 packet 通常最多输出一帧，多留一个位置给解码器中缓存的帧
+  const maxOut = count + 1
+
+  const packetsP = reinterpret_cast<pointer<pointer<AVPacket>>>(malloc(sizeof(pointer) * static_cast<size>(count)))
+  const framesP = reinterpret_cast<pointer<pointer<AVFrame>>>(malloc(sizeof(pointer) * static_cast<size>(maxOut)))
+  const nbOutP = reinterpret_cast<pointer<int32>>(malloc(sizeof(int32)))
+  const consumed: boolean[] = []
+
+  for (let i = 0; i < count; i++) {
+    packetsP[i] = avpackets[i]
+    consumed[i] = false
+  }
+
+  let error = 0
+  let remain = count
+
+  while (remain) {
+    for (let i = 0; i < maxOut; i++) {
+      if (!context.frames[i]) {
+        context.frames[i] = context.allocAVFrame()
+      }
+      framesP[i] = context.frames[i]
+    }
+
+    accessof(nbOutP) <- 0
+    const ret: int32 = context.invoke('decode_batch', packetsP, count, framesP, maxOut, nbOutP)
+    const nbOut = accessof(nbOutP)
+
+    let progress = nbOut > 0
+    for (let i = 0; i < count; i++) {
+      if (!consumed[i] && !packetsP[i]) {
+        consumed[i] = true
+        remain--
+        progress = true
+        if (context.onConsumed) {
+          context.onConsumed(avpackets[i])
+        }
+      }
+    }
+
+    for (let i = 0; i < nbOut; i++) {
+      context.onReceiveAVFrame(context.frames[i])
+      context.frames[i] = nullptr
+    }
+
+    if (ret < 0 && !error) {
+      error = ret
+    }
+
+    if (!progress) {
+      break
+    }
+  }
+
+  if (remain && !error) {
+    error = errorType.EAGAIN
+  }
+
+  free(packetsP)
+  free(framesP)
+  free(nbOutP)
+
+  return error
+}
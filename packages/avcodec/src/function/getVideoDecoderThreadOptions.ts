@@ -0,0 +1,131 @@
+/*
+ * libmedia get video decoder thread options
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import {
+  type AVCodecParameters,
+  AVCodecID,
+  avQ2D
+} from '@libmedia/avutil'
+
+import {
+  h264,
+  hevc
+} from '@libmedia/avutil/internal'
+
+import { DecoderThreadType } from '../wasmcodec/VideoDecoder'
+
+/**
+ * 1080p30 的像素率，作为单线程解码能力的基准
+ */
+const BASE_PIXEL_RATE = 1920 * 1080 * 30
+
+const MAX_THREAD_COUNT = 8
+
+function getCodecComplexity(codecId: AVCodecID) {
+  switch (codecId) {
+    case AVCodecID.AV_CODEC_ID_HEVC:
+    case AVCodecID.AV_CODEC_ID_VVC:
+    case AVCodecID.AV_CODEC_ID_AV1:
+    case AVCodecID.AV_CODEC_ID_VP9:
+      return 2
+    default:
+      return 1
+  }
+}
+
+function getPixelRate(parameters: pointer<AVCodecParameters>) {
+  const pixels = parameters.width * parameters.height
+  const framerate = avQ2D(parameters.framerate)
+
+  if (framerate > 0 && isFinite(framerate)) {
+    return pixels * framerate
+  }
+
+  // 帧率未知时根据 level 估计
+  if (parameters.level > 0) {
+    if (parameters.codecId === AVCodecID.AV_CODEC_ID_H264) {
+      const capability = h264.LevelCapabilities.find((item) => item.level === parameters.level)
+      if (capability) {
+        return pixels * capability.maxFrameRate
+      }
+    }
+    else if (parameters.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
+      // hevc general_level_idc 为 level 的 30 倍
+      const capability = hevc.LevelCapabilities.find((item) => item.level === parameters.level / 3)
+      if (capability) {
+        return Math.min(capability.maxLumaSamplesPerSecond, pixels * 60)
+      }
+    }
+  }
+
+  return pixels * 30
+}
+
+function getThreadType(codecId: AVCodecID, preferLatency: boolean) {
+  switch (codecId) {
+    // libdav1d 自己管理线程，不受 thread_type 控制
+    case AVCodecID.AV_CODEC_ID_AV1:
+      return DecoderThreadType.AUTO
+    case AVCodecID.AV_CODEC_ID_H264:
+    case AVCodecID.AV_CODEC_ID_HEVC:
+    case AVCodecID.AV_CODEC_ID_VVC:
+    case AVCodecID.AV_CODEC_ID_VP8:
+    case AVCodecID.AV_CODEC_ID_VP9:
+      return preferLatency ? DecoderThreadType.SLICE : DecoderThreadType.FRAME
+    default:
+      return DecoderThreadType.FRAME
+  }
+}
+
+/**
+ * 根据码流的分辨率、帧率（或 level）和 navigator.hardwareConcurrency 计算 wasm 视频解码的线程数和线程类型
+ * 
+ * 点播使用帧线程获得最大吞吐，低延迟直播使用片线程避免帧线程带来的延迟
+ * 
+ * @param parameters 
+ * @param preferLatency 
+ * @returns 
+ */
+export default function getVideoDecoderThreadOptions(parameters: pointer<AVCodecParameters>, preferLatency: boolean = false) {
+  const threadType = getThreadType(parameters.codecId, preferLatency)
+
+  let threadCount = Math.ceil(getCodecComplexity(parameters.codecId) * getPixelRate(parameters) / BASE_PIXEL_RATE)
+
+  // 只支持帧线程的解码器在低延迟模式下使用单线程
+  if (preferLatency && threadType === DecoderThreadType.FRAME) {
+    threadCount = 1
+  }
+
+  const concurrency = typeof navigator !== 'undefined' && navigator.hardwareConcurrency
+    ? navigator.hardwareConcurrency
+    : 1
+
+  threadCount = Math.max(1, Math.min(threadCount, concurrency, MAX_THREAD_COUNT))
+
+  return {
+    threadCount,
+    threadType
+  }
+}
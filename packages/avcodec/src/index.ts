@@ -2,10 +2,13 @@ export { default as SubtitleDecoder, type SubtitleDecoderOptions } from './subti
 
 export { default as WasmAudioDecoder, type WasmAudioDecoderOptions } from './wasmcodec/AudioDecoder'
 export { default as WasmAudioEncoder, type WasmAudioEncoderOptions } from './wasmcodec/AudioEncoder'
-export { default as WasmVideoDecoder, AVDiscard, type WasmVideoDecoderOptions } from './wasmcodec/VideoDecoder'
-export { default as WasmVideoEncoder, type WasmVideoEncoderOptions } from './wasmcodec/VideoEncoder'
+export { default as WasmVideoDecoder, AVDiscard, DecoderThreadType, DecoderFastLevel, type WasmVideoDecoderOptions } from './wasmcodec/VideoDecoder'
+export { default as getVideoDecoderThreadOptions } from './function/getVideoDecoderThreadOptions'
+export { default as WasmVideoEncoder, EncoderPreset, type WasmVideoEncoderOptions, type VideoEncoderReconfiguration } from './wasmcodec/VideoEncoder'
 
 export { default as WebAudioDecoder, type WebAudioDecoderOptions } from './webcodec/AudioDecoder'
 export { default as WebAudioEncoder, type WebAudioEncoderOptions } from './webcodec/AudioEncoder'
 export { default as WebVideoDecoder, type WebVideoDecoderOptions } from './webcodec/VideoDecoder'
 export { default as WebVideoEncoder, type WebVideoEncoderOptions } from './webcodec/VideoEncoder'
+
+export { default as CodecStats } from './struct/codecstats'
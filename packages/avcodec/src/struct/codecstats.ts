@@ -0,0 +1,65 @@
+/*
+ * libmedia codec stats struct defined
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/**
+ * wasm 编解码器的调用统计，和 clib/stats/stats.h 中的 CodecStats 内存布局一致
+ * 
+ * 需要编译时开启 enable_codec_stats，由 decoder_set_stats / encoder_set_stats 传给 wasm 之后直接读取
+ */
+@struct
+export default class CodecStats {
+  /**
+   * 送入数据（send_packet / send_frame）的累计耗时（毫秒）
+   */
+  sendTime: double
+  /**
+   * 取出数据（receive_frame / receive_packet）的累计耗时（毫秒）
+   */
+  receiveTime: double
+  /**
+   * 送入的总字节数
+   */
+  bytesIn: int64
+  /**
+   * 输出的总字节数
+   */
+  bytesOut: int64
+  /**
+   * 送入的包（帧）总数
+   */
+  framesIn: int64
+  /**
+   * 输出的帧（包）总数
+   */
+  framesOut: int64
+  /**
+   * 出错次数
+   */
+  errors: int32
+  /**
+   * 返回 EAGAIN 的次数
+   */
+  eagain: int32
+}
@@ -35,6 +35,7 @@ import {
   avdict,
   avMallocz,
   errorType,
+  hasWasmExport,
   type AVRational
 } from '@libmedia/avutil'
 
@@ -43,12 +44,28 @@ import {
   WebAssemblyRunner
 } from '@libmedia/cheap'
 
-import { logger, support, object, is, type Data } from '@libmedia/common'
+import { logger, support, object, is, array, type Data } from '@libmedia/common'
+import decodeBatch from '../function/decodeBatch'
 
 export type WasmAudioDecoderOptions = {
   resource: WebAssemblyResource
   onReceiveAVFrame: (frame: pointer<AVFrame>) => void
   avframePool?: AVFramePool
+  /**
+   * 共享模块模式，传入已经 run 过的 WebAssemblyRunner，多个解码器共用同一个 wasm 实例（线性内存和线程池）
+   * 
+   * 每个解码器通过 decoder_create 创建独立的解码上下文，close 时不会销毁 runner
+   */
+  runner?: WebAssemblyRunner
+  /**
+   * 在解码器内部直接转换成 planar float 的指定采样率和声道数输出
+   * 
+   * 渲染端拿到的帧已经是可直接播放的格式，不需要再单独加载 resample 模块转换一次
+   */
+  output?: {
+    sampleRate: int32
+    channels: int32
+  }
 }
 
 export default class WasmAudioDecoder {
@@ -61,11 +78,36 @@ export default class WasmAudioDecoder {
 
   private decoderOptions: pointer<AVDictionary> = nullptr
 
+  private context: pointer<void> = nullptr
+
+  private batchFrames: pointer<AVFrame>[] = []
+
   private timeBase: AVRational | undefined
 
   constructor(options: WasmAudioDecoderOptions) {
     this.options = options
-    this.decoder = new WebAssemblyRunner(options.resource)
+    this.decoder = options.runner || new WebAssemblyRunner(options.resource)
+  }
+
+  private invoke<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.decoder.invoke<T>(`decoder_context_${method}`, this.context, ...args)
+    }
+    return this.decoder.invoke<T>(`decoder_${method}`, ...args)
+  }
+
+  private invokeAsync<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.decoder.invokeAsync<T>(`decoder_context_${method}`, this.context, ...args)
+    }
+    return this.decoder.invokeAsync<T>(`decoder_${method}`, ...args)
+  }
+
+  /**
+   * 旧版本编译的 wasm 没有后来新增的导出函数
+   */
+  private hasExport(method: string) {
+    return hasWasmExport(this.options.resource, this.context ? `decoder_context_${method}` : `decoder_${method}`)
   }
 
   private getAVFrame() {
@@ -77,25 +119,39 @@ export default class WasmAudioDecoder {
 
   private outputAVFrame() {
     if (this.frame) {
-      if (this.options.onReceiveAVFrame) {
-        this.frame.timeBase.den = this.timeBase!.den
-        this.frame.timeBase.num = this.timeBase!.num
-        this.options.onReceiveAVFrame(this.frame)
-      }
-      else {
-        this.options.avframePool ? this.options.avframePool.release(this.frame as pointer<AVFrameRef>) : destroyAVFrame(this.frame)
-      }
-
+      this.emitAVFrame(this.frame)
       this.frame = nullptr
     }
   }
 
+  private emitAVFrame(frame: pointer<AVFrame>) {
+    if (this.options.onReceiveAVFrame) {
+      frame.timeBase.den = this.timeBase!.den
+      frame.timeBase.num = this.timeBase!.num
+      this.options.onReceiveAVFrame(frame)
+    }
+    else {
+      this.options.avframePool ? this.options.avframePool.release(frame as pointer<AVFrameRef>) : destroyAVFrame(frame)
+    }
+  }
+
   private receiveAVFrame() {
-    return this.decoder.invoke<int32>('decoder_receive', this.getAVFrame())
+    return this.invoke<int32>('receive', this.getAVFrame())
   }
 
   public async open(parameters: pointer<AVCodecParameters>, opts: Data = {}): Promise<int32> {
-    await this.decoder.run()
+    if (this.options.runner) {
+      if (!this.context) {
+        this.context = this.decoder.invoke<pointer<void>>('decoder_create')
+        if (!this.context) {
+          logger.error('create decoder context failed')
+          return errorType.NO_MEMORY
+        }
+      }
+    }
+    else {
+      await this.decoder.run()
+    }
 
     const optsP = reinterpret_cast<pointer<pointer<AVDictionary>>>(malloc(sizeof(pointer)))
 
@@ -118,11 +174,13 @@ export default class WasmAudioDecoder {
 
     let ret = 0
     if (support.jspi) {
-      ret = await this.decoder.invokeAsync<int32>('decoder_open', parameters, nullptr, 1, optsP)
+      ret = await this.invokeAsync<int32>('open', parameters, nullptr, 1, optsP)
     }
     else {
-      ret = this.decoder.invoke<int32>('decoder_open', parameters, nullptr, 1, optsP)
-      await this.decoder.childThreadsReady()
+      ret = this.invoke<int32>('open', parameters, nullptr, 1, optsP)
+      if (!this.options.runner) {
+        await this.decoder.childThreadsReady()
+      }
     }
 
     this.decoderOptions = accessof(optsP)
@@ -134,6 +192,19 @@ export default class WasmAudioDecoder {
       return errorType.CODEC_NOT_SUPPORT
     }
 
+    if (this.options.output) {
+      if (this.hasExport('set_audio_output')) {
+        ret = this.invoke<int32>('set_audio_output', this.options.output.sampleRate, this.options.output.channels)
+        if (ret < 0) {
+          // 转换失败时输出解码器原始格式，由调用方自己重采样
+          logger.warn(`set audio decoder output failed, ret: ${ret}, output the decoder format`)
+        }
+      }
+      else {
+        logger.warn('audio decoder wasm not support set output, output the decoder format')
+      }
+    }
+
     this.timeBase = undefined
 
     return 0
@@ -148,7 +219,7 @@ export default class WasmAudioDecoder {
       }
     }
 
-    let ret = this.decoder.invoke<int32>('decoder_decode', avpacket)
+    let ret = this.invoke<int32>('decode', avpacket)
 
     if (ret) {
       return ret
@@ -170,8 +241,55 @@ export default class WasmAudioDecoder {
     return 0
   }
 
+  /**
+   * 批量同步解码
+   * 
+   * 一次 wasm 调用送入多个 avpacket 并取出所有已解码的帧，减少 js 和 wasm 之间的调用次数
+   * 出错的 avpacket 被丢弃，之后的 avpacket 继续送入，返回遇到的第一个错误
+   * 解码器不再接收输入时返回错误，剩余没有送入的 avpacket 需要调用方重新送入
+   * 
+   * @param avpackets 
+   * @returns 
+   */
+  public decodeBatch(avpackets: pointer<AVPacket>[]): int32 {
+    if (!avpackets.length) {
+      return 0
+    }
+
+    // 旧版本 wasm 没有批量接口，逐个送入
+    if (!this.hasExport('decode_batch')) {
+      let error = 0
+      for (let i = 0; i < avpackets.length; i++) {
+        const ret = this.decode(avpackets[i])
+        if (ret < 0 && !error) {
+          error = ret
+        }
+      }
+      return error
+    }
+
+    if (!this.timeBase) {
+      this.timeBase = {
+        den: avpackets[0].timeBase.den,
+        num: avpackets[0].timeBase.num
+      }
+    }
+
+    return decodeBatch(
+      {
+        invoke: (method: string, ...args: any[]) => this.invoke(method, ...args),
+        frames: this.batchFrames,
+        allocAVFrame: () => this.options.avframePool ? this.options.avframePool.alloc() : createAVFrame(),
+        onReceiveAVFrame: (frame) => {
+          this.emitAVFrame(frame)
+        }
+      },
+      avpackets
+    )
+  }
+
   public async flush(): Promise<int32> {
-    this.decoder.invoke('decoder_flush')
+    this.invoke('flush')
     while (1) {
       const ret = this.receiveAVFrame()
       if (ret < 1) {
@@ -183,13 +301,28 @@ export default class WasmAudioDecoder {
   }
 
   public close() {
-    this.decoder.invoke('decoder_close')
-    this.decoder.destroy()
+    if (this.options.runner) {
+      if (this.context) {
+        this.decoder.invoke('decoder_destroy', this.context)
+        this.context = nullptr
+      }
+    }
+    else {
+      this.invoke('close')
+      this.decoder.destroy()
+    }
 
     if (this.frame) {
       this.options.avframePool ? this.options.avframePool.release(this.frame as pointer<AVFrameRef>) : destroyAVFrame(this.frame)
       this.frame = nullptr
     }
+
+    array.each(this.batchFrames, (frame) => {
+      if (frame) {
+        this.options.avframePool ? this.options.avframePool.release(frame as pointer<AVFrameRef>) : destroyAVFrame(frame)
+      }
+    })
+    this.batchFrames.length = 0
     if (this.decoderOptions) {
       avdict.freeAVDict2(this.decoderOptions)
       free(this.decoderOptions)
@@ -63,6 +63,12 @@ export type WasmAudioEncoderOptions = {
   onReceiveAVPacket: (avpacket: pointer<AVPacket>) => void
   avpacketPool?: AVPacketPool
   copyTs?: boolean
+  /**
+   * 共享模块模式，传入已经 run 过的 WebAssemblyRunner，多个编码器共用同一个 wasm 实例（线性内存和线程池）
+   * 
+   * 每个编码器通过 encoder_create 创建独立的编码上下文，close 时不会销毁 runner
+   */
+  runner?: WebAssemblyRunner
 }
 
 class AudioFrameResizer {
@@ -201,11 +207,27 @@ export default class WasmAudioEncoder {
   private audioFrameResizer: AudioFrameResizer | undefined
 
   private encoderOptions: pointer<AVDictionary> = nullptr
+
+  private context: pointer<void> = nullptr
   private ptsQueue: int64[] = []
 
   constructor(options: WasmAudioEncoderOptions) {
     this.options = options
-    this.encoder = new WebAssemblyRunner(this.options.resource)
+    this.encoder = this.options.runner || new WebAssemblyRunner(this.options.resource)
+  }
+
+  private invoke<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.encoder.invoke<T>(`encoder_context_${method}`, this.context, ...args)
+    }
+    return this.encoder.invoke<T>(`encoder_${method}`, ...args)
+  }
+
+  private invokeAsync<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.encoder.invokeAsync<T>(`encoder_context_${method}`, this.context, ...args)
+    }
+    return this.encoder.invokeAsync<T>(`encoder_${method}`, ...args)
   }
 
   private getAVPacket() {
@@ -232,11 +254,22 @@ export default class WasmAudioEncoder {
   }
 
   private receiveAVPacket() {
-    return this.encoder.invoke<int32>('encoder_receive', this.getAVPacket())
+    return this.invoke<int32>('receive', this.getAVPacket())
   }
 
   public async open(parameters: pointer<AVCodecParameters>, timeBase: AVRational, opts: Data = {}): Promise<int32> {
-    await this.encoder.run()
+    if (this.options.runner) {
+      if (!this.context) {
+        this.context = this.encoder.invoke<pointer<void>>('encoder_create')
+        if (!this.context) {
+          logger.error('create encoder context failed')
+          return errorType.NO_MEMORY
+        }
+      }
+    }
+    else {
+      await this.encoder.run()
+    }
 
     const timeBaseP = reinterpret_cast<pointer<AVRational>>(malloc(sizeof(AVRational)))
     const optsP = reinterpret_cast<pointer<pointer<AVDictionary>>>(malloc(sizeof(pointer)))
@@ -245,7 +278,7 @@ export default class WasmAudioEncoder {
     timeBaseP.den = timeBase.den
     accessof(optsP) <- nullptr
 
-    this.encoder.invoke('encoder_set_flags', 1 << 22)
+    this.invoke('set_flags', 1 << 22)
 
     if (object.keys(opts).length) {
       if (this.encoderOptions) {
@@ -265,14 +298,16 @@ export default class WasmAudioEncoder {
     let ret = 0
 
     if (support.jspi) {
-      ret = await this.encoder.invokeAsync<int32>('encoder_open', parameters, timeBaseP, 1, optsP)
+      ret = await this.invokeAsync<int32>('open', parameters, timeBaseP, 1, optsP)
     }
     else {
-      ret = this.encoder.invoke<int32>('encoder_open', parameters, timeBaseP, 1, optsP)
-      await this.encoder.childThreadsReady()
+      ret = this.invoke<int32>('open', parameters, timeBaseP, 1, optsP)
+      if (!this.options.runner) {
+        await this.encoder.childThreadsReady()
+      }
     }
 
-    this.frameSize = this.encoder.invoke<int32>('encoder_get_framesize_size')
+    this.frameSize = this.invoke<int32>('get_framesize_size')
 
     this.encoderOptions = accessof(optsP)
 
@@ -294,7 +329,7 @@ export default class WasmAudioEncoder {
   }
 
   private encode_(avframe: pointer<AVFrame>) {
-    let ret = this.encoder.invoke<int32>('encoder_encode', avframe)
+    let ret = this.invoke<int32>('encode', avframe)
     if (ret) {
       return ret
     }
@@ -368,7 +403,7 @@ export default class WasmAudioEncoder {
       destroyAVFrame(avframe)
     }
 
-    this.encoder.invoke('encoder_flush', nullptr)
+    this.invoke('flush', nullptr)
     while (1) {
       const ret = this.receiveAVPacket()
       if (ret < 1) {
@@ -380,8 +415,8 @@ export default class WasmAudioEncoder {
   }
 
   public getExtraData() {
-    const pointer = this.encoder.invoke<pointer<uint8>>('encoder_get_extradata')
-    const size = this.encoder.invoke<int32>('encoder_get_extradata_size')
+    const pointer = this.invoke<pointer<uint8>>('get_extradata')
+    const size = this.invoke<int32>('get_extradata_size')
 
     if (pointer && size) {
       return mapUint8Array(pointer, reinterpret_cast<size>(size)).slice()
@@ -390,8 +425,16 @@ export default class WasmAudioEncoder {
   }
 
   public close() {
-    this.encoder.invoke('encoder_close')
-    this.encoder.destroy()
+    if (this.options.runner) {
+      if (this.context) {
+        this.encoder.invoke('encoder_destroy', this.context)
+        this.context = nullptr
+      }
+    }
+    else {
+      this.invoke('close')
+      this.encoder.destroy()
+    }
 
     if (this.avpacket) {
       this.options.avpacketPool
@@ -35,6 +35,7 @@ import {
   avdict,
   avMallocz,
   errorType,
+  hasWasmExport,
   type AVRational,
   AVCodecParameterFlags
 } from '@libmedia/avutil'
@@ -44,12 +45,25 @@ import {
   WebAssemblyRunner
 } from '@libmedia/cheap'
 
-import { logger, support, object, is, type Data } from '@libmedia/common'
+import { logger, support, object, is, array, type Data } from '@libmedia/common'
+import getVideoDecoderThreadOptions from '../function/getVideoDecoderThreadOptions'
+import decodeBatch from '../function/decodeBatch'
+import type CodecStats from '../struct/codecstats'
 
 export type WasmVideoDecoderOptions = {
   resource: WebAssemblyResource
   onReceiveAVFrame: (frame: pointer<AVFrame>) => void
   avframePool?: AVFramePool
+  /**
+   * 共享模块模式，传入已经 run 过的 WebAssemblyRunner，多个解码器共用同一个 wasm 实例（线性内存和线程池）
+   * 
+   * 每个解码器通过 decoder_create 创建独立的解码上下文，close 时不会销毁 runner
+   */
+  runner?: WebAssemblyRunner
+  /**
+   * 调用统计的输出位置，wasm 编译时开启了 enable_codec_stats 才会写入，没有 set_stats 导出的旧版本 wasm 忽略
+   */
+  stats?: pointer<CodecStats>
 }
 
 /**
@@ -87,6 +101,50 @@ export const enum AVDiscard {
   AVDISCARD_ALL = 48
 }
 
+/**
+ * 解码线程类型，对应 ffmpeg 的 FF_THREAD_FRAME 和 FF_THREAD_SLICE
+ */
+export const enum DecoderThreadType {
+  /**
+   * 使用 ffmpeg 默认（帧线程和片线程都开启）
+   */
+  AUTO = 0,
+  /**
+   * 帧线程，吞吐量高，但每多一个线程多一帧延迟
+   */
+  FRAME = 1,
+  /**
+   * 片线程，不增加延迟，但需要码流有多个 slice 或开启 WPP
+   */
+  SLICE = 2,
+  /**
+   * 帧线程和片线程
+   */
+  FRAME_SLICE = 3
+}
+
+/**
+ * 快速解码等级，以画质换取解码速度
+ */
+export const enum DecoderFastLevel {
+  /**
+   * 正常解码
+   */
+  NONE = 0,
+  /**
+   * 跳过非参考帧的环路滤波，开启 AV_CODEC_FLAG2_FAST
+   */
+  FAST = 1,
+  /**
+   * 跳过所有帧的环路滤波和非参考帧的 idct
+   */
+  FASTER = 2,
+  /**
+   * 在 FASTER 基础上于打开时使用 lowres（编解码器支持时），适用于缩略图
+   */
+  FASTEST = 3
+}
+
 export default class WasmVideoDecoder {
 
   private options: WasmVideoDecoderOptions
@@ -99,13 +157,38 @@ export default class WasmVideoDecoder {
 
   private decoderOptions: pointer<AVDictionary> = nullptr
 
+  private context: pointer<void> = nullptr
+
+  private batchFrames: pointer<AVFrame>[] = []
+
   private timeBase: AVRational | undefined
 
   private dtsQueue: int64[] = []
 
   constructor(options: WasmVideoDecoderOptions) {
     this.options = options
-    this.decoder = new WebAssemblyRunner(this.options.resource)
+    this.decoder = this.options.runner || new WebAssemblyRunner(this.options.resource)
+  }
+
+  private invoke<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.decoder.invoke<T>(`decoder_context_${method}`, this.context, ...args)
+    }
+    return this.decoder.invoke<T>(`decoder_${method}`, ...args)
+  }
+
+  private invokeAsync<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.decoder.invokeAsync<T>(`decoder_context_${method}`, this.context, ...args)
+    }
+    return this.decoder.invokeAsync<T>(`decoder_${method}`, ...args)
+  }
+
+  /**
+   * 旧版本编译的 wasm 没有后来新增的导出函数
+   */
+  private hasExport(method: string) {
+    return hasWasmExport(this.options.resource, this.context ? `decoder_context_${method}` : `decoder_${method}`)
   }
 
   private getAVFrame() {
@@ -117,42 +200,74 @@ export default class WasmVideoDecoder {
 
   private outputAVFrame() {
     if (this.frame) {
-      if ((this.parameters.flags & AVCodecParameterFlags.AV_CODECPAR_FLAG_NO_PTS)
-        && this.dtsQueue.length
-      ) {
-        this.frame.pts = this.dtsQueue.shift()!
-      }
-      if (this.options.onReceiveAVFrame) {
-        this.frame.timeBase.den = this.timeBase!.den
-        this.frame.timeBase.num = this.timeBase!.num
-        this.options.onReceiveAVFrame(this.frame)
-      }
-      else {
-        this.options.avframePool ? this.options.avframePool.release(this.frame as pointer<AVFrameRef>) : destroyAVFrame(this.frame)
-      }
-
+      this.emitAVFrame(this.frame)
       this.frame = nullptr
     }
   }
 
+  private emitAVFrame(frame: pointer<AVFrame>) {
+    if ((this.parameters.flags & AVCodecParameterFlags.AV_CODECPAR_FLAG_NO_PTS)
+      && this.dtsQueue.length
+    ) {
+      frame.pts = this.dtsQueue.shift()!
+    }
+    if (this.options.onReceiveAVFrame) {
+      frame.timeBase.den = this.timeBase!.den
+      frame.timeBase.num = this.timeBase!.num
+      this.options.onReceiveAVFrame(frame)
+    }
+    else {
+      this.options.avframePool ? this.options.avframePool.release(frame as pointer<AVFrameRef>) : destroyAVFrame(frame)
+    }
+  }
+
   private receiveAVFrame() {
-    return this.decoder.invoke<int32>('decoder_receive', this.getAVFrame())
+    return this.invoke<int32>('receive', this.getAVFrame())
   }
 
   private async receiveAVFrameAsync() {
-    return this.decoder.invokeAsync<int32>('decoder_receive', this.getAVFrame())
+    return this.invokeAsync<int32>('receive', this.getAVFrame())
   }
 
   /**
    * 打开解码器
    * 
+   * threadCount 传 0 时根据码流参数和 navigator.hardwareConcurrency 自动计算线程数
+   * 
    * @param parameters 
    * @param threadCount 
    * @param opts 
+   * @param threadType 
    * @returns 
    */
-  public async open(parameters: pointer<AVCodecParameters>, threadCount: number = 1, opts: Data = {}): Promise<int32> {
-    await this.decoder.run(undefined, threadCount)
+  public async open(
+    parameters: pointer<AVCodecParameters>,
+    threadCount: number = 1,
+    opts: Data = {},
+    threadType: DecoderThreadType = DecoderThreadType.AUTO
+  ): Promise<int32> {
+    if (threadCount === 0) {
+      const threadOptions = getVideoDecoderThreadOptions(parameters, threadType === DecoderThreadType.SLICE)
+      threadCount = threadOptions.threadCount
+      if (threadType === DecoderThreadType.AUTO) {
+        threadType = threadOptions.threadType
+      }
+    }
+    if (this.options.runner) {
+      if (!this.context) {
+        this.context = this.decoder.invoke<pointer<void>>('decoder_create')
+        if (!this.context) {
+          logger.error('create decoder context failed')
+          return errorType.NO_MEMORY
+        }
+      }
+    }
+    else {
+      await this.decoder.run(undefined, threadCount)
+    }
+    if (this.options.stats && this.hasExport('set_stats')) {
+      this.invoke('set_stats', this.options.stats)
+    }
     let ret = 0
 
     const optsP = reinterpret_cast<pointer<pointer<AVDictionary>>>(malloc(sizeof(pointer)))
@@ -173,12 +288,18 @@ export default class WasmVideoDecoder {
       accessof(optsP) <- this.decoderOptions
     }
 
+    if (threadType !== DecoderThreadType.AUTO && this.hasExport('set_thread_type')) {
+      this.invoke('set_thread_type', threadType)
+    }
+
     if (support.jspi) {
-      ret = await this.decoder.invokeAsync<int32>('decoder_open', parameters, nullptr, threadCount, optsP)
+      ret = await this.invokeAsync<int32>('open', parameters, nullptr, threadCount, optsP)
     }
     else {
-      ret = this.decoder.invoke<int32>('decoder_open', parameters, nullptr, threadCount, optsP)
-      await this.decoder.childThreadsReady()
+      ret = this.invoke<int32>('open', parameters, nullptr, threadCount, optsP)
+      if (!this.options.runner) {
+        await this.decoder.childThreadsReady()
+      }
     }
 
     this.decoderOptions = accessof(optsP)
@@ -212,7 +333,7 @@ export default class WasmVideoDecoder {
       }
     }
 
-    let ret = this.decoder.invoke<int32>('decoder_decode', avpacket)
+    let ret = this.invoke<int32>('decode', avpacket)
 
     if (ret) {
       return ret
@@ -253,7 +374,7 @@ export default class WasmVideoDecoder {
       }
     }
 
-    let ret = await this.decoder.invokeAsync<int32>('decoder_decode', avpacket)
+    let ret = await this.invokeAsync<int32>('decode', avpacket)
 
     if (ret) {
       return ret
@@ -278,13 +399,65 @@ export default class WasmVideoDecoder {
     return 0
   }
 
+  /**
+   * 批量同步解码
+   * 
+   * 一次 wasm 调用送入多个 avpacket 并取出所有已解码的帧，减少 js 和 wasm 之间的调用次数
+   * 出错的 avpacket 被丢弃，之后的 avpacket 继续送入，返回遇到的第一个错误
+   * 解码器不再接收输入时返回错误，剩余没有送入的 avpacket 需要调用方重新送入
+   * 
+   * @param avpackets 
+   * @returns 
+   */
+  public decodeBatch(avpackets: pointer<AVPacket>[]): int32 {
+    if (!avpackets.length) {
+      return 0
+    }
+
+    // 旧版本 wasm 没有批量接口，逐个送入
+    if (!this.hasExport('decode_batch')) {
+      let error = 0
+      for (let i = 0; i < avpackets.length; i++) {
+        const ret = this.decode(avpackets[i])
+        if (ret < 0 && !error) {
+          error = ret
+        }
+      }
+      return error
+    }
+
+    if (!this.timeBase) {
+      this.timeBase = {
+        den: avpackets[0].timeBase.den,
+        num: avpackets[0].timeBase.num
+      }
+    }
+
+    return decodeBatch(
+      {
+        invoke: (method: string, ...args: any[]) => this.invoke(method, ...args),
+        frames: this.batchFrames,
+        allocAVFrame: () => this.options.avframePool ? this.options.avframePool.alloc() : createAVFrame(),
+        onReceiveAVFrame: (frame) => {
+          this.emitAVFrame(frame)
+        },
+        onConsumed: (avpacket) => {
+          if (this.parameters.flags & AVCodecParameterFlags.AV_CODECPAR_FLAG_NO_PTS) {
+            this.dtsQueue.push(avpacket.dts)
+          }
+        }
+      },
+      avpackets
+    )
+  }
+
   /**
    * 刷出解码队列中所有缓存的帧
    * 
    * @returns 
    */
   public async flush(): Promise<int32> {
-    this.decoder.invoke('decoder_flush')
+    this.invoke('flush')
     while (1) {
       const ret = this.receiveAVFrame()
       if (ret < 1) {
@@ -303,7 +476,7 @@ export default class WasmVideoDecoder {
    * @returns 
    */
   public async flushAsync(): Promise<int32> {
-    await this.decoder.invokeAsync('decoder_flush')
+    await this.invokeAsync('flush')
     while (1) {
       const ret = await this.receiveAVFrameAsync()
       if (ret < 1) {
@@ -318,14 +491,29 @@ export default class WasmVideoDecoder {
    * 关闭解码器
    */
   public close() {
-    this.decoder.invoke('decoder_close')
-    this.decoder.destroy()
+    if (this.options.runner) {
+      if (this.context) {
+        this.decoder.invoke('decoder_destroy', this.context)
+        this.context = nullptr
+      }
+    }
+    else {
+      this.invoke('close')
+      this.decoder.destroy()
+    }
 
     if (this.frame) {
       this.options.avframePool ? this.options.avframePool.release(this.frame as pointer<AVFrameRef>) : destroyAVFrame(this.frame)
       this.frame = nullptr
     }
 
+    array.each(this.batchFrames, (frame) => {
+      if (frame) {
+        this.options.avframePool ? this.options.avframePool.release(frame as pointer<AVFrameRef>) : destroyAVFrame(frame)
+      }
+    })
+    this.batchFrames.length = 0
+
     this.parameters = nullptr
 
     if (this.decoderOptions) {
@@ -341,7 +529,48 @@ export default class WasmVideoDecoder {
    * @param discard 
    */
   public setSkipFrameDiscard(discard: AVDiscard) {
-    this.decoder.invoke('decoder_discard', discard)
+    this.invoke('discard', discard)
+  }
+
+  /**
+   * 设置快速解码等级，解码过程中可随时切换
+   * 
+   * wasm 不支持时忽略
+   * 
+   * @param level 
+   */
+  public setFastDecode(level: DecoderFastLevel) {
+    if (!this.hasExport('set_fast_decode')) {
+      return
+    }
+    this.invoke('set_fast_decode', level)
+  }
+
+  /**
+   * 获取解码延迟帧数
+   * 
+   * 帧线程每多一个线程多一帧延迟，低延迟直播应使用片线程
+   * wasm 不支持获取时返回 0
+   * 
+   * @returns 
+   */
+  public getDelay() {
+    if (!this.hasExport('get_delay')) {
+      return 0
+    }
+    return this.invoke<int32>('get_delay')
+  }
+
+  /**
+   * 获取实际生效的线程类型
+   * 
+   * @returns 
+   */
+  public getThreadType() {
+    if (!this.hasExport('get_thread_type')) {
+      return DecoderThreadType.AUTO
+    }
+    return this.invoke<DecoderThreadType>('get_thread_type')
   }
 
   /**
@@ -37,6 +37,7 @@ import {
   avdict,
   avMallocz,
   errorType,
+  hasWasmExport,
   createAVFrame,
   destroyAVFrame,
   refAVFrame,
@@ -66,12 +67,71 @@ import {
 
 import { logger, support, object, is, type Data } from '@libmedia/common'
 import { type AVBSFilter, Annexb2AvccFilter } from '@libmedia/avformat/internal'
+import type CodecStats from '../struct/codecstats'
+
+/**
+ * 编码预设，在 encode.c 中映射到各个编码库的码控、lookahead、线程和 tune 参数
+ */
+export const enum EncoderPreset {
+  /**
+   * 使用编码库默认参数
+   */
+  NONE = 0,
+  /**
+   * 实时（零延时），没有 B 帧和 lookahead
+   */
+  REALTIME = 1,
+  /**
+   * 速度和质量均衡
+   */
+  BALANCED = 2,
+  /**
+   * 质量优先
+   */
+  ARCHIVAL = 3
+}
+
+/**
+ * 运行时修改的编码参数，不传的保持不变
+ * 
+ * setBitrate 和 reconfigure 的返回值约定相同：1 已经实时生效，0 需要（或已经）重新打开编码器，下一帧开始新的 gop，小于 0 出错
+ */
+export interface VideoEncoderReconfiguration {
+  /**
+   * 目标码率
+   */
+  bitrate?: int64
+  /**
+   * 最大码率（VBV），只有 wasm 编码器生效
+   */
+  maxRate?: int64
+  /**
+   * VBV 缓冲区大小（bit），只有 wasm 编码器生效
+   */
+  bufferSize?: int32
+  width?: int32
+  height?: int32
+}
 
 export type WasmVideoEncoderOptions = {
   resource: WebAssemblyResource
   onReceiveAVPacket: (avpacket: pointer<AVPacket>) => void
   avpacketPool?: AVPacketPool
   copyTs?: boolean
+  /**
+   * 共享模块模式，传入已经 run 过的 WebAssemblyRunner，多个编码器共用同一个 wasm 实例（线性内存和线程池）
+   * 
+   * 每个编码器通过 encoder_create 创建独立的编码上下文，close 时不会销毁 runner
+   */
+  runner?: WebAssemblyRunner
+  /**
+   * 编码预设，调用方传入的 opts 会覆盖预设中的同名参数
+   */
+  preset?: EncoderPreset
+  /**
+   * 调用统计的输出位置，wasm 编译时开启了 enable_codec_stats 才会写入，没有 set_stats 导出的旧版本 wasm 忽略
+   */
+  stats?: pointer<CodecStats>
 }
 
 export default class WasmVideoEncoder {
@@ -96,9 +156,32 @@ export default class WasmVideoEncoder {
 
   private encoderOptions: pointer<AVDictionary> = nullptr
 
+  private context: pointer<void> = nullptr
+
   constructor(options: WasmVideoEncoderOptions) {
     this.options = options
-    this.encoder = new WebAssemblyRunner(this.options.resource)
+    this.encoder = this.options.runner || new WebAssemblyRunner(this.options.resource)
+  }
+
+  private invoke<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.encoder.invoke<T>(`encoder_context_${method}`, this.context, ...args)
+    }
+    return this.encoder.invoke<T>(`encoder_${method}`, ...args)
+  }
+
+  private invokeAsync<T = void>(method: string, ...args: any[]) {
+    if (this.context) {
+      return this.encoder.invokeAsync<T>(`encoder_context_${method}`, this.context, ...args)
+    }
+    return this.encoder.invokeAsync<T>(`encoder_${method}`, ...args)
+  }
+
+  /**
+   * 旧版本编译的 wasm 没有后来新增的导出函数
+   */
+  private hasExport(method: string) {
+    return hasWasmExport(this.options.resource, this.context ? `encoder_context_${method}` : `encoder_${method}`)
   }
 
   private getAVPacket() {
@@ -158,11 +241,11 @@ export default class WasmVideoEncoder {
   }
 
   private receiveAVPacket() {
-    return this.encoder.invoke<int32>('encoder_receive', this.getAVPacket())
+    return this.invoke<int32>('receive', this.getAVPacket())
   }
 
   private receiveAVPacketAsync() {
-    return this.encoder.invokeAsync<int32>('encoder_receive', this.getAVPacket())
+    return this.invokeAsync<int32>('receive', this.getAVPacket())
   }
 
   /**
@@ -175,7 +258,21 @@ export default class WasmVideoEncoder {
    * @returns 
    */
   public async open(parameters: pointer<AVCodecParameters>, timeBase: AVRational, threadCount: number = 1, opts: Data = {}): Promise<int32> {
-    await this.encoder.run(undefined, threadCount)
+    if (this.options.runner) {
+      if (!this.context) {
+        this.context = this.encoder.invoke<pointer<void>>('encoder_create')
+        if (!this.context) {
+          logger.error('create encoder context failed')
+          return errorType.NO_MEMORY
+        }
+      }
+    }
+    else {
+      await this.encoder.run(undefined, threadCount)
+    }
+    if (this.options.stats && this.hasExport('set_stats')) {
+      this.invoke('set_stats', this.options.stats)
+    }
 
     const timeBaseP = reinterpret_cast<pointer<AVRational>>(malloc(sizeof(AVRational)))
     const optsP = reinterpret_cast<pointer<pointer<AVDictionary>>>(malloc(sizeof(pointer)))
@@ -185,9 +282,17 @@ export default class WasmVideoEncoder {
     accessof(optsP) <- nullptr
 
     if (parameters.codecId === AVCodecID.AV_CODEC_ID_MPEG4 && !(parameters.flags & AVCodecParameterFlags.AV_CODECPAR_FLAG_H26X_ANNEXB)) {
-      this.encoder.invoke('encoder_set_flags', 1 << 22)
+      this.invoke('set_flags', 1 << 22)
+    }
+    this.invoke('set_max_b_frame', parameters.videoDelay)
+    if (this.options.preset && this.options.preset !== EncoderPreset.NONE) {
+      if (this.hasExport('set_preset')) {
+        this.invoke('set_preset', this.options.preset)
+      }
+      else {
+        logger.warn('encoder wasm not support preset, ignore it')
+      }
     }
-    this.encoder.invoke('encoder_set_max_b_frame', parameters.videoDelay)
 
     if (object.keys(opts).length) {
       if (this.encoderOptions) {
@@ -207,11 +312,13 @@ export default class WasmVideoEncoder {
     let ret = 0
 
     if (support.jspi) {
-      ret = await this.encoder.invokeAsync<int32>('encoder_open', parameters, timeBaseP, threadCount, optsP)
+      ret = await this.invokeAsync<int32>('open', parameters, timeBaseP, threadCount, optsP)
     }
     else {
-      ret = this.encoder.invoke<int32>('encoder_open', parameters, timeBaseP, threadCount, optsP)
-      await this.encoder.childThreadsReady()
+      ret = this.invoke<int32>('open', parameters, timeBaseP, threadCount, optsP)
+      if (!this.options.runner) {
+        await this.encoder.childThreadsReady()
+      }
     }
 
     this.encoderOptions = accessof(optsP)
@@ -279,7 +386,7 @@ export default class WasmVideoEncoder {
   public encode(frame: pointer<AVFrame>, key: boolean): int32 {
     frame = this.preEncode(frame, key)
 
-    let ret = this.encoder.invoke<int32>('encoder_encode', frame)
+    let ret = this.invoke<int32>('encode', frame)
     if (ret) {
       return ret
     }
@@ -311,7 +418,7 @@ export default class WasmVideoEncoder {
   public async encodeAsync(frame: pointer<AVFrame>, key: boolean): Promise<int32> {
     frame = this.preEncode(frame, key)
 
-    let ret = await this.encoder.invokeAsync<int32>('encoder_encode', frame)
+    let ret = await this.invokeAsync<int32>('encode', frame)
     if (ret) {
       return ret
     }
@@ -337,7 +444,7 @@ export default class WasmVideoEncoder {
    * @returns 
    */
   public async flush(): Promise<int32> {
-    this.encoder.invoke('encoder_flush')
+    this.invoke('flush')
     while (1) {
       const ret = this.receiveAVPacket()
       if (ret < 1) {
@@ -356,7 +463,7 @@ export default class WasmVideoEncoder {
    * @returns 
    */
   public async flushAsync(): Promise<int32> {
-    await this.encoder.invokeAsync('encoder_flush')
+    await this.invokeAsync('flush')
     while (1) {
       const ret = await this.receiveAVPacketAsync()
       if (ret < 1) {
@@ -367,13 +474,94 @@ export default class WasmVideoEncoder {
     return 0
   }
 
+  /**
+   * 运行时修改目标码率
+   * 
+   * @param bitrate 
+   * @returns 1 已经实时生效，0 编码库不支持实时修改，下一次 open 时生效，小于 0 出错（wasm 不支持时返回 OPERATE_NOT_SUPPORT）
+   */
+  public setBitrate(bitrate: int64): int32 {
+    if (!this.hasExport('set_bitrate')) {
+      return errorType.OPERATE_NOT_SUPPORT
+    }
+    const ret = this.invoke<int32>('set_bitrate', static_cast<int32>(bitrate))
+    if (ret >= 0) {
+      this.parameters.bitrate = bitrate
+    }
+    return ret
+  }
+
+  /**
+   * 运行时修改编码参数
+   * 
+   * 编码库支持实时修改的直接在下一帧生效，否则先刷出缓存的包再用新的参数重新打开编码器
+   * 
+   * @param config 
+   * @returns 1 实时生效，0 重新打开了编码器（下一帧是关键帧），小于 0 出错（wasm 不支持时返回 OPERATE_NOT_SUPPORT）
+   */
+  public async reconfigure(config: VideoEncoderReconfiguration): Promise<int32> {
+    if (!this.hasExport('reconfigure') || !this.hasExport('reopen')) {
+      logger.warn('encoder wasm not support reconfigure')
+      return errorType.OPERATE_NOT_SUPPORT
+    }
+    let ret = this.invoke<int32>(
+      'reconfigure',
+      config.bitrate ? static_cast<int32>(config.bitrate) : 0,
+      config.maxRate ? static_cast<int32>(config.maxRate) : 0,
+      config.bufferSize ?? 0,
+      config.width ?? 0,
+      config.height ?? 0
+    )
+    if (ret < 0) {
+      logger.error(`reconfigure video encoder failed, ret: ${ret}`)
+      return ret
+    }
+
+    if (config.bitrate) {
+      this.parameters.bitrate = config.bitrate
+    }
+
+    if (ret === 1) {
+      return 1
+    }
+
+    ret = support.jspi ? await this.flushAsync() : await this.flush()
+    if (ret < 0) {
+      return ret
+    }
+
+    ret = support.jspi
+      ? await this.invokeAsync<int32>('reopen')
+      : this.invoke<int32>('reopen')
+
+    if (ret < 0) {
+      logger.error(`reopen video encoder failed, ret: ${ret}`)
+      return ret
+    }
+
+    if (config.width) {
+      this.parameters.width = config.width
+    }
+    if (config.height) {
+      this.parameters.height = config.height
+    }
+
+    // 分辨率变化之后码流头会变，重新生成
+    this.extradata = null
+    if (this.bitrateFilter) {
+      this.bitrateFilter.destroy()
+      this.bitrateFilter = undefined
+    }
+    return 0
+  }
+
   public getExtraData() {
     if (this.extradata) {
       return this.extradata
     }
 
-    const pointer = this.encoder.invoke<pointer<uint8>>('encoder_get_extradata')
-    const size = this.encoder.invoke<int32>('encoder_get_extradata_size')
+    const pointer = this.invoke<pointer<uint8>>('get_extradata')
+    const size = this.invoke<int32>('get_extradata_size')
     if (pointer && size) {
       return mapUint8Array(pointer, reinterpret_cast<size>(size)).slice()
     }
@@ -382,15 +570,23 @@ export default class WasmVideoEncoder {
 
   public getColorSpace() {
     return {
-      colorSpace: this.encoder.invoke<int32>('encoder_get_color_space'),
-      colorPrimaries: this.encoder.invoke<int32>('encoder_get_color_primaries'),
-      colorTrc: this.encoder.invoke<int32>('encoder_get_color_trc')
+      colorSpace: this.invoke<int32>('get_color_space'),
+      colorPrimaries: this.invoke<int32>('get_color_primaries'),
+      colorTrc: this.invoke<int32>('get_color_trc')
     }
   }
 
   public close() {
-    this.encoder.invoke('encoder_close')
-    this.encoder.destroy()
+    if (this.options.runner) {
+      if (this.context) {
+        this.encoder.invoke('encoder_destroy', this.context)
+        this.context = nullptr
+      }
+    }
+    else {
+      this.invoke('close')
+      this.encoder.destroy()
+    }
 
     if (this.avpacket) {
       this.options.avpacketPool
@@ -582,6 +582,10 @@ export default class WebVideoDecoder {
 
   }
 
+  public setFastDecode(level: number) {
+
+  }
+
   static async isSupported(parameters: pointer<AVCodecParameters>, enableHardwareAcceleration: boolean) {
     let extradata: Uint8Array | undefined
     if (parameters.extradata !== nullptr) {
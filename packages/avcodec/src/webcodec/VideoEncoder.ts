@@ -67,6 +67,7 @@ import {
 } from '@libmedia/cheap'
 
 import { logger, browser, object } from '@libmedia/common'
+import type { VideoEncoderReconfiguration } from '../wasmcodec/VideoEncoder'
 
 export type WebVideoEncoderOptions = {
   onReceiveAVPacket: (avpacket: pointer<AVPacket>) => void
@@ -112,6 +113,8 @@ export default class WebVideoEncoder {
 
   private ptsQueue: int64[] = []
 
+  private config: VideoEncoderConfig | undefined
+
   constructor(options: WebVideoEncoderOptions) {
 
     this.options = options
@@ -293,6 +296,7 @@ export default class WebVideoEncoder {
       return errorType.CODEC_NOT_SUPPORT
     }
 
+    this.config = config
     this.parameters = parameters
     this.timeBase = timeBase
     this.inputCounter = 0n
@@ -378,6 +382,59 @@ export default class WebVideoEncoder {
     }
   }
 
+  /**
+   * 运行时修改编码参数，通过 configure 生效，已经送入的帧仍然使用旧的参数编码
+   * 
+   * webcodecs 不支持设置最大码率和 VBV，maxRate 和 bufferSize 会被忽略
+   * 
+   * @param config 
+   * @returns 1 只修改了码率，0 分辨率修改（下一帧是关键帧），小于 0 出错，和 wasm 编码器的约定相同
+   */
+  public async reconfigure(config: VideoEncoderReconfiguration): Promise<int32> {
+    if (!this.encoder || !this.config || this.encoder.state !== 'configured') {
+      return errorType.INVALID_OPERATE
+    }
+
+    const newConfig: VideoEncoderConfig = object.extend({}, this.config)
+    let resize = false
+
+    if (config.bitrate) {
+      newConfig.bitrate = static_cast<double>(config.bitrate)
+    }
+    if (config.width && config.width !== newConfig.width) {
+      newConfig.width = config.width
+      resize = true
+    }
+    if (config.height && config.height !== newConfig.height) {
+      newConfig.height = config.height
+      resize = true
+    }
+
+    try {
+      const support = await VideoEncoder.isConfigSupported(newConfig)
+      if (!support.supported) {
+        logger.error('reconfigure not support')
+        return errorType.INVALID_PARAMETERS
+      }
+      this.encoder.configure(newConfig)
+    }
+    catch (error) {
+      logger.error(`reconfigure error, ${error}`)
+      return errorType.INVALID_PARAMETERS
+    }
+
+    this.config = newConfig
+
+    if (config.bitrate) {
+      this.parameters.bitrate = config.bitrate
+    }
+    if (resize) {
+      this.parameters.width = newConfig.width
+      this.parameters.height = newConfig.height
+    }
+    return resize ? 0 : 1
+  }
+
   public close() {
     if (this.encoder) {
       if (this.encoder.state !== 'closed') {
@@ -0,0 +1,57 @@
+import {
+  type AVFrame,
+  refAVFrame,
+  createAVFrame
+} from '@libmedia/avutil'
+
+import { is } from '@libmedia/common'
+import { isPointer } from '@libmedia/cheap'
+
+import type { AVFilterNodeOptions } from './AVFilterNode'
+import AVFilterNode from './AVFilterNode'
+
+export interface SplitFilterNodeOptions extends AVFilterNodeOptions {
+  /**
+   * 输出路数
+   */
+  count: number
+}
+
+/**
+ * 把一路输入复制到多路输出
+ * 
+ * AVFrame 只增加引用计数，不拷贝数据，VideoFrame 使用 clone
+ */
+export default class SplitFilterNode extends AVFilterNode {
+  declare options: SplitFilterNodeOptions
+
+  constructor(options: SplitFilterNodeOptions) {
+    super(options, 1, options.count)
+  }
+
+  public async ready() {
+
+  }
+
+  public async destroy() {
+
+  }
+
+  public async process(inputs: (pointer<AVFrame> | VideoFrame | int32)[], outputs: (pointer<AVFrame> | VideoFrame | int32)[]) {
+    const avframe = inputs[0]
+
+    for (let i = 0; i < this.outputCount; i++) {
+      if (is.number(avframe) && avframe < 0) {
+        outputs[i] = avframe
+      }
+      else if (isPointer(avframe)) {
+        const out = this.options.avframePool ? this.options.avframePool.alloc() : createAVFrame()
+        refAVFrame(out, avframe)
+        outputs[i] = out
+      }
+      else {
+        outputs[i] = (avframe as VideoFrame).clone()
+      }
+    }
+  }
+}
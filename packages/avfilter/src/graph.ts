@@ -1,4 +1,5 @@
 import RangeFilterNode from './RangeFilterNode'
+import SplitFilterNode from './SplitFilterNode'
 import ResampleFilterNode from './audio/ResampleFilterNode'
 import FramerateFilterNode from './video/FramerateFilterNode'
 import ScaleFilterNode from './video/ScaleFilterNode'
@@ -11,7 +12,7 @@ type ConstructorParameters<T extends abstract new (...args: any) => any> =
 type FirstConstructorParameter<T extends abstract new (...args: any) => any> =
   ConstructorParameters<T>[0]
 
-export type GraphNodeType = 'resampler' | 'scaler' | 'range' | 'framerate'
+export type GraphNodeType = 'resampler' | 'scaler' | 'range' | 'framerate' | 'split'
 
 type GraphNodeType2AVFilterConstructor<T extends GraphNodeType> =
   T extends 'resampler'
@@ -22,7 +23,9 @@ type GraphNodeType2AVFilterConstructor<T extends GraphNodeType> =
         ? typeof RangeFilterNode
         : T extends 'framerate'
           ? typeof FramerateFilterNode
-          : never
+          : T extends 'split'
+            ? typeof SplitFilterNode
+            : never
 
 type GraphNodeType2AVFilter<T extends GraphNodeType> =
   T extends 'resampler'
@@ -33,7 +36,9 @@ type GraphNodeType2AVFilter<T extends GraphNodeType> =
         ? RangeFilterNode
         : T extends 'framerate'
           ? FramerateFilterNode
-          : never
+          : T extends 'split'
+            ? SplitFilterNode
+            : never
 
 type AVFilterGraphFilterOptions<T extends GraphNodeType> = FirstConstructorParameter<GraphNodeType2AVFilterConstructor<T>>
 
@@ -82,6 +87,8 @@ function createFilter(vertex: AVFilterGraphDesVertex<GraphNodeType>, avframePool
       return new RangeFilterNode(options as AVFilterGraphFilterOptions<'range'>)
     case 'framerate':
       return new FramerateFilterNode(options as AVFilterGraphFilterOptions<'framerate'>)
+    case 'split':
+      return new SplitFilterNode(options as AVFilterGraphFilterOptions<'split'>)
     default:
       throw new Error(`invalid GraphNodeType, ${vertex.type}`)
   }
@@ -81,6 +81,11 @@ export interface AudioDecodeTaskOptions extends TaskOptions {
   avpacketListMutex: pointer<Mutex>
   avframeList: pointer<List<pointer<AVFrameRef>>>
   avframeListMutex: pointer<Mutex>
+  /**
+   * wasm 解码器直接输出 planar float 的采样率和声道数，和渲染参数一致时渲染端不再需要重采样
+   */
+  outputSampleRate?: int32
+  outputChannels?: int32
 }
 
 type SelfTask = Omit<AudioDecodeTaskOptions, 'resource'> & {
@@ -138,7 +143,13 @@ export default class AudioDecodePipeline extends Pipeline {
           task.stats.audioFrameDecodeIntervalMax
         )
       },
-      avframePool: task.avframePool
+      avframePool: task.avframePool,
+      output: task.outputSampleRate && task.outputChannels
+        ? {
+          sampleRate: task.outputSampleRate,
+          channels: task.outputChannels
+        }
+        : undefined
     })
   }
 
@@ -38,11 +38,13 @@ import {
   type AVPacketRef,
   AVPacketPoolImpl,
   AVFramePoolImpl,
-  type AVRational
+  type AVRational,
+  hasWasmExport
 } from '@libmedia/avutil'
 
 import {
   isPointer,
+  WebAssemblyRunner,
   type WebAssemblyResource,
   type Mutex,
   type List
@@ -77,6 +79,10 @@ export interface AudioEncodeTaskOptions extends TaskOptions {
   avframeList: pointer<List<pointer<AVFrameRef>>>
   avframeListMutex: pointer<Mutex>
   copyTs?: boolean
+  /**
+   * 共享 wasm 模块的 key，同一个线程中 key 相同的任务共用一个 wasm 实例，每个任务只创建独立的编码上下文
+   */
+  sharedModuleKey?: string
 }
 
 type SelfTask = Omit<AudioEncodeTaskOptions, 'resource'> & {
@@ -90,12 +96,45 @@ type SelfTask = Omit<AudioEncodeTaskOptions, 'resource'> & {
   wasmEncoderOptions?: Data
 }
 
+interface SharedModule {
+  runner: WebAssemblyRunner
+  ready: Promise<void>
+  refCount: number
+}
+
 export default class AudioEncodePipeline extends Pipeline {
 
   declare tasks: Map<string, SelfTask>
 
+  private sharedModules: Map<string, SharedModule>
+
   constructor() {
     super()
+    this.sharedModules = new Map()
+  }
+
+  private retainSharedModule(key: string, resource: WebAssemblyResource) {
+    let module = this.sharedModules.get(key)
+    if (!module) {
+      const runner = new WebAssemblyRunner(resource)
+      module = {
+        runner,
+        ready: runner.run(),
+        refCount: 0
+      }
+      this.sharedModules.set(key, module)
+      logger.debug(`create shared audio encoder module, key: ${key}`)
+    }
+    module.refCount++
+  }
+
+  private releaseSharedModule(key: string) {
+    const module = this.sharedModules.get(key)
+    if (module && --module.refCount <= 0) {
+      module.runner.destroy()
+      this.sharedModules.delete(key)
+      logger.debug(`destroy shared audio encoder module, key: ${key}`)
+    }
   }
 
   private createWebcodecEncoder(task: SelfTask) {
@@ -136,9 +175,20 @@ export default class AudioEncodePipeline extends Pipeline {
       avpacketPool
     }
 
+    if (task.sharedModuleKey) {
+      // 旧版本编译的 wasm 没有多实例接口，只能独占一个模块
+      if (task.resource && hasWasmExport(task.resource, 'encoder_create')) {
+        this.retainSharedModule(task.sharedModuleKey, task.resource)
+      }
+      else {
+        task.sharedModuleKey = null
+      }
+    }
+
     if (task.resource) {
       task.encoder = new WasmAudioEncoder({
         resource: task.resource,
+        runner: task.sharedModuleKey ? this.sharedModules.get(task.sharedModuleKey).runner : null,
         onReceiveAVPacket(avpacket) {
           task.avpacketCaches.push(reinterpret_cast<pointer<AVPacketRef>>(avpacket))
           task.stats.audioPacketEncodeCount++
@@ -232,6 +282,9 @@ export default class AudioEncodePipeline extends Pipeline {
     if (task) {
       task.wasmEncoderOptions = wasmEncoderOptions
       return new Promise<number>(async (resolve, reject) => {
+        if (task.sharedModuleKey) {
+          await this.sharedModules.get(task.sharedModuleKey).ready
+        }
         const ret = await task.encoder.open(parameters, timeBase, task.wasmEncoderOptions)
         if (ret) {
           logger.error(`open audio encoder failed, error: ${ret}`)
@@ -282,6 +335,9 @@ export default class AudioEncodePipeline extends Pipeline {
       task.rightPort.close()
       task.leftPort.close()
       task.encoder.close()
+      if (task.sharedModuleKey) {
+        this.releaseSharedModule(task.sharedModuleKey)
+      }
       task.avpacketCaches.forEach((avpacket) => {
         task.avpacketPool.release(avpacket)
       })
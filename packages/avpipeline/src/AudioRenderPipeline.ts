@@ -81,7 +81,8 @@ import {
 } from '@libmedia/audioresample'
 
 import {
-  StretchPitcher
+  StretchPitcher,
+  StretchPitchQuality
 } from '@libmedia/audiostretchpitch'
 
 import type { TaskOptions } from './Pipeline'
@@ -91,6 +92,9 @@ import type { Timeout } from '@libmedia/common'
 
 const MASTER_SYNC_THRESHOLD = 400n
 
+// 追帧时 tempo 偏离 1 在此范围内使用低开销的变速档位
+const CHEAP_QUALITY_TEMPO_RANGE = 0.25
+
 export interface AudioRenderTaskOptions extends TaskOptions {
   playSampleRate: int32
   playFormat: AVSampleFormat
@@ -112,7 +116,7 @@ type SelfTask = AudioRenderTaskOptions & {
   resamplerResource: WebAssemblyResource
   stretchpitcherResource: WebAssemblyResource
   resampler: Resampler
-  stretchpitcher: Map<int32, StretchPitcher>
+  stretchpitcher: StretchPitcher
   outPCMBuffer: AVPCMBuffer
 
   waitPCMBuffer: pointer<AVPCMBufferRef>
@@ -127,6 +131,7 @@ type SelfTask = AudioRenderTaskOptions & {
   playPitch: double
 
   useStretchpitcher: boolean
+  stretchpitcherQuality: StretchPitchQuality
 
   firstPlayed: boolean
   lastNotifyPTS: int64
@@ -180,7 +185,7 @@ export default class AudioRenderPipeline extends Pipeline {
       resamplerResource: await compileResource(options.resamplerResource),
       stretchpitcherResource: await compileResource(options.stretchpitcherResource),
       resampler: null,
-      stretchpitcher: new Map(),
+      stretchpitcher: null,
       outPCMBuffer: null,
       waitPCMBuffer: nullptr,
       waitAVFrame: nullptr,
@@ -193,6 +198,7 @@ export default class AudioRenderPipeline extends Pipeline {
       playPitch: 1,
 
       useStretchpitcher: false,
+      stretchpitcherQuality: StretchPitchQuality.MUSIC,
       lastNotifyPTS: 0n,
       currentPTS: NOPTS_VALUE_BIGINT,
       lastMasterPts: NOPTS_VALUE_BIGINT,
@@ -217,22 +223,18 @@ export default class AudioRenderPipeline extends Pipeline {
       avframePool: new AVFramePoolImpl(accessof(options.avframeList), options.avframeListMutex)
     }
 
-    for (let i = 0; i < options.playChannels; i++) {
-
-      const stretchpitcher = new StretchPitcher({
-        resource: task.stretchpitcherResource
-      })
-
-      task.stretchpitcher.set(i, stretchpitcher)
-
-      await stretchpitcher.open({
-        sampleRate: options.playSampleRate,
-        channels: 1
-      })
-      stretchpitcher.setTempo(task.playTempo)
-      stretchpitcher.setPitch(task.playPitch)
-      stretchpitcher.setRate(task.playRate)
-    }
+    // 所有声道在一个实例中处理，声道之间共用一次 WSOLA 搜索，不会产生相位漂移
+    task.stretchpitcher = new StretchPitcher({
+      resource: task.stretchpitcherResource
+    })
+    await task.stretchpitcher.open({
+      sampleRate: options.playSampleRate,
+      channels: options.playChannels
+    })
+    task.stretchpitcher.setTempo(task.playTempo)
+    task.stretchpitcher.setPitch(task.playPitch)
+    task.stretchpitcher.setRate(task.playRate)
+    this.updateStretchpitcherQuality(task)
 
     const pullNewAudioFrame = async () => {
       let audioFrame: pointer<AVFrameRef>
@@ -245,10 +247,7 @@ export default class AudioRenderPipeline extends Pipeline {
       }
 
       if (audioFrame === IOError.END) {
-        for (let i = 0; i < task.playChannels; i++) {
-          const stretchpitcher = task.stretchpitcher.get(i)
-          stretchpitcher.flush()
-        }
+        task.stretchpitcher.flush()
         logger.info(`audio render ended, taskId: ${task.taskId}`)
         return IOError.END
       }
@@ -344,13 +343,7 @@ export default class AudioRenderPipeline extends Pipeline {
             task.waitPCMBufferPos = 0
           }
           else {
-            for (let i = 0; i < task.playChannels; i++) {
-              const stretchpitcher = task.stretchpitcher.get(i)
-              stretchpitcher.sendSamples(
-                reinterpret_cast<pointer<float>>(pcmBuffer.data[i]),
-                pcmBuffer.nbSamples
-              )
-            }
+            task.stretchpitcher.sendAVPCMBuffer(pcmBuffer)
             this.avPCMBufferPool.release(pcmBuffer)
           }
         }
@@ -377,13 +370,10 @@ export default class AudioRenderPipeline extends Pipeline {
             releaseAudioFrame = false
           }
           else {
-            for (let i = 0; i < task.playChannels; i++) {
-              const stretchpitcher = task.stretchpitcher.get(i)
-              stretchpitcher.sendSamples(
-                reinterpret_cast<pointer<float>>(audioFrame.extendedData[i]),
-                audioFrame.nbSamples
-              )
-            }
+            task.stretchpitcher.sendPlanarSamples(
+              reinterpret_cast<pointer<pointer<float>>>(audioFrame.extendedData),
+              audioFrame.nbSamples
+            )
           }
         }
 
@@ -418,16 +408,11 @@ export default class AudioRenderPipeline extends Pipeline {
       }
 
       if (task.ended && task.useStretchpitcher) {
-        let ret = 0
-        for (let i = 0; i < task.playChannels; i++) {
-          const stretchpitcher = task.stretchpitcher.get(i)
-          if (pcmBuffer.data[i]) {
-            ret = stretchpitcher.receiveSamples(
-              reinterpret_cast<pointer<float>>(reinterpret_cast<pointer<float>>(pcmBuffer.data[i]) + receive),
-              pcmBuffer.maxnbSamples - receive
-            )
-          }
-        }
+        const ret = task.stretchpitcher.receivePlanarSamples(
+          reinterpret_cast<pointer<pointer<float>>>(pcmBuffer.data),
+          pcmBuffer.maxnbSamples - receive,
+          receive
+        )
         if (receive + ret < pcmBuffer.maxnbSamples) {
           task.stretchpitcherEnded = true
           for (let i = 0; i < task.playChannels; i++) {
@@ -472,15 +457,11 @@ export default class AudioRenderPipeline extends Pipeline {
           }
         }
         else {
-          for (let i = 0; i < task.playChannels; i++) {
-            const stretchpitcher = task.stretchpitcher.get(i)
-            if (pcmBuffer.data[i]) {
-              len = stretchpitcher.receiveSamples(
-                reinterpret_cast<pointer<float>>(reinterpret_cast<pointer<float>>(pcmBuffer.data[i]) + receive),
-                pcmBuffer.maxnbSamples - receive
-              )
-            }
-          }
+          len = task.stretchpitcher.receivePlanarSamples(
+            reinterpret_cast<pointer<pointer<float>>>(pcmBuffer.data),
+            pcmBuffer.maxnbSamples - receive,
+            receive
+          )
         }
 
         receive += len
@@ -490,16 +471,12 @@ export default class AudioRenderPipeline extends Pipeline {
           if (ret === IOError.END) {
             task.ended = true
             if (task.useStretchpitcher) {
-              for (let i = 0; i < task.playChannels; i++) {
-                const stretchpitcher = task.stretchpitcher.get(i)
-                if (pcmBuffer.data[i]) {
-                  stretchpitcher.flush()
-                  ret = stretchpitcher.receiveSamples(
-                    reinterpret_cast<pointer<float>>(reinterpret_cast<pointer<float>>(pcmBuffer.data[i]) + receive),
-                    pcmBuffer.maxnbSamples - receive
-                  )
-                }
-              }
+              task.stretchpitcher.flush()
+              ret = task.stretchpitcher.receivePlanarSamples(
+                reinterpret_cast<pointer<pointer<float>>>(pcmBuffer.data),
+                pcmBuffer.maxnbSamples - receive,
+                receive
+              )
               if (receive + ret < pcmBuffer.maxnbSamples) {
                 task.stretchpitcherEnded = true
                 for (let i = 0; i < task.playChannels; i++) {
@@ -650,9 +627,27 @@ export default class AudioRenderPipeline extends Pipeline {
       || task.enableJitterBuffer
 
     if (task.useStretchpitcher && !use) {
-      for (let i = 0; i < task.playChannels; i++) {
-        task.stretchpitcher.get(i).flush()
-      }
+      task.stretchpitcher.flush()
+    }
+  }
+
+  /**
+   * 直播开启 jitter buffer 时变速只用于追帧，tempo 接近 1 且没有变调时切换到低开销档位，
+   * 其余情况使用音乐档位
+   */
+  private updateStretchpitcherQuality(task: SelfTask) {
+    const quality = task.isLive
+      && task.enableJitterBuffer
+      && task.playRate === 1
+      && task.playPitch === 1
+      && Math.abs(task.playTempo - 1) <= CHEAP_QUALITY_TEMPO_RANGE
+      ? StretchPitchQuality.CHEAP
+      : StretchPitchQuality.MUSIC
+
+    if (quality !== task.stretchpitcherQuality) {
+      task.stretchpitcherQuality = quality
+      task.stretchpitcher.setQuality(quality)
+      logger.debug(`set stretchpitcher quality to ${quality === StretchPitchQuality.CHEAP ? 'cheap' : 'music'}, taskId: ${task.taskId}`)
     }
   }
 
@@ -668,10 +663,9 @@ export default class AudioRenderPipeline extends Pipeline {
       }
 
       task.playRate = rate
-      for (let i = 0; i < task.playChannels; i++) {
-        task.stretchpitcher.get(i).setRate(rate)
-      }
+      task.stretchpitcher.setRate(rate)
       this.checkUseStretchpitcher(task)
+      this.updateStretchpitcherQuality(task)
       task.masterTimer.setRate(task.playRate * task.playTempo)
       if (task.fakePlay) {
         task.fakePlayStartTimestamp = getTimestamp()
@@ -684,10 +678,9 @@ export default class AudioRenderPipeline extends Pipeline {
     const task = this.tasks.get(taskId)
     if (task) {
       task.playTempo = tempo
-      for (let i = 0; i < task.playChannels; i++) {
-        task.stretchpitcher.get(i).setTempo(tempo)
-      }
+      task.stretchpitcher.setTempo(tempo)
       this.checkUseStretchpitcher(task)
+      this.updateStretchpitcherQuality(task)
       task.masterTimer.setRate(task.playRate * task.playTempo)
       if (task.fakePlay) {
         task.fakePlayStartTimestamp = getTimestamp()
@@ -700,10 +693,9 @@ export default class AudioRenderPipeline extends Pipeline {
     const task = this.tasks.get(taskId)
     if (task) {
       task.playPitch = pitch
-      for (let i = 0; i < task.playChannels; i++) {
-        task.stretchpitcher.get(i).setPitch(pitch)
-      }
+      task.stretchpitcher.setPitch(pitch)
       this.checkUseStretchpitcher(task)
+      this.updateStretchpitcherQuality(task)
     }
   }
 
@@ -722,10 +714,8 @@ export default class AudioRenderPipeline extends Pipeline {
 
       task.seeking = true
 
-      if (task.stretchpitcher.size) {
-        for (const key of task.stretchpitcher.keys()) {
-          task.stretchpitcher.get(key).clear()
-        }
+      if (task.stretchpitcher) {
+        task.stretchpitcher.clear()
       }
       if (task.waitPCMBuffer) {
         if (task.waitAVFrame) {
@@ -849,10 +839,8 @@ export default class AudioRenderPipeline extends Pipeline {
       task.ended = false
       task.firstPlayed = false
       task.stretchpitcherEnded = false
-      if (task.stretchpitcher?.size) {
-        for (let i = 0; i < task.playChannels; i++) {
-          task.stretchpitcher.get(i)?.clear()
-        }
+      if (task.stretchpitcher) {
+        task.stretchpitcher.clear()
       }
       this.clearFakePlayTimer(task)
       task.fakePlaySamples = 0n
@@ -883,7 +871,7 @@ export default class AudioRenderPipeline extends Pipeline {
   }
 
   private syncPts(task: SelfTask, maxnbSamples: int32) {
-    const latency = (((task.useStretchpitcher ? task.stretchpitcher.get(0).getLatency() : 0)
+    const latency = (((task.useStretchpitcher ? task.stretchpitcher.getLatency() : 0)
         // 双缓冲，假定后缓冲播放到中间
         + (maxnbSamples * 3 >>> 1)) / task.playSampleRate * 1000) >>> 0
     const currentPts = bigint.max(task.currentPTS - static_cast<int64>(latency), 0n)
@@ -1072,11 +1060,9 @@ export default class AudioRenderPipeline extends Pipeline {
       if (task.resampler) {
         task.resampler.close()
       }
-      if (task.stretchpitcher.size) {
-        for (const key of task.stretchpitcher.keys()) {
-          task.stretchpitcher.get(key).close()
-        }
-        task.stretchpitcher.clear()
+      if (task.stretchpitcher) {
+        task.stretchpitcher.close()
+        task.stretchpitcher = null
       }
       if (task.outPCMBuffer) {
         avFreep(addressof(task.outPCMBuffer.data[0]))
@@ -0,0 +1,85 @@
+/*
+ * libmedia decode scheduler
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ *
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ *
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import { nextTick } from '@libmedia/common'
+
+interface Waiter {
+  deadline: number
+  resolve: () => void
+}
+
+/**
+ * 同一个线程中多个解码任务的最早截止时间优先调度
+ *
+ * 同一时刻只放行一个任务解码，其余任务按截止时间排队；放行推迟到下一个 tick，
+ * 让这段时间内到达的任务都参与排序，截止时间最早的先解码
+ */
+export default class DecodeScheduler {
+
+  private waiters: Waiter[] = []
+
+  private running: boolean = false
+
+  private dispatching: boolean = false
+
+  /**
+   * 等待轮到自己解码，解码完成之后必须调用 release
+   *
+   * @param deadline 截止时间，越小越先解码
+   */
+  public acquire(deadline: number) {
+    return new Promise<void>((resolve) => {
+      let i = this.waiters.length
+      while (i > 0 && this.waiters[i - 1].deadline > deadline) {
+        i--
+      }
+      this.waiters.splice(i, 0, {
+        deadline,
+        resolve
+      })
+      this.dispatch()
+    })
+  }
+
+  public release() {
+    this.running = false
+    this.dispatch()
+  }
+
+  private dispatch() {
+    if (this.running || this.dispatching || !this.waiters.length) {
+      return
+    }
+    this.dispatching = true
+    nextTick(() => {
+      this.dispatching = false
+      if (this.running || !this.waiters.length) {
+        return
+      }
+      this.running = true
+      this.waiters.shift().resolve()
+    })
+  }
+}
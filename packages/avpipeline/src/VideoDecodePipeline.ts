@@ -51,14 +51,19 @@ import {
   getAVPacketSideData,
   NOPTS_VALUE,
   avQ2D,
+  avRescaleQ,
   avRescaleQ2,
   AVCodecID,
   AVPacketSideDataType,
-  AVPacketFlags
+  AVPacketFlags,
+  refAVPacket,
+  NOPTS_VALUE_BIGINT,
+  hasWasmExport
 } from '@libmedia/avutil'
 
 import {
   AV_MILLI_TIME_BASE_Q,
+  AV_TIME_BASE_Q,
   h264,
   hevc,
   vvc
@@ -67,6 +72,7 @@ import {
 import {
   isPointer,
   type WebAssemblyResource,
+  WebAssemblyRunner,
   type Mutex,
   type List,
   memcpy
@@ -92,11 +98,15 @@ import {
 import {
   WasmVideoDecoder,
   AVDiscard,
-  WebVideoDecoder
+  DecoderThreadType,
+  DecoderFastLevel,
+  WebVideoDecoder,
+  getVideoDecoderThreadOptions
 } from '@libmedia/avcodec'
 
 import type { TaskOptions } from './Pipeline'
 import Pipeline from './Pipeline'
+import DecodeScheduler from './DecodeScheduler'
 
 import type { AlphaVideoFrame } from './struct/type'
 import { isAlphaVideoFrame } from './util'
@@ -113,8 +123,55 @@ export interface VideoDecodeTaskOptions extends TaskOptions {
   preferWebCodecs?: boolean
   preferLatency?: boolean
   keepAlpha?: boolean
+  /**
+   * 监督模式，监控硬解的错误和卡顿，出现异常时切换到软解并从 GOP 开始处重新送入缓存的包，不需要等待下一个关键帧
+   * 
+   * 切换之后间隔一段时间在关键帧处尝试切回硬解
+   */
+  supervise?: boolean
+  /**
+   * 共享 wasm 模块的 key，同一个线程中 key 相同的任务共用一个 wasm 实例，每个任务只创建独立的解码上下文
+   * 
+   * 共享模式下软解使用单线程解码，并行度由线程数量决定
+   */
+  sharedModuleKey?: string
+  /**
+   * 参与线程内的截止时间调度，下一帧播放时间越近的任务越先解码
+   */
+  schedule?: boolean
+  /**
+   * 根据解码耗时预测包的解码完成时间会晚于播放时间时，主动跳过非参考帧的解码，追上之后恢复
+   * 
+   * 只对 wasm 软解生效
+   */
+  deadlineDiscard?: boolean
+  /**
+   * 把 wasm 编解码的调用统计写入 stats，需要 wasm 编译时开启 enable_codec_stats
+   */
+  codecStats?: boolean
 }
 
+interface SharedModule {
+  runner: WebAssemblyRunner
+  ready: Promise<void>
+  refCount: number
+}
+
+// 监督模式下一个 GOP 最多缓存的包数，超过之后不再缓存，切换时只能等待下一个关键帧
+const SUPERVISE_MAX_GOP_PACKETS = 300
+// 硬解有待解码的包但超过这个时间（毫秒）没有输出帧判定为卡住
+const SUPERVISE_STALL_TIMEOUT = 1000
+// 切换到软解之后尝试切回硬解的间隔（毫秒），每次硬解出错翻倍
+const SUPERVISE_RECOVER_INTERVAL = 10000
+const SUPERVISE_RECOVER_INTERVAL_MAX = 120000
+// 错误率统计窗口（毫秒），窗口内硬解出错次数达到上限之后不再切回硬解
+const SUPERVISE_ERROR_WINDOW = 60000
+const SUPERVISE_MAX_ERRORS = 5
+// 单帧解码耗时的滑动平均权重
+const DEADLINE_COST_WEIGHT = 0.1
+// 领先播放时间超过预测解码耗时的这个倍数之后恢复解码非参考帧
+const DEADLINE_RECOVER_FACTOR = 3
+
 type SelfTask = Omit<VideoDecodeTaskOptions, 'resource'> & {
   resource: WebAssemblyResource
   leftIPCPort: IPCPort
@@ -146,6 +203,55 @@ type SelfTask = Omit<VideoDecodeTaskOptions, 'resource'> & {
   wasmDecoderOptions?: Data
   discard: AVDiscard
   playRate: double
+
+  /**
+   * 监督模式下从最近一个关键帧开始缓存的包
+   */
+  gopPackets: pointer<AVPacketRef>[]
+  gopOverflow: boolean
+  /**
+   * 最后输出的帧的时间戳（微秒）
+   */
+  lastOutputTimestamp: number
+  /**
+   * 最后输出帧或者硬解开始有待解码包的时间
+   */
+  lastOutputTime: number
+  /**
+   * 切换解码器重新送入 GOP 之后，时间戳不大于这个值的帧已经输出过，需要丢弃
+   */
+  dropTimestamp: number
+  failoverRequested: boolean
+  failoverTime: number
+  recoverInterval: number
+  hardwareErrors: number[]
+
+  /**
+   * 精确 seek 的目标时间（微秒），之前的帧直接丢弃不输出
+   */
+  seekTimestamp: number
+  /**
+   * 当前是否为了精确 seek 设置了跳过非参考帧
+   */
+  seekDiscard: boolean
+
+  /**
+   * 不可见时只解码关键帧
+   */
+  keyframeOnly: boolean
+
+  /**
+   * wasm 软解单帧解码耗时的滑动平均（毫秒）
+   */
+  decodeCost: number
+  /**
+   * 当前是否因为预测来不及解码设置了跳过非参考帧
+   */
+  deadlineDiscarding: boolean
+  /**
+   * 重置时的播放时间，播放时间更新之前不做截止时间判断
+   */
+  resetCurrentTime: int64
 }
 
 export interface VideoDecodeTaskInfo {
@@ -154,19 +260,71 @@ export interface VideoDecodeTaskInfo {
   height: int32
   framerate: float
   hardware: boolean
+  /**
+   * 软解的解码延迟帧数
+   */
+  delay: int32
 }
 
 export default class VideoDecodePipeline extends Pipeline {
 
   declare tasks: Map<string, SelfTask>
 
+  private sharedModules: Map<string, SharedModule>
+
+  private scheduler: DecodeScheduler
+
   constructor() {
     super()
+    this.sharedModules = new Map()
+    this.scheduler = new DecodeScheduler()
+  }
+
+  private retainSharedModule(key: string, resource: WebAssemblyResource) {
+    let module = this.sharedModules.get(key)
+    if (!module) {
+      const runner = new WebAssemblyRunner(resource)
+      module = {
+        runner,
+        ready: runner.run(undefined, 1),
+        refCount: 0
+      }
+      this.sharedModules.set(key, module)
+      logger.debug(`create shared video decoder module, key: ${key}`)
+    }
+    module.refCount++
+  }
+
+  private releaseSharedModule(key: string) {
+    const module = this.sharedModules.get(key)
+    if (module && --module.refCount <= 0) {
+      module.runner.destroy()
+      this.sharedModules.delete(key)
+      logger.debug(`destroy shared video decoder module, key: ${key}`)
+    }
+  }
+
+  /**
+   * 截止时间取包的播放时间领先当前渲染时间的量（毫秒），越小越紧急
+   */
+  private getDeadline(task: SelfTask, avpacket: pointer<AVPacketRef>) {
+    const timestamp = avpacket.pts !== NOPTS_VALUE_BIGINT ? avpacket.pts : avpacket.dts
+    if (timestamp === NOPTS_VALUE_BIGINT) {
+      return 0
+    }
+    return static_cast<double>(avRescaleQ2(timestamp, addressof(avpacket.timeBase), AV_MILLI_TIME_BASE_Q))
+      - static_cast<double>(task.stats.videoCurrentTime)
   }
 
   private createWebCodecDecoder(task: SelfTask, enableHardwareAcceleration: boolean = true) {
     return new WebVideoDecoder({
       onError: (error) => {
+        if (task.supervise && task.targetDecoder === task.hardwareDecoder && task.softwareDecoder) {
+          // 由解码循环在下一次送包之前切换到软解
+          logger.warn(`video decode error by hardware decoder, taskId: ${task.taskId}, error: ${error}, failover to software decoder`)
+          task.failoverRequested = true
+          return
+        }
         if (task.hardwareRetryCount > 3 || !task.firstDecoded) {
           if (task.targetDecoder === task.hardwareDecoder) {
             task.targetDecoder = task.softwareDecoder
@@ -197,10 +355,20 @@ export default class VideoDecodePipeline extends Pipeline {
         task.needKeyFrame = true
         task.leftIPCPort.request('requestKeyframe')
       },
-      onReceiveVideoFrame(frame, alpha) {
+      onReceiveVideoFrame: (frame, alpha) => {
+        if (task.supervise && !this.acceptFrame(task, frame.timestamp)
+          || !this.acceptSeekFrame(task, frame.timestamp)
+        ) {
+          frame.close()
+          if (alpha) {
+            alpha.close()
+          }
+          return
+        }
         if (alpha) {
           (frame as AlphaVideoFrame).alpha = alpha
         }
+        this.checkLateFrame(task, frame.timestamp)
         task.firstDecoded = true
         task.frameCaches.push(frame)
         task.stats.videoFrameDecodeCount++
@@ -221,7 +389,18 @@ export default class VideoDecodePipeline extends Pipeline {
   private createWasmcodecDecoder(task: SelfTask, resource: WebAssemblyResource) {
     return new WasmVideoDecoder({
       resource: resource,
-      onReceiveAVFrame(avframe) {
+      runner: task.sharedModuleKey ? this.sharedModules.get(task.sharedModuleKey)?.runner : null,
+      onReceiveAVFrame: (avframe) => {
+        const timestamp = avframe.pts === NOPTS_VALUE_BIGINT
+          ? NOPTS_VALUE
+          : static_cast<double>(avRescaleQ2(avframe.pts, addressof(avframe.timeBase), AV_TIME_BASE_Q))
+        if (task.supervise && !this.acceptFrame(task, timestamp)
+          || !this.acceptSeekFrame(task, timestamp)
+        ) {
+          task.avframePool.release(reinterpret_cast<pointer<AVFrameRef>>(avframe))
+          return
+        }
+        this.checkLateFrame(task, timestamp)
         task.firstDecoded = true
         task.frameCaches.push(reinterpret_cast<pointer<AVFrameRef>>(avframe))
         task.stats.videoFrameDecodeCount++
@@ -233,7 +412,8 @@ export default class VideoDecodePipeline extends Pipeline {
           task.lastDecodeTimestamp = NOPTS_VALUE
         }
       },
-      avframePool: task.avframePool
+      avframePool: task.avframePool,
+      stats: task.codecStats ? addressof(task.stats.videoDecoderStats) : nullptr
     })
   }
 
@@ -279,11 +459,36 @@ export default class VideoDecodePipeline extends Pipeline {
       softwareDecoderOpened: false,
       discard: AVDiscard.AVDISCARD_DEFAULT,
       playRate: 1,
+      gopPackets: [],
+      gopOverflow: false,
+      lastOutputTimestamp: NOPTS_VALUE,
+      lastOutputTime: 0,
+      dropTimestamp: NOPTS_VALUE,
+      failoverRequested: false,
+      failoverTime: 0,
+      recoverInterval: SUPERVISE_RECOVER_INTERVAL,
+      hardwareErrors: [],
+      seekTimestamp: NOPTS_VALUE,
+      seekDiscard: false,
+      keyframeOnly: false,
+      decodeCost: 0,
+      deadlineDiscarding: false,
+      resetCurrentTime: NOPTS_VALUE_BIGINT,
 
       avframePool,
       avpacketPool: new AVPacketPoolImpl(accessof(options.avpacketList), options.avpacketListMutex)
     }
 
+    if (task.sharedModuleKey) {
+      // 旧版本编译的 wasm 没有多实例接口，只能独占一个模块
+      if (task.resource && hasWasmExport(task.resource, 'decoder_create')) {
+        this.retainSharedModule(task.sharedModuleKey, task.resource)
+      }
+      else {
+        task.sharedModuleKey = null
+      }
+    }
+
     task.softwareDecoder = task.resource
       ? this.createWasmcodecDecoder(task, task.resource)
       : (support.videoDecoder ? this.createWebCodecDecoder(task, false) : null)
@@ -345,6 +550,20 @@ export default class VideoDecodePipeline extends Pipeline {
                 }
                 task.decoderFallbackReady = null
               }
+              if (task.supervise
+                && task.hardwareDecoder
+                && task.targetDecoder === task.hardwareDecoder
+                && task.softwareDecoder
+                && (task.failoverRequested || this.isHardwareStalled(task))
+              ) {
+                const ret = await this.failover(task, task.failoverRequested ? 'decode error' : 'stalled')
+                if (ret < 0) {
+                  logger.error(`video decoder failover failed, taskId: ${task.taskId}, ret: ${ret}`)
+                  rightIPCPort.reply(request, ret)
+                  break
+                }
+                continue
+              }
               if (task.lastDecodeTimestamp === NOPTS_VALUE) {
                 task.lastDecodeTimestamp = getTimestamp()
               }
@@ -420,7 +639,49 @@ export default class VideoDecodePipeline extends Pipeline {
                     continue
                   }
                 }
-                let ret = task.targetDecoder.decode(avpacket)
+                if (task.keyframeOnly && !(avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY)) {
+                  task.avpacketPool.release(avpacket)
+                  continue
+                }
+                if (task.supervise) {
+                  if ((avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY) && this.canRecoverHardware(task)) {
+                    await this.recoverHardware(task)
+                  }
+                  this.cacheGopPacket(task, avpacket)
+                  if (task.targetDecoder === task.hardwareDecoder && !task.hardwareDecoder.getQueueLength()) {
+                    task.lastOutputTime = getTimestamp()
+                  }
+                }
+
+                if (task.seekTimestamp !== NOPTS_VALUE) {
+                  this.updateSeekDiscard(task, avpacket)
+                }
+
+                if (task.schedule) {
+                  await this.scheduler.acquire(this.getDeadline(task, avpacket))
+                }
+                let ret: int32
+                try {
+                  if (task.deadlineDiscard) {
+                    this.updateDeadlineDiscard(task, avpacket)
+                  }
+                  const decodeCount = task.stats.videoFrameDecodeCount
+                  const decodeStart = getTimestamp()
+                  ret = task.targetDecoder.decode(avpacket)
+                  if (task.targetDecoder instanceof WasmVideoDecoder && ret >= 0) {
+                    this.updateDecodeCost(task, getTimestamp() - decodeStart)
+                    // 近似统计：跳过非参考帧期间送入的包没有输出帧认为被丢弃
+                    if (task.deadlineDiscarding && task.firstDecoded && task.stats.videoFrameDecodeCount === decodeCount) {
+                      task.stats.videoDeadlineDropFrameCount++
+                    }
+                  }
+                }
+                finally {
+                  // 解码抛异常时也要归还名额，否则其他任务会一直等待
+                  if (task.schedule) {
+                    this.scheduler.release()
+                  }
+                }
 
                 if (avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY) {
                   // 更新 task.parameters 到最新的 extradata
@@ -437,6 +698,17 @@ export default class VideoDecodePipeline extends Pipeline {
 
                 if (ret < 0) {
                   task.stats.videoDecodeErrorPacketCount++
+                  // 监督模式下硬解失败直接切换到软解，当前包已经在 GOP 缓存中，会一起重新送入
+                  if (task.supervise && task.targetDecoder === task.hardwareDecoder && task.softwareDecoder) {
+                    task.avpacketPool.release(avpacket)
+                    ret = await this.failover(task, `decode error ${ret}`)
+                    if (ret < 0) {
+                      logger.error(`video decoder failover failed, taskId: ${task.taskId}, ret: ${ret}`)
+                      rightIPCPort.reply(request, ret)
+                      break
+                    }
+                    continue
+                  }
                   // 硬解或者 webcodecs 软解失败
                   if ((task.targetDecoder instanceof WebVideoDecoder) && task.softwareDecoder) {
 
@@ -514,6 +786,13 @@ export default class VideoDecodePipeline extends Pipeline {
                 while (task.targetDecoder instanceof WebVideoDecoder
                   && task.targetDecoder.getQueueLength() > 20
                 ) {
+                  // 硬解卡住时跳出，由解码循环切换到软解
+                  if (task.supervise
+                    && task.targetDecoder === task.hardwareDecoder
+                    && (task.failoverRequested || this.isHardwareStalled(task))
+                  ) {
+                    break
+                  }
                   await new Sleep(0)
                 }
                 continue
@@ -536,64 +815,261 @@ export default class VideoDecodePipeline extends Pipeline {
     return 0
   }
 
+  /**
+   * 监督模式下过滤切换解码器之后重复输出的帧
+   * 
+   * @param timestamp 帧时间戳（微秒）
+   */
+  private acceptFrame(task: SelfTask, timestamp: number) {
+    task.lastOutputTime = getTimestamp()
+    if (timestamp === NOPTS_VALUE) {
+      return true
+    }
+    if (task.dropTimestamp !== NOPTS_VALUE) {
+      if (timestamp <= task.dropTimestamp) {
+        return false
+      }
+      task.dropTimestamp = NOPTS_VALUE
+    }
+    task.lastOutputTimestamp = timestamp
+    return true
+  }
+
+  /**
+   * 精确 seek 时丢弃目标时间之前的帧，这些帧不再做格式转换和传递给渲染
+   * 
+   * @param timestamp 帧时间戳（微秒）
+   */
+  private acceptSeekFrame(task: SelfTask, timestamp: number) {
+    if (task.seekTimestamp === NOPTS_VALUE
+      || timestamp === NOPTS_VALUE
+      || timestamp >= task.seekTimestamp
+    ) {
+      return true
+    }
+    task.stats.videoSeekDiscardFrameCount++
+    return false
+  }
+
+  /**
+   * 精确 seek 时目标时间之前的包跳过非参考帧的解码，到达目标之后恢复
+   * 
+   * 只对 wasm 软解生效，webcodecs 只能在输出之后丢弃
+   */
+  private updateSeekDiscard(task: SelfTask, avpacket: pointer<AVPacketRef>) {
+    if (!(task.targetDecoder instanceof WasmVideoDecoder)) {
+      return
+    }
+    const pts = avpacket.pts !== NOPTS_VALUE_BIGINT ? avpacket.pts : avpacket.dts
+    const discard = pts !== NOPTS_VALUE_BIGINT
+      && static_cast<double>(avRescaleQ2(pts, addressof(avpacket.timeBase), AV_TIME_BASE_Q)) < task.seekTimestamp
+    if (discard !== task.seekDiscard) {
+      task.seekDiscard = discard
+      this.applySkipFrameDiscard(task)
+    }
+  }
+
+  /**
+   * 精确 seek 或者截止时间需要时在 task.discard 的基础上至少跳过非参考帧
+   */
+  private applySkipFrameDiscard(task: SelfTask) {
+    task.targetDecoder.setSkipFrameDiscard(
+      (task.seekDiscard || task.deadlineDiscarding)
+        ? Math.max(task.discard, AVDiscard.AVDISCARD_NONREF)
+        : task.discard
+    )
+    // 硬解时软解作为备用，同步基础丢弃级别，切换过去之后直接生效
+    if (task.softwareDecoder && task.softwareDecoder !== task.targetDecoder) {
+      task.softwareDecoder.setSkipFrameDiscard(task.discard)
+    }
+  }
+
+  private updateDecodeCost(task: SelfTask, cost: number) {
+    task.decodeCost = task.decodeCost
+      ? task.decodeCost * (1 - DEADLINE_COST_WEIGHT) + cost * DEADLINE_COST_WEIGHT
+      : cost
+  }
+
+  /**
+   * 播放时间是否已经在重置之后更新，seek 之后播放时间更新之前不能作为截止时间的参考
+   */
+  private hasCurrentTime(task: SelfTask) {
+    return task.stats.videoCurrentTime !== task.resetCurrentTime
+  }
+
+  /**
+   * 统计输出时已经晚于播放时间的帧
+   * 
+   * @param timestamp 帧时间戳（微秒）
+   */
+  private checkLateFrame(task: SelfTask, timestamp: number) {
+    if (timestamp !== NOPTS_VALUE
+      && this.hasCurrentTime(task)
+      && timestamp / 1000 < static_cast<double>(task.stats.videoCurrentTime)
+    ) {
+      task.stats.videoLateFrameCount++
+    }
+  }
+
+  /**
+   * 用包的播放时间领先当前播放时间的量和预测的解码耗时（解码延迟帧数 + 1 帧）比较，
+   * 来不及时跳过非参考帧，领先足够多之后恢复
+   */
+  private updateDeadlineDiscard(task: SelfTask, avpacket: pointer<AVPacketRef>) {
+    if (!(task.targetDecoder instanceof WasmVideoDecoder)
+      || !task.decodeCost
+      || !this.hasCurrentTime(task)
+    ) {
+      return
+    }
+    const lead = this.getDeadline(task, avpacket) / task.playRate
+    const cost = task.decodeCost * (task.targetDecoder.getDelay() + 1)
+
+    let discard = task.deadlineDiscarding
+    if (!discard && lead < cost) {
+      discard = true
+    }
+    else if (discard && lead > cost * DEADLINE_RECOVER_FACTOR) {
+      discard = false
+    }
+    if (discard !== task.deadlineDiscarding) {
+      task.deadlineDiscarding = discard
+      this.applySkipFrameDiscard(task)
+      logger.debug(`video decoder deadline discard: ${discard}, lead: ${lead.toFixed(2)}ms, cost: ${cost.toFixed(2)}ms, taskId: ${task.taskId}`)
+    }
+  }
+
+  private cacheGopPacket(task: SelfTask, avpacket: pointer<AVPacketRef>) {
+    if (avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY) {
+      this.releaseGopPackets(task)
+    }
+    else if (task.gopOverflow) {
+      return
+    }
+    if (task.gopPackets.length >= SUPERVISE_MAX_GOP_PACKETS) {
+      this.releaseGopPackets(task)
+      task.gopOverflow = true
+      return
+    }
+    const ref = task.avpacketPool.alloc()
+    refAVPacket(ref, avpacket)
+    task.gopPackets.push(ref)
+  }
+
+  private releaseGopPackets(task: SelfTask) {
+    array.each(task.gopPackets, (avpacket) => {
+      task.avpacketPool.release(avpacket)
+    })
+    task.gopPackets.length = 0
+    task.gopOverflow = false
+  }
+
+  private isHardwareStalled(task: SelfTask) {
+    return task.hardwareDecoder.getQueueLength() > 0
+      && getTimestamp() - task.lastOutputTime > SUPERVISE_STALL_TIMEOUT
+  }
+
+  private recordHardwareError(task: SelfTask) {
+    const now = getTimestamp()
+    task.hardwareErrors.push(now)
+    while (task.hardwareErrors.length && now - task.hardwareErrors[0] > SUPERVISE_ERROR_WINDOW) {
+      task.hardwareErrors.shift()
+    }
+  }
+
+  /**
+   * 从硬解切换到软解，并从 GOP 开始处重新送入缓存的包，已经输出过的帧在 acceptFrame 中丢弃
+   */
+  private async failover(task: SelfTask, reason: string) {
+    logger.warn(`video hardware decoder ${reason}, failover to software decoder, cached packets: ${task.gopPackets.length}, taskId: ${task.taskId}`)
+
+    task.failoverRequested = false
+    task.stats.videoDecoderFailoverCount++
+
+    this.recordHardwareError(task)
+    if (task.failoverTime) {
+      // 切回硬解之后很快又出错，拉长下一次切回的间隔
+      task.recoverInterval = Math.min(task.recoverInterval * 2, SUPERVISE_RECOVER_INTERVAL_MAX)
+    }
+
+    task.hardwareDecoder.close()
+    task.hardwareDecoder = null
+    task.targetDecoder = task.softwareDecoder
+    task.failoverTime = getTimestamp()
+
+    const ret = await this.openSoftwareDecoder(task)
+    if (ret) {
+      return ret
+    }
+    // openSoftwareDecoder 可能回退到 wasm 解码器
+    task.targetDecoder = task.softwareDecoder
+
+    if (!task.gopPackets.length || task.gopOverflow) {
+      this.releaseGopPackets(task)
+      task.needKeyFrame = true
+      task.leftIPCPort.request('requestKeyframe')
+      return 0
+    }
+
+    task.dropTimestamp = task.lastOutputTimestamp
+
+    for (let i = 0; i < task.gopPackets.length; i++) {
+      const ret = task.targetDecoder.decode(task.gopPackets[i])
+      if (ret < 0) {
+        return ret
+      }
+    }
+    return 0
+  }
+
+  private canRecoverHardware(task: SelfTask) {
+    return !task.hardwareDecoder
+      && task.failoverTime
+      && task.enableHardware
+      && support.videoDecoder
+      && task.hardwareErrors.length < SUPERVISE_MAX_ERRORS
+      && getTimestamp() - task.failoverTime > task.recoverInterval
+  }
+
+  /**
+   * 在关键帧处切回硬解，软解中缓存的帧先 flush 出来
+   */
+  private async recoverHardware(task: SelfTask) {
+    const hardwareDecoder = this.createWebCodecDecoder(task)
+    const ret = await hardwareDecoder.open(task.parameters)
+    if (ret) {
+      hardwareDecoder.close()
+      this.recordHardwareError(task)
+      task.failoverTime = getTimestamp()
+      logger.warn(`recover video hardware decoder failed, ret: ${ret}, taskId: ${task.taskId}`)
+      return
+    }
+    await task.targetDecoder.flush()
+    task.hardwareDecoder = hardwareDecoder
+    task.targetDecoder = hardwareDecoder
+    task.hardwareRetryCount = 0
+    task.lastOutputTime = getTimestamp()
+    logger.info(`recover video hardware decoder, taskId: ${task.taskId}`)
+  }
+
   private async openSoftwareDecoder(task: SelfTask) {
     if (task.softwareDecoder && !task.softwareDecoderOpened) {
       const parameters = task.parameters
       let threadCount = 1
+      let threadType = DecoderThreadType.AUTO
 
-      if (isWorker()) {
-        let pixels = parameters.width * parameters.height
-        let framerate = avQ2D(parameters.framerate)
-        if (pixels >= 1920 * 1080 && pixels <= 2048 * 1080) {
-          if (parameters.codecId === AVCodecID.AV_CODEC_ID_HEVC
-            || parameters.codecId === AVCodecID.AV_CODEC_ID_VVC
-            || parameters.codecId === AVCodecID.AV_CODEC_ID_AV1
-          ) {
-            threadCount = 2
-          }
-          if (framerate > 30) {
-            threadCount = 2
-            if (parameters.codecId === AVCodecID.AV_CODEC_ID_HEVC
-              || parameters.codecId === AVCodecID.AV_CODEC_ID_VVC
-              || parameters.codecId === AVCodecID.AV_CODEC_ID_AV1
-            ) {
-              threadCount = 4
-            }
-          }
-          else if (framerate > 60) {
-            threadCount = 4
-            if (parameters.codecId === AVCodecID.AV_CODEC_ID_HEVC
-              || parameters.codecId === AVCodecID.AV_CODEC_ID_VVC
-              || parameters.codecId === AVCodecID.AV_CODEC_ID_AV1
-            ) {
-              threadCount = 6
-            }
-          }
-        }
-        else if (pixels > 2048 * 1080 && pixels <= 3840 * 2160) {
-          threadCount = 4
-          if (parameters.codecId === AVCodecID.AV_CODEC_ID_HEVC
-            || parameters.codecId === AVCodecID.AV_CODEC_ID_VVC
-            || parameters.codecId === AVCodecID.AV_CODEC_ID_AV1
-          ) {
-            threadCount = 6
-          }
-        }
-        else if (pixels > 3840 * 2160) {
-          threadCount = 6
-          if (parameters.codecId === AVCodecID.AV_CODEC_ID_HEVC
-            || parameters.codecId === AVCodecID.AV_CODEC_ID_VVC
-            || parameters.codecId === AVCodecID.AV_CODEC_ID_AV1
-          ) {
-            threadCount = 8
-          }
-        }
-        threadCount = Math.min(threadCount, navigator.hardwareConcurrency)
+      if ((task.softwareDecoder instanceof WasmVideoDecoder) && task.sharedModuleKey) {
+        await this.sharedModules.get(task.sharedModuleKey).ready
+      }
+      else if (isWorker()) {
+        const threadOptions = getVideoDecoderThreadOptions(parameters, task.preferLatency)
+        threadCount = threadOptions.threadCount
+        threadType = threadOptions.threadType
       }
 
       logger.debug(`open software(${task.softwareDecoder instanceof WebVideoDecoder ? 'webcodecs' : 'wasm'}) decoder`)
 
-      let ret = await task.softwareDecoder.open(parameters, threadCount, task.wasmDecoderOptions)
+      let ret = await task.softwareDecoder.open(parameters, threadCount, task.wasmDecoderOptions, threadType)
       if (ret) {
         if ((task.softwareDecoder instanceof WebVideoDecoder) && task.resource) {
 
@@ -601,7 +1077,7 @@ export default class VideoDecodePipeline extends Pipeline {
 
           task.softwareDecoder.close()
           task.softwareDecoder = this.createWasmcodecDecoder(task, task.resource)
-          ret = await task.softwareDecoder.open(parameters, threadCount)
+          ret = await task.softwareDecoder.open(parameters, threadCount, {}, threadType)
           if (ret) {
             return ret
           }
@@ -642,6 +1118,13 @@ export default class VideoDecodePipeline extends Pipeline {
 
       if (resource) {
         resource = await compileResource(resource, true)
+        // 新的模块不再和其他任务共享
+        if (task.sharedModuleKey) {
+          task.softwareDecoder?.close()
+          task.softwareDecoder = null
+          this.releaseSharedModule(task.sharedModuleKey)
+          task.sharedModuleKey = null
+        }
       }
 
       let softwareDecoder: WasmVideoDecoder | WebVideoDecoder
@@ -810,13 +1293,24 @@ export default class VideoDecodePipeline extends Pipeline {
           discard = AVDiscard.AVDISCARD_DEFAULT
         }
       }
-      task.softwareDecoder.setSkipFrameDiscard(discard)
+      // 高倍速下以画质换速度，保证实时
+      let fastLevel = DecoderFastLevel.NONE
+      const outputFramerate = rate * (framerate || 30)
+      if (rate > 1 && outputFramerate >= 240) {
+        fastLevel = DecoderFastLevel.FASTER
+      }
+      else if (rate > 1 && outputFramerate >= 120) {
+        fastLevel = DecoderFastLevel.FAST
+      }
+      task.softwareDecoder.setFastDecode(fastLevel)
+
       if (task.playRate < rate) {
         task.discard = discard
       }
       else {
         task.discard = Math.max(task.discard, discard)
       }
+      this.applySkipFrameDiscard(task)
       task.playRate = rate
     }
   }
@@ -826,7 +1320,7 @@ export default class VideoDecodePipeline extends Pipeline {
     if (task && task.softwareDecoder) {
       if (task.discard < AVDiscard.AVDISCARD_NONKEY) {
         task.discard += 8
-        task.softwareDecoder.setSkipFrameDiscard(task.discard)
+        this.applySkipFrameDiscard(task)
 
         logger.info(`set next discard, taskId: ${task.taskId}, discard: ${task.discard}`)
       }
@@ -838,14 +1332,20 @@ export default class VideoDecodePipeline extends Pipeline {
     if (task && task.softwareDecoder) {
       if (task.discard > AVDiscard.AVDISCARD_DEFAULT) {
         task.discard -= 8
-        task.softwareDecoder.setSkipFrameDiscard(task.discard)
+        this.applySkipFrameDiscard(task)
 
         logger.info(`set prev discard, taskId: ${task.taskId}, discard: ${task.discard}`)
       }
     }
   }
 
-  public async resetTask(taskId: string) {
+  /**
+   * 重置解码器
+   * 
+   * @param taskId 
+   * @param seekTimestamp 精确 seek 的目标时间（毫秒），传入之后目标时间之前的非参考帧不解码，其余帧解码之后直接丢弃
+   */
+  public async resetTask(taskId: string, seekTimestamp: int64 = NOPTS_VALUE_BIGINT) {
     const task = this.tasks.get(taskId)
     if (task) {
       if (task.targetDecoder === task.softwareDecoder) {
@@ -877,10 +1377,43 @@ export default class VideoDecodePipeline extends Pipeline {
       task.inputEnd = false
       task.lastDecodeTimestamp = getTimestamp()
 
+      this.releaseGopPackets(task)
+      task.failoverRequested = false
+      task.dropTimestamp = NOPTS_VALUE
+      task.lastOutputTimestamp = NOPTS_VALUE
+
+      if (task.seekDiscard || task.deadlineDiscarding) {
+        task.seekDiscard = false
+        task.deadlineDiscarding = false
+        this.applySkipFrameDiscard(task)
+      }
+      task.resetCurrentTime = task.stats.videoCurrentTime
+      task.seekTimestamp = seekTimestamp !== NOPTS_VALUE_BIGINT
+        ? static_cast<double>(avRescaleQ(seekTimestamp, AV_MILLI_TIME_BASE_Q, AV_TIME_BASE_Q))
+        : NOPTS_VALUE
+
       logger.info(`reset video decoder, taskId: ${task.taskId}`)
     }
   }
 
+  /**
+   * 设置任务是否可见，不可见时只解码关键帧，恢复可见之后从下一个关键帧开始正常解码
+   * 
+   * @param taskId 
+   * @param visible 
+   */
+  public async setTaskVisible(taskId: string, visible: boolean) {
+    const task = this.tasks.get(taskId)
+    if (task && task.keyframeOnly === visible) {
+      task.keyframeOnly = !visible
+      if (visible) {
+        task.needKeyFrame = true
+        task.leftIPCPort.request('requestKeyframe')
+      }
+      logger.info(`set video decoder visible: ${visible}, taskId: ${task.taskId}`)
+    }
+  }
+
   public async registerTask(options: VideoDecodeTaskOptions): Promise<number> {
     if (this.tasks.has(options.taskId)) {
       return errorType.INVALID_OPERATE
@@ -899,6 +1432,9 @@ export default class VideoDecodePipeline extends Pipeline {
       if (task.hardwareDecoder) {
         task.hardwareDecoder.close()
       }
+      if (task.sharedModuleKey) {
+        this.releaseSharedModule(task.sharedModuleKey)
+      }
       task.frameCaches.forEach((frame) => {
         if (isPointer(frame)) {
           task.avframePool.release(frame)
@@ -910,6 +1446,7 @@ export default class VideoDecodePipeline extends Pipeline {
           }
         }
       })
+      this.releaseGopPackets(task)
       if (task.parameters) {
         freeCodecParameters(task.parameters)
       }
@@ -926,7 +1463,8 @@ export default class VideoDecodePipeline extends Pipeline {
         width: task.parameters.width,
         height: task.parameters.height,
         framerate: avQ2D(task.parameters.framerate),
-        hardware: task.targetDecoder === task.hardwareDecoder
+        hardware: task.targetDecoder === task.hardwareDecoder,
+        delay: task.targetDecoder instanceof WasmVideoDecoder ? task.targetDecoder.getDelay() : 0
       })
     })
     return info
@@ -0,0 +1,158 @@
+/*
+ * libmedia video decoder pool
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ *
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ *
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import {
+  type Thread,
+  createThreadFromClass,
+  closeThread
+} from '@libmedia/cheap'
+
+import { logger } from '@libmedia/common'
+
+import VideoDecodePipeline from './VideoDecodePipeline'
+
+export interface VideoDecoderPoolOptions {
+  /**
+   * 最多创建的解码线程数，默认 hardwareConcurrency 的一半，最多 4 个
+   */
+  maxWorkers?: number
+}
+
+interface PoolWorker {
+  thread: Thread<VideoDecodePipeline>
+  tasks: Set<string>
+}
+
+/**
+ * 页面级别的视频解码线程池
+ * 
+ * 多个播放器的解码任务复用有限个解码线程，同一线程中相同 codec 的任务共用一个 wasm 实例，
+ * 线程内按下一帧的播放时间调度解码，不可见的任务降级为只解码关键帧
+ */
+export default class VideoDecoderPool {
+
+  private options: VideoDecoderPoolOptions
+
+  private workers: PoolWorker[]
+
+  private taskMap: Map<string, PoolWorker>
+
+  private pending: Promise<Thread<VideoDecodePipeline>>
+
+  constructor(options: VideoDecoderPoolOptions = {}) {
+    this.options = options
+    this.workers = []
+    this.taskMap = new Map()
+    this.pending = Promise.resolve(null)
+  }
+
+  private getMaxWorkers() {
+    if (this.options.maxWorkers > 0) {
+      return this.options.maxWorkers
+    }
+    return Math.max(1, Math.min(4, Math.floor((navigator.hardwareConcurrency || 2) / 2)))
+  }
+
+  /**
+   * 为任务分配一个解码线程，优先复用任务最少的线程，未达到上限且没有空闲线程时创建新的线程
+   * 
+   * @param taskId 
+   */
+  public acquire(taskId: string) {
+    // 串行分配，避免并发调用时创建超过上限的线程
+    const next = this.pending.then(async () => {
+      let worker = this.taskMap.get(taskId)
+      if (worker) {
+        return worker.thread
+      }
+      this.workers.forEach((item) => {
+        if (!worker || item.tasks.size < worker.tasks.size) {
+          worker = item
+        }
+      })
+      if (!worker || worker.tasks.size && this.workers.length < this.getMaxWorkers()) {
+        worker = {
+          thread: await createThreadFromClass(VideoDecodePipeline, {
+            name: `VideoDecoderThread${this.workers.length}`
+          }).run(),
+          tasks: new Set()
+        }
+        this.workers.push(worker)
+        logger.info(`create video decoder thread in pool, count: ${this.workers.length}`)
+      }
+      worker.tasks.add(taskId)
+      this.taskMap.set(taskId, worker)
+      return worker.thread
+    })
+    this.pending = next.catch(() => null)
+    return next
+  }
+
+  /**
+   * 释放任务占用的解码线程，线程上没有任务时关闭线程
+   * 
+   * 调用之前需要先 unregisterTask
+   * 
+   * @param taskId 
+   */
+  public async release(taskId: string) {
+    await this.pending
+    const worker = this.taskMap.get(taskId)
+    if (!worker) {
+      return
+    }
+    worker.tasks.delete(taskId)
+    this.taskMap.delete(taskId)
+    if (!worker.tasks.size) {
+      this.workers.splice(this.workers.indexOf(worker), 1)
+      await worker.thread.clear()
+      closeThread(worker.thread)
+      logger.info(`close video decoder thread in pool, count: ${this.workers.length}`)
+    }
+  }
+
+  /**
+   * 设置任务是否可见，不可见的任务只解码关键帧
+   * 
+   * @param taskId 
+   * @param visible 
+   */
+  public async setVisible(taskId: string, visible: boolean) {
+    const worker = this.taskMap.get(taskId)
+    if (worker) {
+      await worker.thread.setTaskVisible(taskId, visible)
+    }
+  }
+
+  public async destroy() {
+    await this.pending
+    for (let i = 0; i < this.workers.length; i++) {
+      await this.workers[i].thread.clear()
+      closeThread(this.workers[i].thread)
+    }
+    this.workers.length = 0
+    this.taskMap.clear()
+  }
+}
@@ -42,7 +42,8 @@ import {
   type AVRational,
   type AVFrame,
   type AVCodecParameters,
-  type AVCodecID
+  type AVCodecID,
+  hasWasmExport
 } from '@libmedia/avutil'
 
 import {
@@ -51,6 +52,7 @@ import {
 
 import {
   isPointer,
+  WebAssemblyRunner,
   type WebAssemblyResource,
   type Mutex,
   type List
@@ -75,7 +77,9 @@ import {
 
 import {
   WasmVideoEncoder,
-  WebVideoEncoder
+  WebVideoEncoder,
+  EncoderPreset,
+  type VideoEncoderReconfiguration
 } from '@libmedia/avcodec'
 
 import type { TaskOptions } from './Pipeline'
@@ -94,6 +98,20 @@ export interface VideoEncodeTaskOptions extends TaskOptions {
   gop: int32
   preferWebCodecs?: boolean
   copyTs?: boolean
+  /**
+   * 编码预设，webcodecs 编码器映射到 latencyMode
+   */
+  preset?: EncoderPreset
+  /**
+   * 把 wasm 编解码的调用统计写入 stats，需要 wasm 编译时开启 enable_codec_stats
+   */
+  codecStats?: boolean
+  /**
+   * 共享 wasm 模块的 key，同一个线程中 key 相同的任务共用一个 wasm 实例，每个任务只创建独立的编码上下文
+   * 
+   * 用于同一路输入编码多个码率档位，共享模式下软编使用单线程编码
+   */
+  sharedModuleKey?: string
 }
 
 type SelfTask = Omit<VideoEncodeTaskOptions, 'resource'> & {
@@ -122,6 +140,8 @@ type SelfTask = Omit<VideoEncodeTaskOptions, 'resource'> & {
 
   firstEncoded: boolean
   wasmEncoderOptions?: Data
+
+  pendingReconfiguration?: VideoEncoderReconfiguration
 }
 
 export interface VideoEncodeTaskInfo {
@@ -132,12 +152,45 @@ export interface VideoEncodeTaskInfo {
   hardware: boolean
 }
 
+interface SharedModule {
+  runner: WebAssemblyRunner
+  ready: Promise<void>
+  refCount: number
+}
+
 export default class VideoEncodePipeline extends Pipeline {
 
   declare tasks: Map<string, SelfTask>
 
+  private sharedModules: Map<string, SharedModule>
+
   constructor() {
     super()
+    this.sharedModules = new Map()
+  }
+
+  private retainSharedModule(key: string, resource: WebAssemblyResource) {
+    let module = this.sharedModules.get(key)
+    if (!module) {
+      const runner = new WebAssemblyRunner(resource)
+      module = {
+        runner,
+        ready: runner.run(undefined, 1),
+        refCount: 0
+      }
+      this.sharedModules.set(key, module)
+      logger.debug(`create shared video encoder module, key: ${key}`)
+    }
+    module.refCount++
+  }
+
+  private releaseSharedModule(key: string) {
+    const module = this.sharedModules.get(key)
+    if (module && --module.refCount <= 0) {
+      module.runner.destroy()
+      this.sharedModules.delete(key)
+      logger.debug(`destroy shared video encoder module, key: ${key}`)
+    }
   }
 
   private createWebcodecEncoder(task: SelfTask, enableHardwareAcceleration: boolean = true) {
@@ -161,19 +214,25 @@ export default class VideoEncodePipeline extends Pipeline {
       enableHardwareAcceleration,
       avpacketPool: task.avpacketPool,
       avframePool: task.avframePool,
-      copyTs: task.copyTs ?? false
+      copyTs: task.copyTs ?? false,
+      latencyMode: task.preset
+        ? (task.preset === EncoderPreset.REALTIME ? 'realtime' : 'quality')
+        : undefined
     })
   }
 
   private createWasmcodecEncoder(task: SelfTask, resource: WebAssemblyResource) {
     return new WasmVideoEncoder({
-      resource: task.resource,
+      resource,
+      runner: task.sharedModuleKey ? this.sharedModules.get(task.sharedModuleKey)?.runner : null,
       onReceiveAVPacket(avpacket) {
         task.avpacketCaches.push(reinterpret_cast<pointer<AVPacketRef>>(avpacket))
         task.stats.videoPacketEncodeCount++
       },
       avpacketPool: task.avpacketPool,
-      copyTs: task.copyTs ?? false
+      copyTs: task.copyTs ?? false,
+      preset: task.preset,
+      stats: task.codecStats ? addressof(task.stats.videoEncoderStats) : nullptr
     })
   }
 
@@ -217,6 +276,16 @@ export default class VideoEncodePipeline extends Pipeline {
       avpacketPool
     }
 
+    if (task.sharedModuleKey) {
+      // 旧版本编译的 wasm 没有多实例接口，只能独占一个模块
+      if (task.resource && hasWasmExport(task.resource, 'encoder_create')) {
+        this.retainSharedModule(task.sharedModuleKey, task.resource)
+      }
+      else {
+        task.sharedModuleKey = null
+      }
+    }
+
     task.softwareEncoder = task.resource
       ? this.createWasmcodecEncoder(task, task.resource)
       : (support.videoEncoder ? this.createWebcodecEncoder(task, false) : null)
@@ -311,6 +380,10 @@ export default class VideoEncodePipeline extends Pipeline {
                 avframe = frame
               }
 
+              if ((isPointer(avframe) || avframe instanceof VideoFrame) && task.pendingReconfiguration) {
+                await this.applyReconfiguration(task, avframe)
+              }
+
               if (isPointer(avframe) || avframe instanceof VideoFrame) {
                 let ret = (!task.firstEncoded && task.targetEncoder instanceof WasmVideoEncoder)
                   ? await task.targetEncoder.encodeAsync(avframe as pointer<AVFrame>, task.gopCounter === 0)
@@ -472,11 +545,40 @@ export default class VideoEncodePipeline extends Pipeline {
     return 0
   }
 
+  private async applyReconfiguration(task: SelfTask, avframe: pointer<AVFrameRef> | VideoFrame) {
+    const config = task.pendingReconfiguration
+
+    if (config.width || config.height) {
+      const width = avframe instanceof VideoFrame ? avframe.displayWidth : avframe.width
+      const height = avframe instanceof VideoFrame ? avframe.displayHeight : avframe.height
+      // 等到上游送入新分辨率的帧再修改
+      if ((config.width && config.width !== width) || (config.height && config.height !== height)) {
+        return
+      }
+    }
+
+    task.pendingReconfiguration = null
+
+    const ret = await task.targetEncoder.reconfigure(config)
+    if (ret < 0) {
+      logger.warn(`video encoder reconfigure failed, taskId: ${task.taskId}, ret: ${ret}`)
+      return
+    }
+    if (ret === 0) {
+      // 编码器重新打开或者分辨率变化，从这一帧开始新的 gop
+      task.gopCounter = 0
+    }
+    logger.info(`video encoder reconfigured, taskId: ${task.taskId}, bitrate: ${config.bitrate ?? '-'}, width: ${config.width ?? '-'}, height: ${config.height ?? '-'}`)
+  }
+
   private async openSoftwareEncoder(task: SelfTask) {
     if (task.softwareEncoder && !task.softwareEncoderOpened) {
       const parameters = task.parameters
       let threadCount = 1
-      if (isWorker()) {
+      if ((task.softwareEncoder instanceof WasmVideoEncoder) && task.sharedModuleKey) {
+        await this.sharedModules.get(task.sharedModuleKey).ready
+      }
+      else if (isWorker()) {
         threadCount = Math.max(threadCount, navigator.hardwareConcurrency)
       }
       let ret = await task.softwareEncoder.open(parameters, task.timeBase, threadCount, task.wasmEncoderOptions)
@@ -578,6 +680,23 @@ export default class VideoEncodePipeline extends Pipeline {
     }
   }
 
+  /**
+   * 运行时修改编码参数（码率、最大码率、VBV 和分辨率），在下一帧编码之前生效
+   * 
+   * 修改分辨率时需要上游同时改为送入新分辨率的帧，第一帧新分辨率的帧到达时才生效
+   * 
+   * @param taskId 
+   * @param config 
+   */
+  public async reconfigure(taskId: string, config: VideoEncoderReconfiguration) {
+    const task = this.tasks.get(taskId)
+    if (task) {
+      task.pendingReconfiguration = object.extend(task.pendingReconfiguration ?? {}, config)
+      return
+    }
+    logger.fatal('task not found')
+  }
+
   public async getExtraData(taskId: string) {
     const task = this.tasks.get(taskId)
     if (task) {
@@ -612,6 +731,9 @@ export default class VideoEncodePipeline extends Pipeline {
       if (task.hardwareEncoder) {
         task.hardwareEncoder.close()
       }
+      if (task.sharedModuleKey) {
+        this.releaseSharedModule(task.sharedModuleKey)
+      }
       array.each(task.avpacketCaches, (avpacket) => {
         task.avpacketPool.release(avpacket)
       })
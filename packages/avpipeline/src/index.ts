@@ -39,6 +39,11 @@ export {
   default as VideoDecodePipeline
 } from './VideoDecodePipeline'
 
+export {
+  type VideoDecoderPoolOptions,
+  default as VideoDecoderPool
+} from './VideoDecoderPool'
+
 export {
   type VideoEncodeTaskInfo,
   type VideoEncodeTaskOptions,
@@ -23,6 +23,8 @@
  *
  */
 
+import { CodecStats } from '@libmedia/avcodec'
+
 @struct
 export class JitterBuffer {
   min: int32
@@ -275,4 +277,41 @@ export default class Stats {
    * 下一个视频帧播放时间戳
    */
   videoNextTime: int64
+
+  /**
+   * wasm 视频解码器调用统计（需要编译时开启 enable_codec_stats）
+   */
+  videoDecoderStats: CodecStats
+  /**
+   * wasm 视频编码器调用统计（需要编译时开启 enable_codec_stats）
+   */
+  videoEncoderStats: CodecStats
+  /**
+   * 视频平均每帧解码耗时（毫秒），根据 videoDecoderStats 计算
+   */
+  videoDecodeTimePerFrame: double
+  /**
+   * 视频编码速度（每秒实际编码输出的帧数）
+   */
+  videoEncodeSpeed: int32
+  /**
+   * 视频解码器监督模式下从硬解切换到软解的次数
+   */
+  videoDecoderFailoverCount: int32
+  /**
+   * 精确 seek 时解码器丢弃的目标时间之前的视频帧总数
+   */
+  videoSeekDiscardFrameCount: int32
+  /**
+   * 预测来不及解码时主动跳过的视频帧总数（近似值）
+   */
+  videoDeadlineDropFrameCount: int32
+  /**
+   * 解码输出时已经晚于播放时间的视频帧总数
+   */
+  videoLateFrameCount: int32
+  /**
+   * 最近一次 seek 从开始到目标位置第一帧可以渲染的耗时（毫秒）
+   */
+  seekToFirstFrameTime: double
 }
@@ -30,6 +30,7 @@ import {
   VideoDecodePipeline,
   AudioRenderPipeline,
   VideoRenderPipeline,
+  type VideoDecoderPool,
   Stats
 } from '@libmedia/avpipeline'
 
@@ -48,6 +49,7 @@ import {
   url as urlUtils,
   support,
   restrain,
+  getTimestamp,
   type Data,
   type Fn,
   type PromisePending
@@ -286,6 +288,28 @@ export interface AVPlayerOptions {
    * 是否启用 WebCodecs 编解码
    */
   enableWebCodecs?: boolean
+  /**
+   * 是否启用视频解码器监督模式，硬解出错或者卡住时无缝切换到软解，一段时间之后在关键帧处尝试切回硬解
+   */
+  enableDecoderFailover?: boolean
+  /**
+   * 是否启用快速精确 seek，解码器跳过目标时间之前的非参考帧，目标之前解码出的帧直接丢弃不传给渲染，长 gop 内容拖动更快
+   */
+  enableFastAccurateSeek?: boolean
+  /**
+   * 是否启用视频解码截止时间判断，预测来不及解码时跳过非参考帧，CPU 不足时平滑降级而不是累积延迟
+   */
+  enableDeadlineDiscard?: boolean
+  /**
+   * 是否统计 wasm 视频解码的调用耗时，需要 wasm 编译时开启 enable_codec_stats
+   */
+  enableCodecStats?: boolean
+  /**
+   * 页面级别的视频解码线程池，多个播放器传入同一个线程池时解码任务复用有限个线程和 wasm 实例，按下一帧的播放时间调度解码
+   * 
+   * 只在不使用 VideoPipelineProxy 的情况下生效（多线程环境或者不使用 worker）
+   */
+  videoDecoderPool?: VideoDecoderPool
   /**
    * 是否启用 worker，非多线程环境下使用
    * 
@@ -492,6 +516,10 @@ const defaultAVPlayerOptions: Partial<AVPlayerOptions> = {
   enableWebGPU: true,
   enableWorker: true,
   enableWebCodecs: true,
+  enableDecoderFailover: false,
+  enableFastAccurateSeek: false,
+  enableDeadlineDiscard: false,
+  enableCodecStats: false,
   enableAudioWorklet: true,
   loop: false,
   enableJitterBuffer: true,
@@ -607,10 +635,10 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
    */
   static Resource: Map<string, WebAssemblyResource | ArrayBuffer> = new Map()
 
-  // 解码线程每个 player 独占一个
-  // TODO 若需要同时播放大量视频，可以考虑实现一个 VideoDecoderThreadPool
-  // 来根据各个视频规格做线程解码任务调度，降低系统线程切换开销，这里就不实现了
+  // 解码线程默认每个 player 独占一个
+  // 传入 videoDecoderPool 时从线程池中分配，同时播放大量视频时降低线程和内存开销
   private VideoDecoderThread: Thread<VideoDecodePipeline>
+  private VideoDecoderPool: VideoDecoderPool
   private VideoRenderThread: Thread<VideoRenderPipeline>
   private VideoPipelineProxy: VideoPipelineProxy
 
@@ -2290,7 +2318,12 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
             && !!this.options.enableWebCodecs
             && !(videoStream.disposition & AVDisposition.ATTACHED_PIC),
           preferLatency: this.isLive(),
-          keepAlpha: true
+          keepAlpha: true,
+          supervise: this.options.enableDecoderFailover,
+          sharedModuleKey: this.VideoDecoderPool ? `decoder-${videoStream.codecpar.codecId}` : null,
+          schedule: !!this.VideoDecoderPool,
+          deadlineDiscard: this.options.enableDeadlineDiscard,
+          codecStats: this.options.enableCodecStats
         })
 
       let ret = await this.VideoDecoderThread.open(this.taskId, serializeAVCodecParameters(videoStream.codecpar))
@@ -2324,6 +2357,16 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
       this.demuxer2AudioDecoderChannel = createMessageChannel(this.options.enableWorker)
       this.audioDecoder2AudioRenderChannel = createMessageChannel(this.options.enableWorker)
 
+      if (this.isMediaStreamMode()) {
+        this.playChannels = 2
+      }
+      else {
+        this.playChannels = Math.min(
+          audioStream.codecpar.chLayout.nbChannels,
+          AVPlayer.audioContext.destination.maxChannelCount || 2
+        )
+      }
+
       let resource = await this.getResource('decoder', audioStream.codecpar.codecId, audioStream.codecpar.codecType)
 
       if (!resource) {
@@ -2358,7 +2401,10 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
           avpacketList: addressof(this.GlobalData.avpacketList),
           avpacketListMutex: addressof(this.GlobalData.avpacketListMutex),
           avframeList: addressof(this.GlobalData.avframeList),
-          avframeListMutex: addressof(this.GlobalData.avframeListMutex)
+          avframeListMutex: addressof(this.GlobalData.avframeListMutex),
+          // wasm 解码器直接输出渲染格式，渲染端不再需要重采样
+          outputSampleRate: AVPlayer.audioContext.sampleRate,
+          outputChannels: this.playChannels
         })
 
       let ret = await AVPlayer.AudioDecoderThread.open(this.taskId, serializeAVCodecParameters(audioStream.codecpar))
@@ -2477,16 +2523,6 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
 
       this.audioRender2AudioWorkletChannel = new MessageChannel()
 
-      if (this.isMediaStreamMode()) {
-        this.playChannels = 2
-      }
-      else {
-        this.playChannels = Math.min(
-          audioStream.codecpar.chLayout.nbChannels,
-          AVPlayer.audioContext.destination.maxChannelCount || 2
-        )
-      }
-
       let resamplerResource = await this.getResource('resampler')
       let stretchpitcherResource = await this.getResource('stretchpitcher')
 
@@ -2892,6 +2928,8 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
     onBeforeSeek?: Function
   } = {}) {
 
+    const seekStartTime = getTimestamp()
+
     if (defined(ENABLE_MSE) && this.useMSE) {
       await AVPlayer.MSEThread.beforeSeek(this.taskId)
     }
@@ -2960,7 +2998,12 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
       if (seekedTimestamp >= 0n) {
         await Promise.all([
           AVPlayer.AudioDecoderThread?.resetTask(this.taskId),
-          this.VideoDecoderThread?.resetTask(this.taskId)
+          this.VideoDecoderThread?.resetTask(
+            this.taskId,
+            this.options.enableFastAccurateSeek
+              ? (seekedTimestamp > timestamp ? seekedTimestamp : timestamp)
+              : NOPTS_VALUE_BIGINT
+          )
         ])
         await Promise.all([
           AVPlayer.AudioRenderThread?.syncSeekTime(
@@ -2974,6 +3017,8 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
             maxQueueLength
           )
         ])
+        this.GlobalData.stats.seekToFirstFrameTime = getTimestamp() - seekStartTime
+        logger.info(`seek to first frame cost: ${this.GlobalData.stats.seekToFirstFrameTime}ms, taskId: ${this.taskId}`)
         await Promise.all([
           AVPlayer.AudioRenderThread?.afterSeek(this.taskId, seekedTimestamp > timestamp ? seekedTimestamp : timestamp),
           this.VideoRenderThread?.afterSeek(this.taskId, seekedTimestamp > timestamp ? seekedTimestamp : timestamp)
@@ -3501,6 +3546,18 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
     logger.info(`player call setRotate, angle: ${angle}, taskId: ${this.taskId}`)
   }
 
+  /**
+   * 设置播放器是否可见，使用 videoDecoderPool 时不可见的播放器只解码关键帧
+   * 
+   * @param visible 
+   */
+  public async setVisible(visible: boolean) {
+    if (this.VideoDecoderPool) {
+      await this.VideoDecoderPool.setVisible(this.taskId, visible)
+    }
+    logger.info(`player call setVisible, visible: ${visible}, taskId: ${this.taskId}`)
+  }
+
   public enableHorizontalFlip(enable: boolean) {
     this.flipHorizontal = enable
     if (defined(ENABLE_MSE) && this.useMSE && this.video) {
@@ -4229,6 +4286,12 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
       this.VideoPipelineProxy = null
     }
 
+    if (this.VideoDecoderPool) {
+      await this.VideoDecoderPool.release(this.taskId)
+      this.VideoDecoderThread = null
+      this.VideoDecoderPool = null
+    }
+
     if (this.VideoDecoderThread) {
       await this.VideoDecoderThread.clear()
       closeThread(this.VideoDecoderThread)
@@ -4424,13 +4487,22 @@ export default class AVPlayer extends Emitter implements ControllerObserver {
       || !supportOffscreenCanvas()
       || !defined(ENABLE_WORKER_PROXY)
     ) {
-      this.VideoDecoderThread = await createThreadFromClass(VideoDecodePipeline, {
-        name: 'VideoDecoderThread'
-      }).run()
+      if (this.options.videoDecoderPool) {
+        this.VideoDecoderPool = this.options.videoDecoderPool
+        this.VideoDecoderThread = await this.VideoDecoderPool.acquire(this.taskId)
+      }
+      else {
+        this.VideoDecoderThread = await createThreadFromClass(VideoDecodePipeline, {
+          name: 'VideoDecoderThread'
+        }).run()
+      }
       this.VideoDecoderThread.setLogLevel(AVPlayer.level)
       this.VideoRenderThread = AVPlayer.VideoRenderThread
     }
     else {
+      if (this.options.videoDecoderPool) {
+        logger.warn(`videoDecoderPool is not supported with worker proxy, ignore it, taskId: ${this.taskId}`)
+      }
       this.VideoPipelineProxy = new VideoPipelineProxy()
       await this.VideoPipelineProxy.run()
       this.VideoPipelineProxy.setLogLevel(AVPlayer.level)
@@ -56,6 +56,10 @@ export default class StatsController {
 
   private bufferReceiveBytes: int64
 
+  private videoPacketEncodeCount: int64
+  private videoDecodeTime: double
+  private videoDecodeFramesOut: int64
+
   private observer: StatsControllerObserver
   private isWorkerMain: boolean
   private videoDecodeMaxIntervalCounter: number
@@ -77,6 +81,9 @@ export default class StatsController {
     this.videoPacketBytes = this.stats.videoPacketBytes
     this.audioPacketBytes = this.stats.audioPacketBytes
     this.bufferReceiveBytes = this.stats.bufferReceiveBytes
+    this.videoPacketEncodeCount = this.stats.videoPacketEncodeCount
+    this.videoDecodeTime = this.stats.videoDecoderStats.sendTime + this.stats.videoDecoderStats.receiveTime
+    this.videoDecodeFramesOut = this.stats.videoDecoderStats.framesOut
     if (!this.isWorkerMain) {
       this.stats.audioFrameDecodeIntervalMax = 0
       this.stats.audioFrameRenderIntervalMax = 0
@@ -107,6 +114,15 @@ export default class StatsController {
     this.stats.audioBitrate = static_cast<int32>(this.stats.audioPacketBytes - this.audioPacketBytes)
     this.stats.bandwidth = static_cast<int32>(this.stats.bufferReceiveBytes - this.bufferReceiveBytes)
 
+    this.stats.videoEncodeSpeed = static_cast<int32>(this.stats.videoPacketEncodeCount - this.videoPacketEncodeCount)
+    const videoDecodeFrames = static_cast<double>(this.stats.videoDecoderStats.framesOut - this.videoDecodeFramesOut)
+    if (videoDecodeFrames > 0) {
+      this.stats.videoDecodeTimePerFrame = (this.stats.videoDecoderStats.sendTime
+        + this.stats.videoDecoderStats.receiveTime
+        - this.videoDecodeTime
+      ) / videoDecodeFrames
+    }
+
     if (document.visibilityState === 'visible'
       && (this.stats.videoRenderFramerate < this.stats.videoEncodeFramerate * 0.5
         || this.stats.videoFrameRenderIntervalMax > 6 * 1000 / this.stats.videoEncodeFramerate
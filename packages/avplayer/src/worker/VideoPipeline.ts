@@ -107,6 +107,10 @@ export default class VideoPipeline {
             videoFrameDecodeCount: stats.videoFrameDecodeCount,
             videoFrameDecodeIntervalMax: stats.videoFrameDecodeIntervalMax,
             videoDecodeErrorPacketCount: stats.videoDecodeErrorPacketCount,
+            videoDecoderFailoverCount: stats.videoDecoderFailoverCount,
+            videoSeekDiscardFrameCount: stats.videoSeekDiscardFrameCount,
+            videoDeadlineDropFrameCount: stats.videoDeadlineDropFrameCount,
+            videoLateFrameCount: stats.videoLateFrameCount,
             videoCurrentTime: stats.videoCurrentTime,
             videoFrameRenderCount: stats.videoFrameRenderCount,
             videoFrameRenderIntervalMax: stats.videoFrameRenderIntervalMax,
@@ -39,6 +39,7 @@ import {
   logger,
   bigint,
   object,
+  array,
   browser,
   os,
   Emitter,
@@ -157,6 +158,10 @@ import {
   createGraphDesVertex
 } from '@libmedia/avfilter'
 
+import {
+  EncoderPreset
+} from '@libmedia/avcodec'
+
 import { AudioCodecString2CodecId, Ext2Format,
   Format2AVFormat, PixfmtString2AVPixelFormat, SampleFmtString2SampleFormat,
   VideoCodecString2CodecId
@@ -170,6 +175,23 @@ import Controller from './Controller'
 
 export const Events = eventType
 
+export {
+  default as ThumbnailExtractor,
+  type ThumbnailExtractorOptions,
+  type ThumbnailOptions
+} from './ThumbnailExtractor'
+
+export {
+  default as SegmentTranscoder,
+  type SegmentTranscoderOptions,
+  type SegmentTaskOptions
+} from './SegmentTranscoder'
+
+export {
+  default as SmartCutter,
+  type SmartCutOptions
+} from './SmartCutter'
+
 export interface AVTranscoderOptions {
   /**
    * 自定义 wasm 请求 base url
@@ -179,6 +201,37 @@ export interface AVTranscoderOptions {
   wasmBaseUrl?: string
   getWasm?: (type: 'decoder' | 'resampler' | 'scaler' | 'encoder', codec?: AVCodecID, mediaType?: AVMediaType) => string | ArrayBuffer | WebAssemblyResource
   onprogress?: (taskId: string, progress: number) => void
+  /**
+   * 是否统计 wasm 视频编解码的调用耗时，需要 wasm 编译时开启 enable_codec_stats
+   */
+  enableCodecStats?: boolean
+}
+
+export interface VideoLadderRendition {
+  /**
+   * 输出宽度
+   */
+  width: number
+  /**
+   * 输出高度
+   */
+  height: number
+  /**
+   * 输出码率
+   */
+  bitrate?: number
+  /**
+   * 配置编码器 profile
+   */
+  profile?: number
+  /**
+   * 配置编码器 level
+   */
+  level?: number
+  /**
+   * 这一路编码器的参数设置，覆盖 video.encoderOptions
+   */
+  encoderOptions?: Data
 }
 
 export interface TaskOptions {
@@ -322,12 +375,28 @@ export interface TaskOptions {
        * 只有 wasm 的 h264/h265 编码器支持
        */
       delay?: number
+      /**
+       * 编码预设，wasm 编码器映射到各个编码库的码控、lookahead、线程和 tune 参数，webcodecs 编码器映射到 latencyMode
+       * 
+       * - realtime 零延时，没有 B 帧和 lookahead
+       * - balanced 速度和质量均衡
+       * - archival 质量优先
+       */
+      preset?: keyof (typeof EncoderPresetString2Enum)
       /**
        * 编码器的参数设置 wasm 编码器生效
        * 
        * 详情参考 ffmpeg 的编码器 options 配置
        */
       encoderOptions?: Data
+      /**
+       * 码率阶梯，除了主输出之外额外输出的视频流
+       * 
+       * 源只解码一次，每一路单独缩放和编码，编码类型、帧率、像素格式和关键帧间隔与主输出相同，各路 gop 对齐
+       * 
+       * 各路共用一个 wasm 编码器实例，只支持 h264、hevc、mpeg4、vp8、vp9 和 av1 的 wasm 编码
+       */
+      ladder?: VideoLadderRendition[]
     }
     audio?: {
       /**
@@ -399,6 +468,12 @@ class AVTranscoderGlobalData {
   avframeListMutex: Mutex
 }
 
+const EncoderPresetString2Enum = {
+  'realtime': EncoderPreset.REALTIME,
+  'balanced': EncoderPreset.BALANCED,
+  'archival': EncoderPreset.ARCHIVAL
+}
+
 const defaultAVTranscoderOptions: Partial<AVTranscoderOptions> = {
 }
 
@@ -558,7 +633,20 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
           progress = 100
         }
 
-        logger.info(`[${task.taskId}] frame=${frameCount} fps=${fps.toFixed(2)} size=${size}kB time=${dumpUtils.dumpTime(dts)} bitrate=${bitrate.toFixed(2)}kbps speed=${speed.toFixed(2)}x progress=${progress.toFixed(2)}%`)
+        let codecTime = ''
+        // wasm 编译时开启了 enable_codec_stats 才有数据
+        if (task.stats.videoDecoderStats.framesOut) {
+          const decodeTime = (task.stats.videoDecoderStats.sendTime + task.stats.videoDecoderStats.receiveTime)
+            / static_cast<double>(task.stats.videoDecoderStats.framesOut)
+          codecTime += ` decode=${decodeTime.toFixed(2)}ms/f`
+        }
+        if (task.stats.videoEncoderStats.framesIn) {
+          const encodeTime = (task.stats.videoEncoderStats.sendTime + task.stats.videoEncoderStats.receiveTime)
+            / static_cast<double>(task.stats.videoEncoderStats.framesIn)
+          codecTime += ` encode=${encodeTime.toFixed(2)}ms/f`
+        }
+
+        logger.info(`[${task.taskId}] frame=${frameCount} fps=${fps.toFixed(2)} size=${size}kB time=${dumpUtils.dumpTime(dts)} bitrate=${bitrate.toFixed(2)}kbps speed=${speed.toFixed(2)}x progress=${progress.toFixed(2)}%${codecTime}`)
 
         if (this.options.onprogress) {
           this.options.onprogress(task.taskId, progress)
@@ -1595,6 +1683,309 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
     }
   }
 
+  /**
+   * @hidden
+   */
+  private createVideoOutputStream(task: SelfTask, stream: AVStreamInterface, rendition?: VideoLadderRendition) {
+    const videoConfig = task.options.output.video
+    const newStream = this.copyAVStreamInterface(task, stream)
+    newStream.codecpar.flags &= ~AVCodecParameterFlags.AV_CODECPAR_FLAG_NO_PTS
+    newStream.codecpar.flags &= ~AVCodecParameterFlags.AV_CODECPAR_FLAG_NO_DTS
+
+    if (videoConfig) {
+      if (videoConfig.codec && videoConfig.codec !== 'copy') {
+        const codecId = VideoCodecString2CodecId[videoConfig.codec]
+        if (!is.number(codecId)) {
+          this.freeAVStreamInterface(newStream)
+          logger.fatal(`invalid codec name(${videoConfig.codec})`)
+        }
+        newStream.codecpar.codecId = codecId
+
+        if (newStream.codecpar.codecId !== stream.codecpar.codecId) {
+          newStream.codecpar.profile = NOPTS_VALUE
+          newStream.codecpar.level = NOPTS_VALUE
+        }
+      }
+      if (videoConfig.width) {
+        newStream.codecpar.width = videoConfig.width
+      }
+      if (videoConfig.height) {
+        newStream.codecpar.height = videoConfig.height
+      }
+      if (videoConfig.bitrate) {
+        newStream.codecpar.bitrate = static_cast<int64>(videoConfig.bitrate)
+      }
+      if (videoConfig.pixfmt) {
+        const pixfmt = PixfmtString2AVPixelFormat[videoConfig.pixfmt]
+        if (!is.number(pixfmt)) {
+          logger.fatal(`invalid pixfmt name(${videoConfig.pixfmt})`)
+        }
+        newStream.codecpar.format = pixfmt
+      }
+      if (videoConfig.framerate) {
+        newStream.codecpar.framerate.num = videoConfig.framerate >>> 0
+        newStream.codecpar.framerate.den = 1
+      }
+      if (videoConfig.aspect) {
+        newStream.codecpar.sampleAspectRatio.den = videoConfig.aspect.den
+        newStream.codecpar.sampleAspectRatio.num = videoConfig.aspect.num
+      }
+      if (videoConfig.profile) {
+        newStream.codecpar.profile = videoConfig.profile
+      }
+      if (videoConfig.level) {
+        newStream.codecpar.level = videoConfig.level
+      }
+      if (videoConfig.delay) {
+        newStream.codecpar.videoDelay = videoConfig.delay
+      }
+    }
+
+    if (rendition) {
+      newStream.codecpar.width = rendition.width
+      newStream.codecpar.height = rendition.height
+      if (rendition.bitrate) {
+        newStream.codecpar.bitrate = static_cast<int64>(rendition.bitrate)
+      }
+      if (rendition.profile) {
+        newStream.codecpar.profile = rendition.profile
+      }
+      if (rendition.level) {
+        newStream.codecpar.level = rendition.level
+      }
+    }
+
+    if (newStream.codecpar.profile === NOPTS_VALUE) {
+      if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_H264) {
+        const descriptor = getAVPixelFormatDescriptor(newStream.codecpar.format as AVPixelFormat)
+        newStream.codecpar.profile = descriptor?.comp[0]?.depth === 10 ? h264.H264Profile.kHigh10 : h264.H264Profile.kHigh
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
+        const descriptor = getAVPixelFormatDescriptor(newStream.codecpar.format as AVPixelFormat)
+        newStream.codecpar.profile = descriptor?.comp[0]?.depth === 10 ? hevc.HEVCProfile.Main10 : hevc.HEVCProfile.Main
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VVC) {
+
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_AV1) {
+        newStream.codecpar.profile = av1.AV1Profile.Main
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP9) {
+        newStream.codecpar.profile = vp9.VP9Profile.Profile0
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP8) {
+        newStream.codecpar.profile = 0
+      }
+    }
+    if (newStream.codecpar.level === NOPTS_VALUE) {
+      if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_H264) {
+        newStream.codecpar.level = h264.getLevelByResolution(newStream.codecpar.width, newStream.codecpar.height, avQ2D(newStream.codecpar.framerate))
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
+        newStream.codecpar.level = hevc.getLevelByResolution(
+          newStream.codecpar.profile,
+          newStream.codecpar.width,
+          newStream.codecpar.height,
+          avQ2D(newStream.codecpar.framerate),
+          static_cast<double>(newStream.codecpar.bitrate)
+        )
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VVC) {
+        // TODO 现在还没有 vvc 编码器，将来如果加入了 vvc 编码器再来实现
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_AV1) {
+        newStream.codecpar.level = av1.getLevelByResolution(newStream.codecpar.width, newStream.codecpar.height, avQ2D(newStream.codecpar.framerate))
+      }
+      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP9) {
+        newStream.codecpar.level = vp9.getLevelByResolution(newStream.codecpar.width, newStream.codecpar.height, avQ2D(newStream.codecpar.framerate))
+      }
+    }
+
+    if (videoConfig?.preset === 'realtime') {
+      // 实时预设不编码 B 帧
+      newStream.codecpar.videoDelay = 0
+    }
+    else if ((!videoConfig || videoConfig.delay == null)
+      && newStream.codecpar.videoDelay === 0
+    ) {
+      // 这个用来设置 max_b_frame_count，只针对 wasm 编码器，webcodecs 目前无法编码出 B 帧
+      newStream.codecpar.videoDelay = 4
+    }
+
+    if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_H264
+      || newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_MPEG4
+      || newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC
+      || newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VVC
+    ) {
+      if (task.oformat === AVFormat.MPEGTS
+        || task.oformat === AVFormat.H264
+        || task.oformat === AVFormat.HEVC
+        || task.oformat === AVFormat.VVC
+      ) {
+        newStream.codecpar.flags |= AVCodecParameterFlags.AV_CODECPAR_FLAG_H26X_ANNEXB
+      }
+      else {
+        newStream.codecpar.flags &= ~AVCodecParameterFlags.AV_CODECPAR_FLAG_H26X_ANNEXB
+      }
+    }
+
+    if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_MPEG4 && newStream.timeBase.den > 65535) {
+      this.changeAVStreamTimebase(newStream, { num: 1, den: 65535 })
+    }
+
+    return newStream
+  }
+
+  /**
+   * @hidden
+   */
+  private async openVideoEncoder(
+    task: SelfTask,
+    taskId: string,
+    newStream: AVStreamInterface,
+    leftPort: MessagePort,
+    encoder2MuxerChannel: MessageChannel,
+    encoderOptions: Data = {},
+    sharedModuleKey?: string
+  ): Promise<number> {
+    const videoConfig = task.options.output.video
+
+    let encoderResource = await this.getResource('encoder', newStream.codecpar.codecId, newStream.codecpar.codecType)
+    if (!encoderResource) {
+      if (support.videoEncoder) {
+        const isSupport = await VideoEncoder.isConfigSupported({
+          codec: getVideoCodec(newStream.codecpar),
+          width: newStream.codecpar.width,
+          height: newStream.codecpar.height
+        })
+        if (!isSupport.supported) {
+          logger.error(`VideoEncoder ${dumpUtils.dumpCodecName(newStream.codecpar.codecType, newStream.codecpar.codecId)} codecId ${newStream.codecpar.codecId} not support`)
+          this.freeAVStreamInterface(newStream)
+          return errorType.OPERATE_NOT_SUPPORT
+        }
+      }
+      else {
+        logger.error(`${dumpUtils.dumpCodecName(newStream.codecpar.codecType, newStream.codecpar.codecId)} encoder codecId ${newStream.codecpar.codecId} not support`)
+        this.freeAVStreamInterface(newStream)
+        return errorType.OPERATE_NOT_SUPPORT
+      }
+    }
+
+    const wasmEncoderOptions: Data = {}
+    const resourceExtraData: Data = {}
+
+    // x265 需要提前创建线程
+    if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
+      resourceExtraData.enableThreadPool = true
+      resourceExtraData.enableThreadCountRate = 2
+    }
+    // libvpx 需要提前创建线程
+    else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP9) {
+      resourceExtraData.enableThreadPool = true
+    }
+
+    if (task.options?.output?.video?.encoderOptions) {
+      object.each(task.options.output.video.encoderOptions, (value, key) => {
+        wasmEncoderOptions[key] = value
+      })
+    }
+    object.each(encoderOptions, (value, key) => {
+      wasmEncoderOptions[key] = value
+    })
+
+    // 注册一个视频编码任务
+    await this.VideoEncoderThread.registerTask
+      .transfer(leftPort, encoder2MuxerChannel.port1)
+      .invoke({
+        taskId: taskId,
+        resource: encoderResource,
+        resourceExtraData,
+        leftPort: leftPort,
+        rightPort: encoder2MuxerChannel.port1,
+        stats: addressof(task.stats),
+        enableHardware: !sharedModuleKey && !!videoConfig.enableHardware && !!videoConfig.enableWebCodecs,
+        avpacketList: addressof(this.GlobalData.avpacketList),
+        avpacketListMutex: addressof(this.GlobalData.avpacketListMutex),
+        avframeList: addressof(this.GlobalData.avframeList),
+        avframeListMutex: addressof(this.GlobalData.avframeListMutex),
+        gop: this.getVideoGop(task, newStream),
+        preferWebCodecs: !sharedModuleKey && !isHdr(newStream.codecpar) && !hasAlphaChannel(newStream.codecpar) && !!videoConfig.enableWebCodecs,
+        copyTs: task.options.copyTs ?? false,
+        preset: videoConfig.preset ? EncoderPresetString2Enum[videoConfig.preset] : EncoderPreset.NONE,
+        codecStats: !!this.options.enableCodecStats,
+        sharedModuleKey
+      })
+
+    const ret = await this.VideoEncoderThread.open(taskId, newStream.codecpar, { num: newStream.timeBase.num, den: newStream.timeBase.den }, wasmEncoderOptions)
+
+    if (ret < 0) {
+      logger.error(`cannot open video ${dumpUtils.dumpCodecName(newStream.codecpar.codecType, newStream.codecpar.codecId)} encoder`)
+      this.freeAVStreamInterface(newStream)
+      return ret
+    }
+
+    await this.MuxThread.addStream.transfer(encoder2MuxerChannel.port2)
+      .invoke(task.taskId, newStream, encoder2MuxerChannel.port2)
+
+    return 0
+  }
+
+  private getVideoGop(task: SelfTask, newStream: AVStreamInterface) {
+    return static_cast<int32>(avQ2D(newStream.codecpar.framerate) * (task.options.output.video.keyFrameInterval ?? 5000) / 1000)
+  }
+
+  /**
+   * 码率阶梯各路的 wasm 编码器参数
+   * 
+   * 各路只能在 gop 边界出关键帧才能对齐，需要按编码器关闭场景切换关键帧，返回 null 表示无法保证对齐
+   */
+  private async getLadderEncoderOptions(task: SelfTask, newStream: AVStreamInterface): Promise<Data> {
+    const videoConfig = task.options.output.video
+    const codecName = dumpUtils.dumpCodecName(newStream.codecpar.codecType, newStream.codecpar.codecId)
+
+    // WebCodecs 没有关闭场景切换关键帧的配置，码率阶梯只使用 wasm 编码
+    if (!await this.getResource('encoder', newStream.codecpar.codecId, newStream.codecpar.codecType)) {
+      logger.error(`video ladder need wasm ${codecName} encoder, WebCodecs encoder cannot align gop`)
+      return null
+    }
+
+    const gop = this.getVideoGop(task, newStream) + ''
+
+    // g 和 keyint_min 相同时 libvpx 和 libaom 按固定间隔出关键帧，libx264 和 libx265 也不会在 gop 中间插入 idr
+    const options: Data = {
+      g: gop,
+      keyint_min: gop
+    }
+
+    switch (newStream.codecpar.codecId) {
+      // libx264 和 ffmpeg mpeg4 使用 sc_threshold 控制场景切换
+      case AVCodecID.AV_CODEC_ID_H264:
+      case AVCodecID.AV_CODEC_ID_MPEG4:
+        options.sc_threshold = '0'
+        break
+      // libx265 不读取 sc_threshold，并且默认 open gop，切换档位时需要闭合 gop
+      case AVCodecID.AV_CODEC_ID_HEVC: {
+        const params = 'scenecut=0:open-gop=0'
+        const userParams = videoConfig.encoderOptions?.['x265-params']
+        options['x265-params'] = userParams ? `${params}:${userParams}` : params
+        break
+      }
+      case AVCodecID.AV_CODEC_ID_VP8:
+      case AVCodecID.AV_CODEC_ID_VP9:
+      case AVCodecID.AV_CODEC_ID_AV1:
+        break
+      default:
+        logger.error(`video ladder not support ${codecName} encoder, cannot disable scene cut keyframe`)
+        return null
+    }
+
+    const encoderOptions = object.extend({}, options, videoConfig.encoderOptions ?? {})
+    if (options['x265-params']) {
+      encoderOptions['x265-params'] = options['x265-params']
+    }
+    return encoderOptions
+  }
+
   /**
    * @hidden
    */
@@ -1635,135 +2026,24 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
       const decoder2FilterChannel = createMessageChannel()
       const filter2EncoderChannel = createMessageChannel()
 
-      const newStream = this.copyAVStreamInterface(task, stream)
-      newStream.codecpar.flags &= ~AVCodecParameterFlags.AV_CODECPAR_FLAG_NO_PTS
-      newStream.codecpar.flags &= ~AVCodecParameterFlags.AV_CODECPAR_FLAG_NO_DTS
+      const newStream = this.createVideoOutputStream(task, stream)
 
       const taskId = generateUUID()
 
       let ret = 0
 
-      if (videoConfig) {
-        if (videoConfig.codec && videoConfig.codec !== 'copy') {
-          const codecId = VideoCodecString2CodecId[videoConfig.codec]
-          if (!is.number(codecId)) {
-            this.freeAVStreamInterface(newStream)
-            logger.fatal(`invalid codec name(${videoConfig.codec})`)
-          }
-          newStream.codecpar.codecId = codecId
+      const ladder = videoConfig?.ladder ?? []
+      let ladderEncoderOptions: Data = {}
+      let sharedModuleKey: string
 
-          if (newStream.codecpar.codecId !== stream.codecpar.codecId) {
-            newStream.codecpar.profile = NOPTS_VALUE
-            newStream.codecpar.level = NOPTS_VALUE
-          }
-        }
-        if (videoConfig.width) {
-          newStream.codecpar.width = videoConfig.width
-        }
-        if (videoConfig.height) {
-          newStream.codecpar.height = videoConfig.height
-        }
-        if (videoConfig.bitrate) {
-          newStream.codecpar.bitrate = static_cast<int64>(videoConfig.bitrate)
-        }
-        if (videoConfig.pixfmt) {
-          const pixfmt = PixfmtString2AVPixelFormat[videoConfig.pixfmt]
-          if (!is.number(pixfmt)) {
-            logger.fatal(`invalid pixfmt name(${videoConfig.pixfmt})`)
-          }
-          newStream.codecpar.format = pixfmt
-        }
-        if (videoConfig.framerate) {
-          newStream.codecpar.framerate.num = videoConfig.framerate >>> 0
-          newStream.codecpar.framerate.den = 1
-        }
-        if (videoConfig.aspect) {
-          newStream.codecpar.sampleAspectRatio.den = videoConfig.aspect.den
-          newStream.codecpar.sampleAspectRatio.num = videoConfig.aspect.num
-        }
-        if (videoConfig.profile) {
-          newStream.codecpar.profile = videoConfig.profile
-        }
-        if (videoConfig.level) {
-          newStream.codecpar.level = videoConfig.level
-        }
-        if (videoConfig.delay) {
-          newStream.codecpar.videoDelay = videoConfig.delay
-        }
-      }
-
-      if (newStream.codecpar.profile === NOPTS_VALUE) {
-        if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_H264) {
-          const descriptor = getAVPixelFormatDescriptor(newStream.codecpar.format as AVPixelFormat)
-          newStream.codecpar.profile = descriptor?.comp[0]?.depth === 10 ? h264.H264Profile.kHigh10 : h264.H264Profile.kHigh
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
-          const descriptor = getAVPixelFormatDescriptor(newStream.codecpar.format as AVPixelFormat)
-          newStream.codecpar.profile = descriptor?.comp[0]?.depth === 10 ? hevc.HEVCProfile.Main10 : hevc.HEVCProfile.Main
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VVC) {
-
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_AV1) {
-          newStream.codecpar.profile = av1.AV1Profile.Main
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP9) {
-          newStream.codecpar.profile = vp9.VP9Profile.Profile0
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP8) {
-          newStream.codecpar.profile = 0
-        }
-      }
-      if (newStream.codecpar.level === NOPTS_VALUE) {
-        if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_H264) {
-          newStream.codecpar.level = h264.getLevelByResolution(newStream.codecpar.width, newStream.codecpar.height, avQ2D(newStream.codecpar.framerate))
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
-          newStream.codecpar.level = hevc.getLevelByResolution(
-            newStream.codecpar.profile,
-            newStream.codecpar.width,
-            newStream.codecpar.height,
-            avQ2D(newStream.codecpar.framerate),
-            static_cast<double>(newStream.codecpar.bitrate)
-          )
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VVC) {
-          // TODO 现在还没有 vvc 编码器，将来如果加入了 vvc 编码器再来实现
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_AV1) {
-          newStream.codecpar.level = av1.getLevelByResolution(newStream.codecpar.width, newStream.codecpar.height, avQ2D(newStream.codecpar.framerate))
-        }
-        else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP9) {
-          newStream.codecpar.level = vp9.getLevelByResolution(newStream.codecpar.width, newStream.codecpar.height, avQ2D(newStream.codecpar.framerate))
-        }
-      }
-
-      if ((!videoConfig || videoConfig.delay == null)
-        && newStream.codecpar.videoDelay === 0
-      ) {
-        // 这个用来设置 max_b_frame_count，只针对 wasm 编码器，webcodecs 目前无法编码出 B 帧
-        newStream.codecpar.videoDelay = 4
-      }
-
-      if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_H264
-        || newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_MPEG4
-        || newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC
-        || newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VVC
-      ) {
-        if (task.oformat === AVFormat.MPEGTS
-          || task.oformat === AVFormat.H264
-          || task.oformat === AVFormat.HEVC
-          || task.oformat === AVFormat.VVC
-        ) {
-          newStream.codecpar.flags |= AVCodecParameterFlags.AV_CODECPAR_FLAG_H26X_ANNEXB
-        }
-        else {
-          newStream.codecpar.flags &= ~AVCodecParameterFlags.AV_CODECPAR_FLAG_H26X_ANNEXB
+      if (ladder.length) {
+        ladderEncoderOptions = await this.getLadderEncoderOptions(task, newStream)
+        if (!ladderEncoderOptions) {
+          this.freeAVStreamInterface(newStream)
+          return errorType.OPERATE_NOT_SUPPORT
         }
-      }
-
-      if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_MPEG4 && newStream.timeBase.den > 65535) {
-        this.changeAVStreamTimebase(newStream, { num: 1, den: 65535 })
+        // 各路编码类型相同，共用一个编码器 wasm 实例
+        sharedModuleKey = `${taskId}-encoder`
       }
 
       await this.DemuxerThread.connectStreamTask
@@ -1810,7 +2090,8 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
           avpacketListMutex: addressof(this.GlobalData.avpacketListMutex),
           avframeList: addressof(this.GlobalData.avframeList),
           avframeListMutex: addressof(this.GlobalData.avframeListMutex),
-          preferWebCodecs: !isHdr(stream.codecpar) && !hasAlphaChannel(stream.codecpar) && !!task.options.input.enableWebCodecs
+          preferWebCodecs: !isHdr(stream.codecpar) && !hasAlphaChannel(stream.codecpar) && !!task.options.input.enableWebCodecs,
+          codecStats: !!this.options.enableCodecStats
         })
 
       ret = await this.VideoDecoderThread.open(taskId, stream.codecpar)
@@ -1843,8 +2124,22 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
       })
 
       vertices.push(scaleNode)
+
+      // 码率阶梯只解码一次，split 把同一帧按引用计数分发给每一路的缩放和编码
+      const splitNode = ladder.length
+        ? createGraphDesVertex('split', {
+          count: ladder.length + 1
+        })
+        : null
+
+      if (splitNode) {
+        vertices.push(splitNode)
+      }
+
+      const headNode = splitNode ?? scaleNode
+
       input = {
-        id: scaleNode.id,
+        id: headNode.id,
         port: decoder2FilterChannel.port2
       }
       output = {
@@ -1867,7 +2162,7 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
         }
         edges.push({
           parent: rangeNode.id,
-          child: scaleNode.id
+          child: headNode.id
         })
         rangeNodeId = rangeNode.id
       }
@@ -1889,7 +2184,7 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
           })
           edges.push({
             parent: framerateNode.id,
-            child: scaleNode.id
+            child: headNode.id
           })
         }
         else {
@@ -1899,97 +2194,85 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
           }
           edges.push({
             parent: framerateNode.id,
-            child: scaleNode.id
+            child: headNode.id
           })
         }
       }
 
-      await this.VideoFilterThread.registerTask
-        .transfer(decoder2FilterChannel.port2, filter2EncoderChannel.port1)
-        .invoke({
-          taskId: taskId,
-          graph: {
-            vertices,
-            edges
-          },
-          inputPorts: [input],
-          outputPorts: [output],
-          stats: addressof(task.stats),
-          avframeList: addressof(this.GlobalData.avframeList),
-          avframeListMutex: addressof(this.GlobalData.avframeListMutex)
+      const outputPorts: FilterGraphPortDes[] = [output]
+      const renditions: {
+        taskId: string
+        stream: AVStreamInterface
+        filter2EncoderChannel: MessageChannel
+        encoder2MuxerChannel: MessageChannel
+      }[] = []
+
+      if (splitNode) {
+        edges.push({
+          parent: splitNode.id,
+          child: scaleNode.id
         })
 
-      let encoderResource = await this.getResource('encoder', newStream.codecpar.codecId, newStream.codecpar.codecType)
-      if (!encoderResource) {
-        if (support.videoEncoder) {
-          const isSupport = await VideoEncoder.isConfigSupported({
-            codec: getVideoCodec(newStream.codecpar),
-            width: newStream.codecpar.width,
-            height: newStream.codecpar.height
-          })
-          if (!isSupport.supported) {
-            logger.error(`VideoEncoder ${dumpUtils.dumpCodecName(newStream.codecpar.codecType, newStream.codecpar.codecId)} codecId ${newStream.codecpar.codecId} not support`)
-            this.freeAVStreamInterface(newStream)
-            return errorType.OPERATE_NOT_SUPPORT
-          }
-        }
-        else {
-          logger.error(`${dumpUtils.dumpCodecName(newStream.codecpar.codecType, newStream.codecpar.codecId)} encoder codecId ${newStream.codecpar.codecId} not support`)
-          this.freeAVStreamInterface(newStream)
-          return errorType.OPERATE_NOT_SUPPORT
-        }
-      }
+        let nextStreamId = 0
+        array.each(task.formatContext.streams, (st) => {
+          nextStreamId = Math.max(nextStreamId, st.id + 1)
+        })
 
-      const wasmEncoderOptions: Data = {}
-      const resourceExtraData: Data = {}
+        for (let i = 0; i < ladder.length; i++) {
+          const renditionStream = this.createVideoOutputStream(task, stream, ladder[i])
+          renditionStream.id = nextStreamId++
 
-      // x265 需要提前创建线程
-      if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
-        resourceExtraData.enableThreadPool = true
-        resourceExtraData.enableThreadCountRate = 2
-      }
-      // libvpx 需要提前创建线程
-      else if (newStream.codecpar.codecId === AVCodecID.AV_CODEC_ID_VP9) {
-        resourceExtraData.enableThreadPool = true
-      }
+          const renditionScaleNode = createGraphDesVertex('scaler', {
+            resource: scalerResource,
+            output: {
+              width: renditionStream.codecpar.width,
+              height: renditionStream.codecpar.height,
+              format: renditionStream.codecpar.format as AVPixelFormat
+            }
+          })
+          vertices.push(renditionScaleNode)
+          edges.push({
+            parent: splitNode.id,
+            child: renditionScaleNode.id
+          })
 
-      if (task.options?.output?.video?.encoderOptions) {
-        object.each(task.options.output.video.encoderOptions, (value, key) => {
-          wasmEncoderOptions[key] = value
-        })
+          const renditionFilter2EncoderChannel = createMessageChannel()
+          outputPorts.push({
+            id: renditionScaleNode.id,
+            port: renditionFilter2EncoderChannel.port1
+          })
+          renditions.push({
+            taskId: generateUUID(),
+            stream: renditionStream,
+            filter2EncoderChannel: renditionFilter2EncoderChannel,
+            encoder2MuxerChannel: createMessageChannel()
+          })
+        }
       }
 
-      // 注册一个视频编码任务
-      await this.VideoEncoderThread.registerTask
-        .transfer(filter2EncoderChannel.port2, encoder2MuxerChannel.port1)
+      await this.VideoFilterThread.registerTask
+        .transfer(decoder2FilterChannel.port2, ...outputPorts.map((item) => item.port))
         .invoke({
           taskId: taskId,
-          resource: encoderResource,
-          resourceExtraData,
-          leftPort: filter2EncoderChannel.port2,
-          rightPort: encoder2MuxerChannel.port1,
+          graph: {
+            vertices,
+            edges
+          },
+          inputPorts: [input],
+          outputPorts,
           stats: addressof(task.stats),
-          enableHardware: !!videoConfig.enableHardware && !!videoConfig.enableWebCodecs,
-          avpacketList: addressof(this.GlobalData.avpacketList),
-          avpacketListMutex: addressof(this.GlobalData.avpacketListMutex),
           avframeList: addressof(this.GlobalData.avframeList),
-          avframeListMutex: addressof(this.GlobalData.avframeListMutex),
-          gop: static_cast<int32>(avQ2D(newStream.codecpar.framerate) * (videoConfig.keyFrameInterval ?? 5000) / 1000),
-          preferWebCodecs: !isHdr(newStream.codecpar) && !hasAlphaChannel(newStream.codecpar) && !!videoConfig.enableWebCodecs,
-          copyTs: task.options.copyTs ?? false
+          avframeListMutex: addressof(this.GlobalData.avframeListMutex)
         })
 
-      ret = await this.VideoEncoderThread.open(taskId, newStream.codecpar, { num: newStream.timeBase.num, den: newStream.timeBase.den }, wasmEncoderOptions)
-
+      ret = await this.openVideoEncoder(task, taskId, newStream, filter2EncoderChannel.port2, encoder2MuxerChannel, ladderEncoderOptions, sharedModuleKey)
       if (ret < 0) {
-        logger.error(`cannot open video ${dumpUtils.dumpCodecName(newStream.codecpar.codecType, newStream.codecpar.codecId)} encoder`)
-        this.freeAVStreamInterface(newStream)
+        array.each(renditions, (rendition) => {
+          this.freeAVStreamInterface(rendition.stream)
+        })
         return ret
       }
 
-      await this.MuxThread.addStream.transfer(encoder2MuxerChannel.port2)
-        .invoke(task.taskId, newStream, encoder2MuxerChannel.port2)
-
       task.streams.push({
         taskId,
         input: stream,
@@ -2000,6 +2283,32 @@ export default class AVTranscoder extends Emitter implements ControllerObserver
         encoder2MuxerChannel
       })
 
+      for (let i = 0; i < renditions.length; i++) {
+        ret = await this.openVideoEncoder(
+          task,
+          renditions[i].taskId,
+          renditions[i].stream,
+          renditions[i].filter2EncoderChannel.port2,
+          renditions[i].encoder2MuxerChannel,
+          object.extend({}, ladderEncoderOptions, ladder[i].encoderOptions ?? {}),
+          sharedModuleKey
+        )
+        if (ret < 0) {
+          for (let j = i + 1; j < renditions.length; j++) {
+            this.freeAVStreamInterface(renditions[j].stream)
+          }
+          return ret
+        }
+        // 编码任务 id 和解码、滤镜任务不同，clearTask 时只会注销对应的编码任务
+        task.streams.push({
+          taskId: renditions[i].taskId,
+          input: stream,
+          output: renditions[i].stream,
+          filter2EncoderChannel: renditions[i].filter2EncoderChannel,
+          encoder2MuxerChannel: renditions[i].encoder2MuxerChannel
+        })
+      }
+
       return 0
     }
   }
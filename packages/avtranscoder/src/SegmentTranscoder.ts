@@ -0,0 +1,415 @@
+/*
+ * libmedia segment parallel transcoder
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ *
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ *
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import {
+  logger,
+  array
+} from '@libmedia/common'
+
+import {
+  type AVStream,
+  AVMediaType,
+  AVPacketFlags,
+  AVSeekFlags,
+  AVDiscard,
+  AVDisposition,
+  AVFormat,
+  errorType,
+  createAVPacket,
+  destroyAVPacket,
+  unrefAVPacket,
+  copyCodecParameters,
+  avRescaleQ,
+  avRescaleQ2,
+  NOPTS_VALUE_BIGINT
+} from '@libmedia/avutil'
+
+import {
+  AV_MILLI_TIME_BASE_Q,
+  AV_TIME_BASE_Q,
+  Format2AVFormat,
+  Ext2Format
+} from '@libmedia/avutil/internal'
+
+import {
+  demux,
+  mux,
+  type AVIFormatContext
+} from '@libmedia/avformat'
+
+import type { AVTranscoderOptions, TaskOptions } from './AVTranscoder'
+import AVTranscoder from './AVTranscoder'
+import {
+  MemoryWriter,
+  SegmentPacketReader,
+  createOFormat,
+  createOutput,
+  runTask
+} from './function/segment'
+
+export interface SegmentTranscoderOptions extends AVTranscoderOptions {
+  /**
+   * 并行的转码实例数量，每个实例有自己独立的一组 worker
+   */
+  workers: number
+}
+
+export interface SegmentTaskOptions {
+  input: TaskOptions['input'] & {
+    /**
+     * 每个实例各自打开输入，只支持本地文件
+     */
+    file: File
+  }
+  output: TaskOptions['output']
+  /**
+   * 每一段的最短时长（毫秒），默认 5000
+   */
+  minSegmentDuration?: number
+  /**
+   * pts dts 强制从 0 开始
+   */
+  startAtZero?: boolean
+  /**
+   * pts dts 强制为非负数
+   */
+  nonnegative?: boolean
+}
+
+interface Segment {
+  /**
+   * 开始时间（毫秒），为这一段第一个关键帧的时间
+   */
+  start: number
+  /**
+   * 持续时间（毫秒），最后一段为 0 表示到结尾
+   */
+  duration: number
+  data?: Uint8Array
+}
+
+/**
+ * 分段并行转码
+ *
+ * 点播文件在关键帧处切成多段（通过 demuxer 的索引 seek 定位关键帧），每段由一个独立的 AVTranscoder 实例（各自一组 worker）转码，
+ * 所有段完成之后按顺序重新封装到输出中，wasm 编码器线程扩展性不好时可以用多个实例吃满多核
+ *
+ * 视频逐段编码，音频在其中一个实例上整体单独编码，避免每段音频编码器的 priming 造成段边界处的空隙；
+ * 所有任务使用 copyTs，段的输出时间戳就是源时间戳，拼接时不需要再计算偏移
+ *
+ * 中间结果使用 matroska 保存在内存中，输出只支持 mp4、mpegts、matroska 和 webm，只输出一路视频和一路音频
+ *
+ * formatContext 需要调用方完成 demux.open 和 demux.analyzeStreams，用于查找切分点
+ */
+export default class SegmentTranscoder {
+
+  private options: SegmentTranscoderOptions
+
+  private transcoders: AVTranscoder[] = []
+
+  constructor(options: SegmentTranscoderOptions) {
+    this.options = options
+  }
+
+  public async ready() {
+    const count = Math.max(this.options.workers, 1)
+    for (let i = this.transcoders.length; i < count; i++) {
+      const transcoder = new AVTranscoder(this.options)
+      await transcoder.ready()
+      this.transcoders.push(transcoder)
+    }
+  }
+
+  /**
+   * 在关键帧处切分，段数为实例数的两倍，每段不短于 minDuration
+   */
+  private async split(formatContext: AVIFormatContext, stream: AVStream, minDuration: number): Promise<Segment[]> {
+    const startTime = stream.startTime !== NOPTS_VALUE_BIGINT
+      ? static_cast<double>(avRescaleQ(stream.startTime, stream.timeBase, AV_MILLI_TIME_BASE_Q))
+      : 0
+    const duration = stream.duration !== NOPTS_VALUE_BIGINT
+      ? static_cast<double>(avRescaleQ(stream.duration, stream.timeBase, AV_MILLI_TIME_BASE_Q))
+      : 0
+
+    const count = Math.min(this.transcoders.length * 2, Math.floor(duration / minDuration))
+
+    const points: number[] = [0]
+
+    if (count > 1) {
+      const discards = formatContext.streams.map((s) => s.discard)
+      array.each(formatContext.streams, (s) => {
+        s.discard = s === stream ? AVDiscard.AVDISCARD_NONKEY : AVDiscard.AVDISCARD_ALL
+      })
+
+      const avpacket = createAVPacket()
+
+      for (let i = 1; i < count; i++) {
+        const target = startTime + duration * i / count
+        const seekRet = await demux.seek(formatContext, stream.index, static_cast<int64>(Math.floor(target)), AVSeekFlags.NONE)
+        if (seekRet < 0n) {
+          continue
+        }
+        while (true) {
+          const ret = await demux.readAVPacket(formatContext, avpacket)
+          if (ret < 0) {
+            break
+          }
+          if (avpacket.streamIndex !== stream.index || !(avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY)) {
+            unrefAVPacket(avpacket)
+            continue
+          }
+          const pts = avpacket.pts !== NOPTS_VALUE_BIGINT ? avpacket.pts : avpacket.dts
+          const point = Math.floor(static_cast<double>(avRescaleQ(pts, stream.timeBase, AV_MILLI_TIME_BASE_Q)))
+          if (point - points[points.length - 1] >= minDuration
+            && (!duration || startTime + duration - point >= minDuration)
+          ) {
+            points.push(point)
+          }
+          unrefAVPacket(avpacket)
+          break
+        }
+      }
+
+      destroyAVPacket(avpacket)
+
+      array.each(formatContext.streams, (s, index) => {
+        s.discard = discards[index]
+      })
+    }
+
+    const segments: Segment[] = []
+    for (let i = 0; i < points.length; i++) {
+      segments.push({
+        start: points[i],
+        // range 的结束是闭区间，提前 1 毫秒避免下一段的关键帧在两段中都输出
+        duration: i < points.length - 1 ? points[i + 1] - points[i] - 1 : 0
+      })
+    }
+    return segments
+  }
+
+  private async concat(
+    options: SegmentTaskOptions,
+    format: AVFormat,
+    videoDatas: Uint8Array[],
+    audioData: Uint8Array | null
+  ): Promise<int32> {
+    const oformat = await createOFormat(format, options.output.formatOptions)
+    if (!oformat) {
+      logger.error('segment transcode only support mp4, mpegts, matroska and webm output')
+      return errorType.FORMAT_NOT_SUPPORT
+    }
+
+    const videoReader = new SegmentPacketReader(videoDatas, AVMediaType.AVMEDIA_TYPE_VIDEO)
+    const audioReader = audioData ? new SegmentPacketReader([audioData], AVMediaType.AVMEDIA_TYPE_AUDIO) : null
+
+    const videoStream = await videoReader.open()
+    const audioStream = audioReader ? await audioReader.open() : null
+
+    if (!videoStream) {
+      logger.error('open first video segment failed')
+      await videoReader.close()
+      if (audioReader) {
+        await audioReader.close()
+      }
+      return errorType.DATA_INVALID
+    }
+
+    const { oformatContext, fileWriter } = await createOutput(options.output.file, oformat)
+
+    const streams: AVStream[] = audioStream ? [videoStream, audioStream] : [videoStream]
+    array.each(streams, (stream) => {
+      const ostream = oformatContext.createStream()
+      copyCodecParameters(addressof(ostream.codecpar), addressof(stream.codecpar))
+      ostream.timeBase.den = stream.timeBase.den
+      ostream.timeBase.num = stream.timeBase.num
+    })
+
+    let ret = mux.open(oformatContext, {
+      zeroStart: options.startAtZero ?? false,
+      nonnegative: options.nonnegative ?? false
+    })
+    if (ret < 0) {
+      logger.error(`open segment output muxer failed, ret: ${ret}`)
+    }
+    else {
+      mux.writeHeader(oformatContext)
+
+      const videoPacket = createAVPacket()
+      const audioPacket = createAVPacket()
+
+      let hasVideo = await videoReader.read(videoPacket)
+      let hasAudio = audioReader ? await audioReader.read(audioPacket) : false
+
+      // 按 dts 交织写入
+      while (hasVideo || hasAudio) {
+        let writeVideo = hasVideo
+        if (hasVideo && hasAudio) {
+          writeVideo = avRescaleQ2(videoPacket.dts, addressof(videoPacket.timeBase), AV_TIME_BASE_Q)
+            <= avRescaleQ2(audioPacket.dts, addressof(audioPacket.timeBase), AV_TIME_BASE_Q)
+        }
+        if (writeVideo) {
+          videoPacket.streamIndex = 0
+          mux.writeAVPacket(oformatContext, videoPacket)
+          unrefAVPacket(videoPacket)
+          hasVideo = await videoReader.read(videoPacket)
+        }
+        else {
+          audioPacket.streamIndex = 1
+          mux.writeAVPacket(oformatContext, audioPacket)
+          unrefAVPacket(audioPacket)
+          hasAudio = await audioReader.read(audioPacket)
+        }
+      }
+
+      mux.writeTrailer(oformatContext)
+      mux.flush(oformatContext)
+
+      destroyAVPacket(videoPacket)
+      destroyAVPacket(audioPacket)
+    }
+
+    await videoReader.close()
+    if (audioReader) {
+      await audioReader.close()
+    }
+    await oformatContext.destroy()
+    await fileWriter.close()
+
+    return ret < 0 ? ret : 0
+  }
+
+  /**
+   * 分段并行转码
+   *
+   * @param formatContext 用于查找切分点的输入
+   * @param options
+   * @returns 成功返回 0，否则返回错误码
+   */
+  public async transcode(formatContext: AVIFormatContext, options: SegmentTaskOptions): Promise<int32> {
+    const stream = formatContext.streams.find((stream) => {
+      return stream.codecpar.codecType === AVMediaType.AVMEDIA_TYPE_VIDEO
+        && !(stream.disposition & AVDisposition.ATTACHED_PIC)
+    })
+    if (!stream || options.output.video?.disable) {
+      logger.error('segment transcode need video stream')
+      return errorType.INVALID_PARAMETERS
+    }
+    if (options.output.video?.codec === 'copy') {
+      logger.error('segment transcode not support video copy')
+      return errorType.INVALID_PARAMETERS
+    }
+
+    let format: AVFormat
+    if (options.output.format) {
+      format = Format2AVFormat[options.output.format]
+    }
+    else if (options.output.file instanceof FileSystemFileHandle) {
+      format = Ext2Format[options.output.file.name.split('.').pop()]
+    }
+
+    await this.ready()
+
+    const segments = await this.split(formatContext, stream, options.minSegmentDuration ?? 5000)
+
+    const hasAudio = !options.output.audio?.disable
+      && formatContext.streams.some((s) => s.codecpar.codecType === AVMediaType.AVMEDIA_TYPE_AUDIO)
+
+    logger.info(`segment transcode start, segments: ${segments.length}, workers: ${this.transcoders.length}`)
+
+    let audioData: Uint8Array | null = null
+    let error = 0
+
+    const jobs: Promise<void>[] = []
+
+    if (hasAudio) {
+      const writer = new MemoryWriter()
+      jobs.push(runTask(this.transcoders[0], {
+        input: options.input,
+        copyTs: true,
+        output: {
+          file: writer,
+          format: 'mkv',
+          video: {
+            disable: true
+          },
+          audio: options.output.audio
+        }
+      }).then((ret) => {
+        if (ret < 0) {
+          error = ret
+        }
+        audioData = writer.getData()
+      }))
+    }
+
+    let next = 0
+    const worker = async (transcoder: AVTranscoder) => {
+      while (next < segments.length && !error) {
+        const segment = segments[next++]
+        const writer = new MemoryWriter()
+        const ret = await runTask(transcoder, {
+          input: options.input,
+          start: segment.start,
+          duration: segment.duration,
+          copyTs: true,
+          output: {
+            file: writer,
+            format: 'mkv',
+            video: options.output.video,
+            audio: {
+              disable: true
+            }
+          }
+        })
+        if (ret < 0) {
+          logger.error(`transcode segment ${segment.start}ms failed, ret: ${ret}`)
+          error = ret
+          break
+        }
+        segment.data = writer.getData()
+      }
+    }
+
+    array.each(this.transcoders, (transcoder) => {
+      jobs.push(worker(transcoder))
+    })
+
+    await Promise.all(jobs)
+
+    if (error) {
+      return error
+    }
+
+    return this.concat(options, format, segments.map((segment) => segment.data), audioData)
+  }
+
+  public async destroy() {
+    for (let i = 0; i < this.transcoders.length; i++) {
+      await this.transcoders[i].destroy()
+    }
+    this.transcoders.length = 0
+  }
+}
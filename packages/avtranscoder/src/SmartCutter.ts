@@ -0,0 +1,836 @@
+/*
+ * libmedia smart cutter
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ *
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ *
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import {
+  mapSafeUint8Array,
+  mapUint8Array
+} from '@libmedia/cheap'
+
+import {
+  logger,
+  array,
+  object
+} from '@libmedia/common'
+
+import {
+  type AVPacket,
+  type AVStream,
+  type AVCodecParameters,
+  AVCodecID,
+  AVMediaType,
+  AVPacketFlags,
+  AVSeekFlags,
+  AVDiscard,
+  AVDisposition,
+  AVFormat,
+  errorType,
+  createAVPacket,
+  destroyAVPacket,
+  unrefAVPacket,
+  addAVPacketData,
+  copyCodecParameters,
+  avMalloc,
+  avRescaleQ,
+  avRescaleQ2,
+  nalu as naluUtil,
+  NOPTS_VALUE_BIGINT
+} from '@libmedia/avutil'
+
+import {
+  AV_MILLI_TIME_BASE_Q,
+  AV_TIME_BASE_Q,
+  Format2AVFormat,
+  Ext2Format,
+  VideoCodecString2CodecId,
+  h264,
+  hevc
+} from '@libmedia/avutil/internal'
+
+import {
+  demux,
+  mux,
+  type AVIFormatContext
+} from '@libmedia/avformat'
+
+import { mktag } from '@libmedia/avformat/internal'
+
+import type { AVTranscoderOptions, TaskOptions } from './AVTranscoder'
+import AVTranscoder from './AVTranscoder'
+import {
+  MemoryWriter,
+  SegmentPacketReader,
+  createOFormat,
+  createOutput,
+  runTask
+} from './function/segment'
+
+export interface SmartCutOptions {
+  input: TaskOptions['input'] & {
+    /**
+     * 边界重编码的任务需要单独打开输入，只支持本地文件
+     */
+    file: File
+  }
+  /**
+   * video 为边界处重编码使用的编码参数，编码类型、宽高和帧率跟随源
+   *
+   * 音频总是流复制
+   */
+  output: TaskOptions['output']
+  /**
+   * 开始时间（毫秒），源时间戳
+   */
+  start: number
+  /**
+   * 持续时间（毫秒），不传到结尾
+   */
+  duration?: number
+  /**
+   * pts dts 强制从 0 开始
+   */
+  startAtZero?: boolean
+  /**
+   * pts dts 强制为非负数
+   */
+  nonnegative?: boolean
+}
+
+interface Boundary {
+  reader: SegmentPacketReader
+  stream: AVStream
+  parameterSets: ParameterSets | null
+}
+
+interface ParameterSets {
+  nalus: Uint8Array[]
+  naluLengthSizeMinusOne: int32
+}
+
+/**
+ * 裁剪点两侧的关键帧（流时间基）
+ */
+interface CutPoints {
+  /**
+   * 范围内的第一个关键帧，之前的部分重编码
+   */
+  first: int64
+  /**
+   * 范围内的最后一个关键帧，从这里到结束重编码，NOPTS_VALUE_BIGINT 表示一直复制到结尾
+   */
+  last: int64
+}
+
+/**
+ * 只支持编码参数可以放在关键帧带内切换或者不需要编码参数的编码
+ */
+const SupportedCodecs = [
+  AVCodecID.AV_CODEC_ID_H264,
+  AVCodecID.AV_CODEC_ID_HEVC,
+  AVCodecID.AV_CODEC_ID_VP8,
+  AVCodecID.AV_CODEC_ID_VP9
+]
+
+/**
+ * 查找前置帧时关键帧之后最多检查的包数，h264/hevc 的 dpb 最多 16 帧
+ */
+const MaxReorderPackets = 16
+
+function getPts(avpacket: pointer<AVPacket>) {
+  return avpacket.pts !== NOPTS_VALUE_BIGINT ? avpacket.pts : avpacket.dts
+}
+
+function getDelay(avpacket: pointer<AVPacket>) {
+  return avpacket.pts !== NOPTS_VALUE_BIGINT && avpacket.dts !== NOPTS_VALUE_BIGINT
+    ? avpacket.pts - avpacket.dts
+    : 0n
+}
+
+/**
+ * 取 avcc 格式 extradata 中的编码参数和长度字段大小，annexb 或者没有 extradata 返回 null
+ */
+function getParameterSets(codecpar: AVCodecParameters): ParameterSets | null {
+  if (!codecpar.extradata || !codecpar.extradataSize) {
+    return null
+  }
+  const extradata = mapUint8Array(codecpar.extradata, reinterpret_cast<size>(codecpar.extradataSize)).slice()
+  if (naluUtil.isAnnexb(extradata)) {
+    return null
+  }
+  if (codecpar.codecId === AVCodecID.AV_CODEC_ID_H264 && extradata.length >= 7) {
+    const { spss, ppss, spsExts } = h264.extradata2SpsPps(extradata)
+    return {
+      nalus: [...spss, ...spsExts, ...ppss] as Uint8Array[],
+      naluLengthSizeMinusOne: extradata[4] & 0x03
+    }
+  }
+  else if (codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC && extradata.length >= 23) {
+    const { vpss, spss, ppss } = hevc.extradata2VpsSpsPps(extradata)
+    return {
+      nalus: [...vpss, ...spss, ...ppss] as Uint8Array[],
+      naluLengthSizeMinusOne: extradata[21] & 0x03
+    }
+  }
+  return null
+}
+
+/**
+ * avcc 格式的包长度字段转换成 naluLengthSizeMinusOne，关键帧前插入编码参数
+ */
+function insertParameterSets(avpacket: pointer<AVPacket>, parameterSets: ParameterSets, naluLengthSizeMinusOne: int32) {
+  const nalus = naluUtil.splitNaluByLength(
+    mapSafeUint8Array(avpacket.data, reinterpret_cast<size>(avpacket.size)),
+    parameterSets.naluLengthSizeMinusOne
+  )
+  if (avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY) {
+    nalus.unshift(...parameterSets.nalus)
+  }
+  const length = nalus.reduce((prev, nalu) => {
+    return prev + naluLengthSizeMinusOne + 1 + nalu.length
+  }, 0)
+  const data: pointer<uint8> = avMalloc(length)
+  naluUtil.joinNaluByLength(nalus, naluLengthSizeMinusOne, mapUint8Array(data, length))
+  addAVPacketData(avpacket, data, length)
+}
+
+/**
+ * 按源流的关键帧读取复制部分和音频
+ *
+ * 视频从第一个关键帧开始，遇到 last 关键帧结束，第一个关键帧之后 pts 更小的前置帧（open gop）属于重编码的头部，丢弃；
+ * 音频输出 [start, end] 之间的包
+ */
+class SourcePacketReader {
+
+  private formatContext: AVIFormatContext
+
+  private videoStream: AVStream
+
+  private audioStream: AVStream | null
+
+  private points: CutPoints
+
+  private audioStart: int64
+
+  private audioEnd: int64
+
+  private queues: pointer<AVPacket>[][] = [[], []]
+
+  private videoStarted: boolean = false
+
+  private videoEnded: boolean = false
+
+  private audioEnded: boolean = false
+
+  private ended: boolean = false
+
+  /**
+   * 源第一个关键帧的 pts - dts，重编码的头部 dts 需要同样往前移，保证和复制部分衔接时 dts 递增
+   */
+  public headDelay: int64 = 0n
+
+  /**
+   * 源最后一个关键帧的 pts - dts
+   */
+  public tailDelay: int64 = 0n
+
+  constructor(
+    formatContext: AVIFormatContext,
+    videoStream: AVStream,
+    audioStream: AVStream | null,
+    points: CutPoints,
+    start: number,
+    end: number
+  ) {
+    this.formatContext = formatContext
+    this.videoStream = videoStream
+    this.audioStream = audioStream
+    this.points = points
+    this.audioEnded = !audioStream
+    if (audioStream) {
+      this.audioStart = avRescaleQ(static_cast<int64>(start), AV_MILLI_TIME_BASE_Q, audioStream.timeBase)
+      this.audioEnd = end >= 0
+        ? avRescaleQ(static_cast<int64>(end), AV_MILLI_TIME_BASE_Q, audioStream.timeBase)
+        : NOPTS_VALUE_BIGINT
+    }
+  }
+
+  public async open(start: number) {
+    array.each(this.formatContext.streams, (s) => {
+      s.discard = (s === this.videoStream || s === this.audioStream) ? AVDiscard.AVDISCARD_DEFAULT : AVDiscard.AVDISCARD_ALL
+    })
+    const ret = await demux.seek(this.formatContext, this.videoStream.index, static_cast<int64>(start), AVSeekFlags.NONE)
+    if (ret < 0n) {
+      return errorType.DATA_INVALID
+    }
+    // 读到第一个关键帧拿到 headDelay
+    while (!this.videoStarted && !this.videoEnded && !this.ended) {
+      await this.fill()
+    }
+    return 0
+  }
+
+  private accept(avpacket: pointer<AVPacket>, stream: AVStream) {
+    avpacket.timeBase.den = stream.timeBase.den
+    avpacket.timeBase.num = stream.timeBase.num
+    this.queues[stream === this.videoStream ? 0 : 1].push(avpacket)
+  }
+
+  private async fill() {
+    const avpacket = createAVPacket()
+    const ret = await demux.readAVPacket(this.formatContext, avpacket)
+    if (ret < 0) {
+      destroyAVPacket(avpacket)
+      this.ended = true
+      return
+    }
+
+    const pts = getPts(avpacket)
+
+    if (avpacket.streamIndex === this.videoStream.index && !this.videoEnded) {
+      const key = avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY
+      if (key && pts === this.points.first) {
+        this.headDelay = getDelay(avpacket)
+      }
+      if (key && this.points.last !== NOPTS_VALUE_BIGINT && pts >= this.points.last) {
+        this.tailDelay = getDelay(avpacket)
+        this.videoEnded = true
+      }
+      else if (this.videoStarted ? pts >= this.points.first : (key && pts >= this.points.first)) {
+        this.videoStarted = true
+        this.accept(avpacket, this.videoStream)
+        return
+      }
+    }
+    else if (this.audioStream && avpacket.streamIndex === this.audioStream.index && !this.audioEnded) {
+      if (this.audioEnd !== NOPTS_VALUE_BIGINT && pts > this.audioEnd) {
+        this.audioEnded = true
+      }
+      else if (pts >= this.audioStart) {
+        this.accept(avpacket, this.audioStream)
+        return
+      }
+    }
+
+    if (this.videoEnded && this.audioEnded) {
+      this.ended = true
+    }
+    destroyAVPacket(avpacket)
+  }
+
+  /**
+   * 读取下一个包，读完返回 nullptr，返回的包由调用方释放
+   */
+  public async read(mediaType: AVMediaType) {
+    const queue = this.queues[mediaType === AVMediaType.AVMEDIA_TYPE_VIDEO ? 0 : 1]
+    while (!queue.length && !this.ended) {
+      await this.fill()
+    }
+    return queue.length ? queue.shift() : nullptr
+  }
+
+  public close() {
+    array.each(this.queues, (queue) => {
+      array.each(queue, (avpacket) => {
+        destroyAVPacket(avpacket)
+      })
+      queue.length = 0
+    })
+  }
+}
+
+/**
+ * 关键帧对齐的智能裁剪
+ *
+ * 只重编码裁剪点两侧不完整的 gop：开始时间到之后第一个关键帧之间的头部，最后一个关键帧到结束时间之间的尾部，
+ * 中间完整的 gop 直接从源流复制，长录像的裁剪速度接近 IO 速度而不是编码速度
+ *
+ * 边界重编码使用和源相同的编码类型和宽高，h264/hevc 重编码部分的关键帧在带内携带自己的 sps/pps（avcc 长度前缀改成和源一致），
+ * 复制部分的第一个关键帧带内携带源的 sps/pps，mp4 输出使用允许带内参数集的 avc3/hev1 sample entry，extradata 仍然是源的
+ * 
+ * 最后一个关键帧之后解码顺序上有前置帧（open gop 或者 hevc 的 RASL/RADL）时，这些帧依赖重编码的尾部关键帧无法复制，回退到整段重编码
+ *
+ * 不支持的编码（或者输出编码和源不同）回退到 AVTranscoder 的整段重编码
+ *
+ * formatContext 需要调用方完成 demux.open 和 demux.analyzeStreams，用于查找关键帧和读取复制部分
+ */
+export default class SmartCutter {
+
+  private options: AVTranscoderOptions
+
+  private transcoder: AVTranscoder | undefined
+
+  constructor(options: AVTranscoderOptions) {
+    this.options = options
+  }
+
+  public async ready() {
+    if (!this.transcoder) {
+      this.transcoder = new AVTranscoder(this.options)
+      await this.transcoder.ready()
+    }
+  }
+
+  /**
+   * 查找 [start, end] 之间的第一个和最后一个关键帧
+   */
+  private async findCutPoints(formatContext: AVIFormatContext, stream: AVStream, start: int64, end: int64): Promise<CutPoints> {
+    const points: CutPoints = {
+      first: NOPTS_VALUE_BIGINT,
+      last: NOPTS_VALUE_BIGINT
+    }
+
+    const discards = formatContext.streams.map((s) => s.discard)
+    array.each(formatContext.streams, (s) => {
+      s.discard = s === stream ? AVDiscard.AVDISCARD_NONKEY : AVDiscard.AVDISCARD_ALL
+    })
+
+    const seekRet = await demux.seek(
+      formatContext,
+      stream.index,
+      avRescaleQ(start, stream.timeBase, AV_MILLI_TIME_BASE_Q),
+      AVSeekFlags.NONE
+    )
+
+    if (seekRet >= 0n) {
+      const avpacket = createAVPacket()
+      while (true) {
+        const ret = await demux.readAVPacket(formatContext, avpacket)
+        if (ret < 0) {
+          break
+        }
+        if (avpacket.streamIndex !== stream.index || !(avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY)) {
+          unrefAVPacket(avpacket)
+          continue
+        }
+        const pts = getPts(avpacket)
+        unrefAVPacket(avpacket)
+        if (end !== NOPTS_VALUE_BIGINT && pts > end) {
+          break
+        }
+        if (pts >= start) {
+          if (points.first === NOPTS_VALUE_BIGINT) {
+            points.first = pts
+          }
+          points.last = pts
+          // 复制到结尾不需要最后一个关键帧
+          if (end === NOPTS_VALUE_BIGINT) {
+            break
+          }
+        }
+      }
+      destroyAVPacket(avpacket)
+    }
+
+    array.each(formatContext.streams, (s, index) => {
+      s.discard = discards[index]
+    })
+
+    return points
+  }
+
+  /**
+   * 关键帧之后解码顺序上是否有 pts 更小的前置帧
+   */
+  private async hasLeadingPictures(formatContext: AVIFormatContext, stream: AVStream, keyPts: int64): Promise<boolean> {
+    const discards = formatContext.streams.map((s) => s.discard)
+    array.each(formatContext.streams, (s) => {
+      s.discard = s === stream ? AVDiscard.AVDISCARD_DEFAULT : AVDiscard.AVDISCARD_ALL
+    })
+
+    let leading = false
+
+    const seekRet = await demux.seek(
+      formatContext,
+      stream.index,
+      avRescaleQ(keyPts, stream.timeBase, AV_MILLI_TIME_BASE_Q),
+      AVSeekFlags.NONE
+    )
+
+    if (seekRet >= 0n) {
+      const avpacket = createAVPacket()
+      let found = false
+      let count = 0
+      while (true) {
+        const ret = await demux.readAVPacket(formatContext, avpacket)
+        if (ret < 0) {
+          break
+        }
+        if (avpacket.streamIndex !== stream.index) {
+          unrefAVPacket(avpacket)
+          continue
+        }
+        const pts = getPts(avpacket)
+        const key = avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY
+        unrefAVPacket(avpacket)
+        if (!found) {
+          if (key && pts === keyPts) {
+            found = true
+          }
+          else if (key && pts > keyPts) {
+            break
+          }
+          continue
+        }
+        if (key || ++count > MaxReorderPackets) {
+          break
+        }
+        if (pts < keyPts) {
+          leading = true
+          break
+        }
+      }
+      destroyAVPacket(avpacket)
+    }
+
+    array.each(formatContext.streams, (s, index) => {
+      s.discard = discards[index]
+    })
+
+    return leading
+  }
+
+  /**
+   * 整段重编码，输出编码类型跟随源
+   */
+  private reencode(options: SmartCutOptions) {
+    const video = object.extend({}, options.output.video ?? {})
+    delete video.codec
+    return runTask(this.transcoder, {
+      input: options.input,
+      start: options.start,
+      duration: options.duration,
+      output: object.extend({}, options.output, {
+        video
+      })
+    })
+  }
+
+  /**
+   * 重编码一个边界，使用 copyTs，输出时间戳就是源时间戳
+   */
+  private async encodeBoundary(options: SmartCutOptions, stream: AVStream, start: number, duration: number): Promise<Boundary> {
+    const video = object.extend({}, options.output.video ?? {}, {
+      width: stream.codecpar.width,
+      height: stream.codecpar.height,
+      // 不使用 b 帧，重编码部分 dts 等于 pts，只需要整体平移就能和复制部分衔接
+      delay: 0
+    })
+    delete video.codec
+    delete video.framerate
+    delete video.ladder
+
+    const writer = new MemoryWriter()
+    const ret = await runTask(this.transcoder, {
+      input: options.input,
+      start,
+      duration: Math.max(duration, 1),
+      copyTs: true,
+      output: {
+        file: writer,
+        format: 'mkv',
+        video,
+        audio: {
+          disable: true
+        }
+      }
+    })
+    if (ret < 0) {
+      logger.error(`encode boundary ${start}ms failed, ret: ${ret}`)
+      return null
+    }
+
+    const reader = new SegmentPacketReader([writer.getData()], AVMediaType.AVMEDIA_TYPE_VIDEO)
+    const boundaryStream = await reader.open()
+    if (!boundaryStream) {
+      logger.error(`open boundary ${start}ms failed`)
+      await reader.close()
+      return null
+    }
+    return {
+      reader,
+      stream: boundaryStream,
+      parameterSets: getParameterSets(boundaryStream.codecpar)
+    }
+  }
+
+  /**
+   * 重编码部分的包转换到源流的时间基和码流格式
+   */
+  private convertBoundaryPacket(avpacket: pointer<AVPacket>, boundary: Boundary, stream: AVStream, delay: int64, naluLengthSizeMinusOne: int32) {
+    const pts = avRescaleQ2(getPts(avpacket), addressof(avpacket.timeBase), stream.timeBase)
+    if (avpacket.duration !== NOPTS_VALUE_BIGINT) {
+      avpacket.duration = avRescaleQ2(avpacket.duration, addressof(avpacket.timeBase), stream.timeBase)
+    }
+    avpacket.pts = pts
+    avpacket.dts = pts - delay
+    avpacket.timeBase.den = stream.timeBase.den
+    avpacket.timeBase.num = stream.timeBase.num
+
+    if (boundary.parameterSets) {
+      insertParameterSets(avpacket, boundary.parameterSets, naluLengthSizeMinusOne)
+    }
+  }
+
+  private async remux(
+    options: SmartCutOptions,
+    format: AVFormat,
+    source: SourcePacketReader,
+    videoStream: AVStream,
+    audioStream: AVStream | null,
+    head: Boundary | null,
+    tail: Boundary | null
+  ): Promise<int32> {
+    const oformat = await createOFormat(format, options.output.formatOptions)
+    if (!oformat) {
+      logger.error('smart cut only support mp4, mpegts, matroska and webm output')
+      return errorType.FORMAT_NOT_SUPPORT
+    }
+
+    const { oformatContext, fileWriter } = await createOutput(options.output.file, oformat)
+
+    const streams: AVStream[] = audioStream ? [videoStream, audioStream] : [videoStream]
+    array.each(streams, (stream) => {
+      const ostream = oformatContext.createStream()
+      copyCodecParameters(addressof(ostream.codecpar), addressof(stream.codecpar))
+      ostream.timeBase.den = stream.timeBase.den
+      ostream.timeBase.num = stream.timeBase.num
+      // 重编码部分的 sps/pps 和 extradata 不同，avc1/hvc1 要求参数集都在 sample entry 中
+      if (stream === videoStream && (head || tail)) {
+        if (stream.codecpar.codecId === AVCodecID.AV_CODEC_ID_H264) {
+          ostream.codecpar.codecTag = mktag('avc3')
+        }
+        else if (stream.codecpar.codecId === AVCodecID.AV_CODEC_ID_HEVC) {
+          ostream.codecpar.codecTag = mktag('hev1')
+        }
+      }
+    })
+
+    // 带内参数集的长度字段和源保持一致，annexb 的源由 muxer 按默认长度转换
+    const sourceParameterSets = getParameterSets(videoStream.codecpar)
+    const naluLengthSizeMinusOne = sourceParameterSets
+      ? sourceParameterSets.naluLengthSizeMinusOne
+      : h264.NALULengthSizeMinusOne
+
+    const boundaries = [head, null, tail]
+    let stage = 0
+    // 头部重编码之后解码器使用的是头部的参数集，复制部分的第一个关键帧需要带上源的参数集
+    let needSourceParameterSets = !!head && !!sourceParameterSets
+
+    const readVideo = async (): Promise<pointer<AVPacket>> => {
+      while (stage < boundaries.length) {
+        const boundary = boundaries[stage]
+        if (stage === 1) {
+          const avpacket = await source.read(AVMediaType.AVMEDIA_TYPE_VIDEO)
+          if (avpacket) {
+            if (needSourceParameterSets && (avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY)) {
+              insertParameterSets(avpacket, sourceParameterSets, naluLengthSizeMinusOne)
+              needSourceParameterSets = false
+            }
+            return avpacket
+          }
+        }
+        else if (boundary) {
+          const avpacket = createAVPacket()
+          if (await boundary.reader.read(avpacket)) {
+            this.convertBoundaryPacket(
+              avpacket,
+              boundary,
+              videoStream,
+              boundary === head ? source.headDelay : source.tailDelay,
+              naluLengthSizeMinusOne
+            )
+            return avpacket
+          }
+          destroyAVPacket(avpacket)
+        }
+        stage++
+      }
+      return nullptr
+    }
+
+    let ret = mux.open(oformatContext, {
+      zeroStart: options.startAtZero ?? false,
+      nonnegative: options.nonnegative ?? false
+    })
+    if (ret < 0) {
+      logger.error(`open smart cut output muxer failed, ret: ${ret}`)
+    }
+    else {
+      mux.writeHeader(oformatContext)
+
+      let videoPacket = await readVideo()
+      let audioPacket = audioStream ? await source.read(AVMediaType.AVMEDIA_TYPE_AUDIO) : nullptr
+
+      // 按 dts 交织写入
+      while (videoPacket || audioPacket) {
+        let writeVideo = !!videoPacket
+        if (videoPacket && audioPacket) {
+          writeVideo = avRescaleQ2(videoPacket.dts, addressof(videoPacket.timeBase), AV_TIME_BASE_Q)
+            <= avRescaleQ2(audioPacket.dts, addressof(audioPacket.timeBase), AV_TIME_BASE_Q)
+        }
+        if (writeVideo) {
+          videoPacket.streamIndex = 0
+          mux.writeAVPacket(oformatContext, videoPacket)
+          destroyAVPacket(videoPacket)
+          videoPacket = await readVideo()
+        }
+        else {
+          audioPacket.streamIndex = 1
+          mux.writeAVPacket(oformatContext, audioPacket)
+          destroyAVPacket(audioPacket)
+          audioPacket = await source.read(AVMediaType.AVMEDIA_TYPE_AUDIO)
+        }
+      }
+
+      mux.writeTrailer(oformatContext)
+      mux.flush(oformatContext)
+    }
+
+    await oformatContext.destroy()
+    await fileWriter.close()
+
+    return ret < 0 ? ret : 0
+  }
+
+  /**
+   * 智能裁剪
+   *
+   * @param formatContext 用于查找关键帧和读取复制部分的输入
+   * @param options
+   * @returns 成功返回 0，否则返回错误码
+   */
+  public async cut(formatContext: AVIFormatContext, options: SmartCutOptions): Promise<int32> {
+    const videoStream = formatContext.streams.find((stream) => {
+      return stream.codecpar.codecType === AVMediaType.AVMEDIA_TYPE_VIDEO
+        && !(stream.disposition & AVDisposition.ATTACHED_PIC)
+    })
+    if (!videoStream || options.output.video?.disable) {
+      logger.error('smart cut need video stream')
+      return errorType.INVALID_PARAMETERS
+    }
+
+    await this.ready()
+
+    const codec = options.output.video?.codec
+    if (!array.has(SupportedCodecs, videoStream.codecpar.codecId)
+      || codec && codec !== 'copy' && VideoCodecString2CodecId[codec] !== videoStream.codecpar.codecId
+    ) {
+      logger.warn(`smart cut not support codec ${videoStream.codecpar.codecId} to ${codec}, fallback to re-encode the whole range`)
+      return runTask(this.transcoder, {
+        input: options.input,
+        start: options.start,
+        duration: options.duration,
+        output: options.output
+      })
+    }
+
+    let format: AVFormat
+    if (options.output.format) {
+      format = Format2AVFormat[options.output.format]
+    }
+    else if (options.output.file instanceof FileSystemFileHandle) {
+      format = Ext2Format[options.output.file.name.split('.').pop()]
+    }
+
+    const end = options.duration ? options.start + options.duration : -1
+    const startPts = avRescaleQ(static_cast<int64>(options.start), AV_MILLI_TIME_BASE_Q, videoStream.timeBase)
+    const endPts = end >= 0
+      ? avRescaleQ(static_cast<int64>(end), AV_MILLI_TIME_BASE_Q, videoStream.timeBase)
+      : NOPTS_VALUE_BIGINT
+
+    const points = await this.findCutPoints(formatContext, videoStream, startPts, endPts)
+
+    if (points.first === NOPTS_VALUE_BIGINT) {
+      logger.info('no keyframe in the range, re-encode the whole range')
+      return this.reencode(options)
+    }
+
+    // 结束时间在流的结尾之后，最后一个 gop 直接复制
+    if (endPts !== NOPTS_VALUE_BIGINT && videoStream.duration !== NOPTS_VALUE_BIGINT) {
+      const streamEnd = (videoStream.startTime !== NOPTS_VALUE_BIGINT ? videoStream.startTime : 0n) + videoStream.duration
+      if (streamEnd <= endPts) {
+        points.last = NOPTS_VALUE_BIGINT
+      }
+    }
+    else if (endPts === NOPTS_VALUE_BIGINT) {
+      points.last = NOPTS_VALUE_BIGINT
+    }
+
+    if (points.last !== NOPTS_VALUE_BIGINT && await this.hasLeadingPictures(formatContext, videoStream, points.last)) {
+      logger.warn('last keyframe in the range has leading pictures (open gop), fallback to re-encode the whole range')
+      return this.reencode(options)
+    }
+
+    const firstMs = Math.floor(static_cast<double>(avRescaleQ(points.first, videoStream.timeBase, AV_MILLI_TIME_BASE_Q)))
+    const lastMs = points.last !== NOPTS_VALUE_BIGINT
+      ? Math.floor(static_cast<double>(avRescaleQ(points.last, videoStream.timeBase, AV_MILLI_TIME_BASE_Q)))
+      : -1
+
+    logger.info(`smart cut start, range: [${options.start}, ${end}], copy: [${firstMs}, ${lastMs}]`)
+
+    const [head, tail] = await Promise.all([
+      // range 的结束是闭区间，提前 1 毫秒避免第一个关键帧在头部中输出
+      points.first > startPts ? this.encodeBoundary(options, videoStream, options.start, firstMs - options.start - 1) : null,
+      lastMs >= 0 ? this.encodeBoundary(options, videoStream, lastMs, end - lastMs) : null
+    ])
+
+    const audioStream = options.output.audio?.disable
+      ? null
+      : formatContext.getStreamByMediaType(AVMediaType.AVMEDIA_TYPE_AUDIO)
+
+    let ret = 0
+
+    if (points.first > startPts && !head || lastMs >= 0 && !tail) {
+      ret = errorType.DATA_INVALID
+    }
+    else {
+      const discards = formatContext.streams.map((s) => s.discard)
+      const source = new SourcePacketReader(formatContext, videoStream, audioStream, points, options.start, end)
+      ret = await source.open(options.start)
+      if (ret >= 0) {
+        ret = await this.remux(options, format, source, videoStream, audioStream, head, tail)
+      }
+      source.close()
+      array.each(formatContext.streams, (s, index) => {
+        s.discard = discards[index]
+      })
+    }
+
+    if (head) {
+      await head.reader.close()
+    }
+    if (tail) {
+      await tail.reader.close()
+    }
+
+    return ret
+  }
+
+  public async destroy() {
+    if (this.transcoder) {
+      await this.transcoder.destroy()
+      this.transcoder = undefined
+    }
+  }
+}
@@ -0,0 +1,344 @@
+/*
+ * libmedia thumbnail extractor
+ * 
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ * 
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ */
+
+import {
+  type WebAssemblyResource
+} from '@libmedia/cheap'
+
+import {
+  logger,
+  array
+} from '@libmedia/common'
+
+import {
+  type AVFrame,
+  type AVStream,
+  AVMediaType,
+  AVPixelFormat,
+  AVPacketFlags,
+  AVSeekFlags,
+  AVDiscard,
+  AVDisposition,
+  errorType,
+  createAVPacket,
+  destroyAVPacket,
+  unrefAVPacket,
+  destroyAVFrame,
+  createAVFrame,
+  avRescaleQ,
+  NOPTS_VALUE_BIGINT
+} from '@libmedia/avutil'
+
+import {
+  AV_MILLI_TIME_BASE_Q
+} from '@libmedia/avutil/internal'
+
+import {
+  demux,
+  type AVIFormatContext
+} from '@libmedia/avformat'
+
+import {
+  WasmVideoDecoder,
+  DecoderFastLevel,
+  AVDiscard as DecoderDiscard
+} from '@libmedia/avcodec'
+
+import {
+  VideoScaler,
+  ScaleAlgorithm
+} from '@libmedia/videoscale'
+
+export interface ThumbnailExtractorOptions {
+  decoderResource: WebAssemblyResource
+  scalerResource: WebAssemblyResource
+}
+
+export interface ThumbnailOptions {
+  /**
+   * 缩略图数量，在流时长内均匀分布
+   */
+  count: number
+  /**
+   * 缩略图宽度
+   */
+  width: number
+  /**
+   * 缩略图高度，不传按源宽高比计算
+   */
+  height?: number
+  /**
+   * 输出像素格式，默认 RGBA
+   */
+  format?: AVPixelFormat
+  /**
+   * 开始时间（毫秒），默认从流的开始
+   */
+  start?: number
+  /**
+   * 持续时间（毫秒），默认到流的结尾
+   */
+  duration?: number
+  /**
+   * 拿到缩略图的回调，frame 在回调返回之后释放，需要保留请自行 ref
+   * 
+   * @param frame 缩放之后的帧
+   * @param index 缩略图序号
+   * @param timestamp 缩略图实际对应的关键帧时间（毫秒）
+   */
+  onThumbnail: (frame: pointer<AVFrame>, index: number, timestamp: number) => void | Promise<void>
+}
+
+/**
+ * 关键帧缩略图提取
+ * 
+ * 对每个目标时间点 seek 到之前最近的关键帧（使用 demuxer 的索引），只解码这一个关键帧并直接缩放到目标尺寸，
+ * 多个时间点落在同一个关键帧时复用上一次的结果
+ * 
+ * formatContext 需要调用方完成 demux.open 和 demux.analyzeStreams
+ */
+export default class ThumbnailExtractor {
+
+  private options: ThumbnailExtractorOptions
+
+  private decoder: WasmVideoDecoder | undefined
+
+  private scaler: VideoScaler | undefined
+
+  private frame: pointer<AVFrame> = nullptr
+
+  constructor(options: ThumbnailExtractorOptions) {
+    this.options = options
+  }
+
+  private async openDecoder(stream: AVStream, lowres: boolean) {
+    this.decoder = new WasmVideoDecoder({
+      resource: this.options.decoderResource,
+      onReceiveAVFrame: (frame) => {
+        // 只保留最后一帧
+        if (this.frame) {
+          destroyAVFrame(this.frame)
+        }
+        this.frame = frame
+      }
+    })
+    const ret = await this.decoder.open(addressof(stream.codecpar), 1, lowres ? { lowres: '1' } : {})
+    if (ret < 0) {
+      return ret
+    }
+    this.decoder.setSkipFrameDiscard(DecoderDiscard.AVDISCARD_NONKEY)
+    this.decoder.setFastDecode(DecoderFastLevel.FASTER)
+    return 0
+  }
+
+  private async openScaler(frame: pointer<AVFrame>, width: int32, height: int32, format: AVPixelFormat) {
+    if (this.scaler) {
+      const input = this.scaler.getInputScaleParameters()!
+      if (input.width === frame.width && input.height === frame.height && input.format === frame.format) {
+        return 0
+      }
+      this.scaler.close()
+    }
+    this.scaler = new VideoScaler({
+      resource: this.options.scalerResource
+    })
+    return this.scaler.open(
+      {
+        width: frame.width,
+        height: frame.height,
+        format: frame.format,
+        colorSpace: frame.colorSpace,
+        colorRange: frame.colorRange
+      },
+      {
+        width,
+        height,
+        format
+      },
+      ScaleAlgorithm.FAST_BILINEAR
+    )
+  }
+
+  /**
+   * 提取缩略图
+   * 
+   * @param formatContext
+   * @param options
+   * @returns 成功返回输出的缩略图数量，否则返回错误码
+   */
+  public async extract(formatContext: AVIFormatContext, options: ThumbnailOptions): Promise<int32> {
+    const stream = formatContext.streams.find((stream) => {
+      return stream.codecpar.codecType === AVMediaType.AVMEDIA_TYPE_VIDEO
+        && !(stream.disposition & AVDisposition.ATTACHED_PIC)
+    })
+
+    if (!stream) {
+      logger.error('not found video stream to extract thumbnail')
+      return errorType.INVALID_PARAMETERS
+    }
+    if (options.count <= 0 || options.width <= 0) {
+      return errorType.INVALID_PARAMETERS
+    }
+
+    const width = options.width & ~1
+    const height = options.height
+      ? options.height & ~1
+      : Math.round(options.width * stream.codecpar.height / stream.codecpar.width) & ~1
+    const format = options.format ?? AVPixelFormat.AV_PIX_FMT_RGBA
+
+    const startTime = stream.startTime !== NOPTS_VALUE_BIGINT
+      ? static_cast<double>(avRescaleQ(stream.startTime, stream.timeBase, AV_MILLI_TIME_BASE_Q))
+      : 0
+    const streamDuration = stream.duration !== NOPTS_VALUE_BIGINT
+      ? static_cast<double>(avRescaleQ(stream.duration, stream.timeBase, AV_MILLI_TIME_BASE_Q))
+      : 0
+    const start = options.start ?? 0
+    const duration = options.duration ?? Math.max(streamDuration - start, 0)
+
+    // 缩略图比源小一半以上时让解码器直接输出 lowres
+    const lowres = width * 2 <= stream.codecpar.width && height * 2 <= stream.codecpar.height
+
+    let ret = await this.openDecoder(stream, lowres)
+    if (ret < 0) {
+      logger.error(`open thumbnail decoder failed, ret: ${ret}`)
+      this.close()
+      return ret
+    }
+
+    // 只读取视频流的关键帧，demuxer 支持时直接在索引中跳过
+    const discards = formatContext.streams.map((s) => s.discard)
+    array.each(formatContext.streams, (s) => {
+      s.discard = s === stream ? AVDiscard.AVDISCARD_NONKEY : AVDiscard.AVDISCARD_ALL
+    })
+
+    const avpacket = createAVPacket()
+    const out = createAVFrame()
+
+    let lastKeyPts = NOPTS_VALUE_BIGINT
+    let lastTimestamp = 0
+    let hasOut = false
+    let count = 0
+
+    for (let i = 0; i < options.count; i++) {
+      const target = start + duration * (i + 0.5) / options.count
+
+      // seek 使用绝对时间戳，需要加上流的起始时间
+      const seekRet = await demux.seek(formatContext, stream.index, static_cast<int64>(Math.floor(startTime + target)), AVSeekFlags.NONE)
+
+      if (seekRet < 0n) {
+        logger.warn(`seek to ${target}ms failed, ret: ${seekRet}`)
+        continue
+      }
+
+      let keyPts = NOPTS_VALUE_BIGINT
+
+      while (true) {
+        ret = await demux.readAVPacket(formatContext, avpacket)
+        if (ret < 0) {
+          break
+        }
+        if (avpacket.streamIndex !== stream.index || !(avpacket.flags & AVPacketFlags.AV_PKT_FLAG_KEY)) {
+          unrefAVPacket(avpacket)
+          continue
+        }
+        keyPts = avpacket.pts !== NOPTS_VALUE_BIGINT ? avpacket.pts : avpacket.dts
+        if (keyPts === lastKeyPts && hasOut) {
+          unrefAVPacket(avpacket)
+          break
+        }
+        ret = this.decoder!.decode(avpacket)
+        unrefAVPacket(avpacket)
+        if (ret >= 0) {
+          ret = await this.decoder!.flush()
+        }
+        break
+      }
+
+      if (keyPts === NOPTS_VALUE_BIGINT) {
+        // 没有更多的关键帧了
+        break
+      }
+
+      if (keyPts !== lastKeyPts) {
+        if (ret < 0 || !this.frame) {
+          logger.warn(`decode keyframe at ${target}ms failed, ret: ${ret}`)
+          continue
+        }
+
+        ret = await this.openScaler(this.frame, width, height, format)
+        if (ret < 0) {
+          logger.error(`open thumbnail scaler failed, ret: ${ret}`)
+          break
+        }
+        ret = this.scaler!.scale(this.frame, out)
+        if (ret < 0) {
+          logger.error(`scale thumbnail failed, ret: ${ret}`)
+          break
+        }
+        out.pts = this.frame.pts
+        out.timeBase.den = this.frame.timeBase.den
+        out.timeBase.num = this.frame.timeBase.num
+
+        destroyAVFrame(this.frame)
+        this.frame = nullptr
+
+        lastKeyPts = keyPts
+        lastTimestamp = static_cast<double>(avRescaleQ(keyPts, stream.timeBase, AV_MILLI_TIME_BASE_Q)) - startTime
+        hasOut = true
+      }
+
+      await options.onThumbnail(out, i, lastTimestamp)
+      count++
+    }
+
+    array.each(formatContext.streams, (s, index) => {
+      s.discard = discards[index]
+    })
+
+    destroyAVPacket(avpacket)
+    destroyAVFrame(out)
+    this.close()
+
+    return ret < 0 && !count ? ret : count
+  }
+
+  /**
+   * 释放解码器和缩放器
+   */
+  public close() {
+    if (this.decoder) {
+      this.decoder.close()
+      this.decoder = undefined
+    }
+    if (this.scaler) {
+      this.scaler.close()
+      this.scaler = undefined
+    }
+    if (this.frame) {
+      destroyAVFrame(this.frame)
+      this.frame = nullptr
+    }
+  }
+}
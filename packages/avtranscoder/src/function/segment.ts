@@ -0,0 +1,299 @@
+/*
+ * libmedia segment transcode utils
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ *
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ *
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import {
+  logger,
+  object
+} from '@libmedia/common'
+
+import {
+  IOReader,
+  IOWriterSync,
+  IOError,
+  SafeFileWriter
+} from '@libmedia/common/io'
+
+import {
+  type AVPacket,
+  type AVStream,
+  AVMediaType,
+  AVFormat,
+  errorType,
+  unrefAVPacket
+} from '@libmedia/avutil'
+
+import {
+  demux,
+  createAVIFormatContext,
+  createAVOFormatContext,
+  type AVIFormatContext,
+  type AVOFormatContext,
+  type OFormat
+} from '@libmedia/avformat'
+
+import type { TaskOptions } from '../AVTranscoder'
+import AVTranscoder from '../AVTranscoder'
+
+/**
+ * 内存输出，中间结果保存在内存中
+ */
+export class MemoryWriter {
+
+  private buffer: Uint8Array = new Uint8Array(1024 * 1024)
+
+  private length: number = 0
+
+  private pos: number = 0
+
+  private ensure(size: number) {
+    if (size > this.buffer.length) {
+      const buffer = new Uint8Array(Math.max(size, this.buffer.length * 2))
+      buffer.set(this.buffer.subarray(0, this.length), 0)
+      this.buffer = buffer
+    }
+  }
+
+  public write(buffer: Uint8Array) {
+    this.ensure(this.pos + buffer.length)
+    this.buffer.set(buffer, this.pos)
+    this.pos += buffer.length
+    this.length = Math.max(this.length, this.pos)
+  }
+
+  public appendBufferByPosition(buffer: Uint8Array, pos: number) {
+    this.ensure(this.length + buffer.length)
+    this.buffer.copyWithin(pos + buffer.length, pos, this.length)
+    this.buffer.set(buffer, pos)
+    this.length += buffer.length
+  }
+
+  public seek(pos: number) {
+    this.pos = pos
+  }
+
+  public close() {
+
+  }
+
+  public getData() {
+    return this.buffer.subarray(0, this.length)
+  }
+}
+
+function createMemoryReader(data: Uint8Array) {
+  const ioReader = new IOReader()
+  let pos = 0
+
+  ioReader.onFlush = async (buffer) => {
+    if (pos >= data.length) {
+      return IOError.END
+    }
+    const len = Math.min(buffer.length, data.length - pos)
+    buffer.set(data.subarray(pos, pos + len), 0)
+    pos += len
+    return len
+  }
+  ioReader.onSeek = (offset) => {
+    pos = Number(offset)
+    return 0
+  }
+  ioReader.onSize = () => {
+    return static_cast<int64>(data.length)
+  }
+  return ioReader
+}
+
+/**
+ * 打开一段中间结果，返回其中指定类型的流
+ */
+export async function openMemoryInput(data: Uint8Array, mediaType: AVMediaType) {
+  const iformatContext = createAVIFormatContext()
+  iformatContext.ioReader = createMemoryReader(data)
+  iformatContext.iformat = new ((await import('@libmedia/avformat/IMatroskaFormat')).default)
+
+  let ret = await demux.open(iformatContext)
+  if (ret >= 0) {
+    ret = await demux.analyzeStreams(iformatContext)
+  }
+  const stream = iformatContext.getStreamByMediaType(mediaType)
+  if (ret < 0 || !stream) {
+    await iformatContext.destroy()
+    return null
+  }
+  return {
+    formatContext: iformatContext,
+    stream
+  }
+}
+
+/**
+ * 按顺序读取多段中间结果中的某一种流，跨段连续输出
+ */
+export class SegmentPacketReader {
+
+  private datas: Uint8Array[]
+
+  private mediaType: AVMediaType
+
+  private current: {
+    formatContext: AVIFormatContext
+    stream: AVStream
+  } | null = null
+
+  private index: number = 0
+
+  constructor(datas: Uint8Array[], mediaType: AVMediaType) {
+    this.datas = datas
+    this.mediaType = mediaType
+  }
+
+  public async open() {
+    this.current = await openMemoryInput(this.datas[0], this.mediaType)
+    return this.current ? this.current.stream : null
+  }
+
+  /**
+   * 读取下一个包，全部读完返回 false
+   */
+  public async read(avpacket: pointer<AVPacket>) {
+    while (true) {
+      if (!this.current) {
+        if (++this.index >= this.datas.length) {
+          return false
+        }
+        this.current = await openMemoryInput(this.datas[this.index], this.mediaType)
+        if (!this.current) {
+          logger.warn(`open segment ${this.index} failed, skip it`)
+          continue
+        }
+      }
+      const ret = await demux.readAVPacket(this.current.formatContext, avpacket)
+      if (ret < 0) {
+        await this.current.formatContext.destroy()
+        this.current = null
+        continue
+      }
+      if (avpacket.streamIndex !== this.current.stream.index) {
+        unrefAVPacket(avpacket)
+        continue
+      }
+      avpacket.timeBase.den = this.current.stream.timeBase.den
+      avpacket.timeBase.num = this.current.stream.timeBase.num
+      return true
+    }
+  }
+
+  public async close() {
+    if (this.current) {
+      await this.current.formatContext.destroy()
+      this.current = null
+    }
+  }
+}
+
+export async function createOFormat(format: AVFormat, formatOptions: Record<string, any> = {}): Promise<OFormat> {
+  switch (format) {
+    case AVFormat.ISOBMFF:
+      return new ((await import('@libmedia/avformat/OIsobmffFormat')).default)(formatOptions)
+    case AVFormat.MPEGTS:
+      return new ((await import('@libmedia/avformat/OMpegtsFormat')).default)(formatOptions)
+    case AVFormat.MATROSKA:
+    case AVFormat.WEBM:
+      return new ((await import('@libmedia/avformat/OMatroskaFormat')).default)(object.extend({}, formatOptions, {
+        docType: format === AVFormat.WEBM ? 'webm' : 'matroska'
+      }))
+  }
+  return null
+}
+
+export function runTask(transcoder: AVTranscoder, options: TaskOptions) {
+  return new Promise<int32>(async (resolve) => {
+    let taskId: string
+    const onEnd = (id: string) => {
+      if (id === taskId) {
+        transcoder.off(AVTranscoder.Events.TASK_ENDED, onEnd)
+        transcoder.off(AVTranscoder.Events.TASK_ERROR, onError)
+        resolve(0)
+      }
+    }
+    const onError = (id: string) => {
+      if (id === taskId) {
+        transcoder.off(AVTranscoder.Events.TASK_ENDED, onEnd)
+        transcoder.off(AVTranscoder.Events.TASK_ERROR, onError)
+        resolve(errorType.DATA_INVALID)
+      }
+    }
+    transcoder.on(AVTranscoder.Events.TASK_ENDED, onEnd)
+    transcoder.on(AVTranscoder.Events.TASK_ERROR, onError)
+    try {
+      taskId = await transcoder.addTask(options)
+      await transcoder.startTask(taskId)
+    }
+    catch (error) {
+      logger.error(`segment task failed, ${error}`)
+      transcoder.off(AVTranscoder.Events.TASK_ENDED, onEnd)
+      transcoder.off(AVTranscoder.Events.TASK_ERROR, onError)
+      resolve(errorType.DATA_INVALID)
+    }
+  })
+}
+
+/**
+ * 创建最终输出的封装上下文，FileSystemFileHandle 使用 SafeFileWriter 写入
+ */
+export async function createOutput(file: TaskOptions['output']['file'], oformat: OFormat) {
+  let fileWriter: Exclude<TaskOptions['output']['file'], FileSystemFileHandle>
+  if (file instanceof FileSystemFileHandle) {
+    const safeFileIO = new SafeFileWriter(file)
+    await safeFileIO.ready()
+    fileWriter = safeFileIO
+  }
+  else {
+    fileWriter = file
+  }
+
+  const oformatContext: AVOFormatContext = createAVOFormatContext()
+  const ioWriter = new IOWriterSync(5 * 1024 * 1024)
+  ioWriter.onFlush = (data, pos) => {
+    if (pos != null) {
+      fileWriter.appendBufferByPosition(data.slice(), Number(pos))
+    }
+    else {
+      fileWriter.write(data.slice())
+    }
+    return 0
+  }
+  ioWriter.onSeek = (pos) => {
+    fileWriter.seek(Number(pos))
+    return 0
+  }
+  oformatContext.ioWriter = ioWriter
+  oformatContext.oformat = oformat
+
+  return {
+    oformatContext,
+    fileWriter
+  }
+}
@@ -22,7 +22,8 @@
  *
  */
 
-import { is } from '@libmedia/common'
+import { is, logger } from '@libmedia/common'
+import { getWasmFallbackUrl } from './getWasmUrl'
 
 import {
   config as cheapConfig,
@@ -34,9 +35,23 @@ export default async function compileResource(wasmUrl: string | ArrayBuffer | We
   let resource: WebAssemblyResource
 
   if (is.string(wasmUrl) || is.arrayBuffer(wasmUrl)) {
-    resource = await compile({
-      source: wasmUrl
-    })
+    while (true) {
+      try {
+        resource = await compile({
+          source: wasmUrl
+        })
+        break
+      }
+      catch (error) {
+        // simd 或 atomic 版本加载失败（没有部署或运行环境不支持）时降级重试
+        const fallback = is.string(wasmUrl) ? getWasmFallbackUrl(wasmUrl, error) : null
+        if (!fallback) {
+          throw error
+        }
+        logger.warn(`compile wasm ${wasmUrl} failed, fallback to ${fallback}, error: ${error}`)
+        wasmUrl = fallback
+      }
+    }
     if (cheapConfig.USE_THREADS && defined(ENABLE_THREADS) && thread) {
       resource.threadModule = await compile(
         {
@@ -4,9 +4,61 @@ import { AVCodecID } from '../codec'
 let supportAtomic = WebAssembly.validate(base64.base64ToUint8Array('AGFzbQEAAAABBgFgAX8BfwISAQNlbnYGbWVtb3J5AgMBgIACAwIBAAcJAQVsb2FkOAAACgoBCAAgAP4SAAAL'))
 let supportSimd = WebAssembly.validate(base64.base64ToUint8Array('AGFzbQEAAAABBQFgAAF7AhIBA2VudgZtZW1vcnkCAwGAgAIDAgEACgoBCABBAP0ABAAL'))
 
-export default function getWasmUrl(baseUrl: string, type: 'decoder' | 'encoder' | 'resampler' | 'scaler' | 'stretchpitcher', codecId?: AVCodecID): string {
+export type WasmVariant = 'baseline' | 'atomic' | 'simd'
 
-  let tag = defined(WASM_64) ? '-64' : (supportSimd ? '-simd' : (supportAtomic ? '-atomic' : ''))
+const WasmVariantTag = {
+  baseline: '',
+  atomic: '-atomic',
+  simd: '-simd'
+}
+
+/**
+ * 获取降级的 wasm 地址
+ * 
+ * simd 版本加载失败时降级到 atomic 版本，atomic 版本失败时降级到基础版本
+ * 如果是编译或链接失败说明运行环境实际不支持该版本（例如特性检测通过但实现有问题），之后的 getWasmUrl 直接返回降级的版本
+ * 
+ * @param url 加载失败的地址
+ * @param error 加载失败的错误
+ * @returns 没有可降级的版本返回 null
+ */
+export function getWasmFallbackUrl(url: string, error?: any): string {
+  const unsupported = error instanceof WebAssembly.CompileError || error instanceof WebAssembly.LinkError
+  if (/-simd\.wasm$/.test(url)) {
+    if (unsupported) {
+      supportSimd = false
+    }
+    return url.replace(/-simd\.wasm$/, supportAtomic ? '-atomic.wasm' : '.wasm')
+  }
+  else if (/-atomic\.wasm$/.test(url)) {
+    if (unsupported) {
+      supportAtomic = false
+    }
+    return url.replace(/-atomic\.wasm$/, '.wasm')
+  }
+  return null
+}
+
+/**
+ * 获取 wasm 模块的地址
+ * 
+ * 默认根据运行环境选择最优的版本，支持 simd 时使用 simd 版本，加载失败时使用 getWasmFallbackUrl 降级
+ * 
+ * @param baseUrl wasm 目录地址
+ * @param type 模块类型
+ * @param codecId 编解码器 id，decoder 和 encoder 需要
+ * @param variant 指定版本，不传自动选择，用于对比不同版本的性能
+ */
+export default function getWasmUrl(
+  baseUrl: string,
+  type: 'decoder' | 'encoder' | 'resampler' | 'scaler' | 'stretchpitcher',
+  codecId?: AVCodecID,
+  variant?: WasmVariant
+): string {
+
+  let tag = variant
+    ? WasmVariantTag[variant]
+    : (defined(WASM_64) ? '-64' : (supportSimd ? '-simd' : (supportAtomic ? '-atomic' : '')))
 
   switch (type) {
     case 'decoder': {
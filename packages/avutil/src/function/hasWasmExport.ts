@@ -0,0 +1,48 @@
+/*
+ * libmedia has wasm export
+ *
+ * 版权所有 (C) 2024 赵高兴
+ * Copyright (C) 2024 Gaoxing Zhao
+ *
+ * 此文件是 libmedia 的一部分
+ * This file is part of libmedia.
+ * 
+ * libmedia 是自由软件；您可以根据 GNU Lesser General Public License（GNU LGPL）3.1
+ * 或任何其更新的版本条款重新分发或修改它
+ * libmedia is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.1 of the License, or (at your option) any later version.
+ * 
+ * libmedia 希望能够为您提供帮助，但不提供任何明示或暗示的担保，包括但不限于适销性或特定用途的保证
+ * 您应自行承担使用 libmedia 的风险，并且需要遵守 GNU Lesser General Public License 中的条款和条件。
+ * libmedia is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+import type { WebAssemblyResource } from '@libmedia/cheap'
+
+const exportsCache: WeakMap<WebAssembly.Module, Set<string>> = new WeakMap()
+
+/**
+ * 检查 wasm 模块是否导出了指定的函数
+ * 
+ * 用于兼容没有重新编译的旧版本 wasm，新增的导出函数不存在时调用方应跳过或降级
+ * 
+ * @param resource 
+ * @param name 导出函数名
+ */
+export default function hasWasmExport(resource: WebAssemblyResource, name: string) {
+  if (!resource || !resource.module) {
+    return false
+  }
+  let names = exportsCache.get(resource.module)
+  if (!names) {
+    names = new Set(WebAssembly.Module.exports(resource.module).map((item) => item.name))
+    exportsCache.set(resource.module, names)
+  }
+  return names.has(name)
+}
@@ -254,8 +254,9 @@ export { default as getAudioCodec } from './function/getAudioCodec'
 export { default as getVideoCodec } from './function/getVideoCodec'
 export { default as getAudioMimeType } from './function/getAudioMimeType'
 export { default as getVideoMimeType } from './function/getVideoMimeType'
-export { default as getWasmUrl } from './function/getWasmUrl'
+export { default as getWasmUrl, getWasmFallbackUrl, type WasmVariant } from './function/getWasmUrl'
 export { default as compileResource } from './function/compileResource'
+export { default as hasWasmExport } from './function/hasWasmExport'
 export { default as analyzeAVFormat } from './function/analyzeAVFormat'
 export { default as analyzeUrlIOLoader } from './function/analyzeUrlIOLoader'
 
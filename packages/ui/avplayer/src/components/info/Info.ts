@@ -25,6 +25,7 @@ const videoStatsKeys = [
   'videoBitrate',
   'videoEncodeFramerate',
   'videoDecodeFramerate',
+  'videoDecodeTimePerFrame',
   'videoRenderFramerate',
   'keyFrameInterval',
   'videoFrameDecodeIntervalMax',
@@ -75,6 +76,9 @@ const Info: ComponentOptions = {
         if (key === 'audioBitrate' || key === 'videoBitrate' || key === 'bandwidth') {
           value = (value * 8 / 1000) + ' kbps'
         }
+        else if (key === 'videoDecodeTimePerFrame') {
+          value = value.toFixed(2) + ' ms'
+        }
         this.append('list', {
           key: key.replace(/([A-Z])/g, ' $1').replace(/^[a-z]/, (s) => s.toUpperCase()),
           value
@@ -44,6 +44,79 @@ int out_color_space = AVCOL_SPC_UNSPECIFIED;
 
 struct SwsContext *sws_ctx;
 
+#define OUT_POOL_PLANES 4
+
+/**
+ * 输出帧的平面从这里分配，js 侧 unref AVFrame 时按 avbuffer.h 中的 BufferPoolEntry 布局归还，
+ * 稳态缩放不再有 malloc
+ */
+AVBufferPool* out_pools[OUT_POOL_PLANES];
+int out_linesize[OUT_POOL_PLANES];
+
+static void out_pool_uninit() {
+  int i;
+  for (i = 0; i < OUT_POOL_PLANES; i++) {
+    // 还有帧在外部使用时，池会在最后一个 buffer 归还后释放
+    av_buffer_pool_uninit(&out_pools[i]);
+    out_linesize[i] = 0;
+  }
+}
+
+static int out_pool_init() {
+  int i, ret;
+  ptrdiff_t linesize[OUT_POOL_PLANES];
+  size_t size[OUT_POOL_PLANES];
+
+  out_pool_uninit();
+
+  // 和 av_frame_get_buffer(dst, 1) 一样不做行对齐
+  ret = av_image_fill_linesizes(out_linesize, out_pix_fmt, out_width);
+  if (ret < 0) {
+    return ret;
+  }
+  for (i = 0; i < OUT_POOL_PLANES; i++) {
+    linesize[i] = out_linesize[i];
+  }
+  ret = av_image_fill_plane_sizes(size, out_pix_fmt, out_height, linesize);
+  if (ret < 0) {
+    return ret;
+  }
+
+  for (i = 0; i < OUT_POOL_PLANES; i++) {
+    if (size[i]) {
+      // 多分配一些，sws_scale 的 simd 实现可能会越过行尾读写
+      out_pools[i] = av_buffer_pool_init(size[i] + 64, NULL);
+      if (!out_pools[i]) {
+        out_pool_uninit();
+        return AVERROR(ENOMEM);
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int out_pool_get_buffer(AVFrame* dst) {
+  int i;
+
+  dst->width = out_width;
+  dst->height = out_height;
+  dst->format = out_pix_fmt;
+
+  for (i = 0; i < OUT_POOL_PLANES && out_pools[i]; i++) {
+    dst->buf[i] = av_buffer_pool_get(out_pools[i]);
+    if (!dst->buf[i]) {
+      av_frame_unref(dst);
+      return AVERROR(ENOMEM);
+    }
+    dst->data[i] = dst->buf[i]->data;
+    dst->linesize[i] = out_linesize[i];
+  }
+  dst->extended_data = dst->data;
+
+  return 0;
+}
+
 EM_PORT_API(int) scale_set_input_parameters(int width, int height, int pix_fmt) {
 
   src_width = width;
@@ -109,6 +182,11 @@ EM_PORT_API(int) scale_init(int flags, int thread_count) {
     return -1;
   }
 
+  if (out_pool_init() < 0) {
+    sws_freeContext(sws_ctx);
+    return -1;
+  }
+
   if (src_color_space != AVCOL_SPC_UNSPECIFIED || out_color_space != AVCOL_SPC_UNSPECIFIED) {
     int in_full, out_full, brightness, contrast, saturation;
     const int *inv_table, *table;
@@ -138,10 +216,7 @@ EM_PORT_API(int) scale_init(int flags, int thread_count) {
 EM_PORT_API(int) scale_process(AVFrame* src, AVFrame* dst) {
   int ret;
   if (!dst->linesize[0]) {
-    dst->width = out_width;
-    dst->height = out_height;
-    dst->format = out_pix_fmt;
-    ret = av_frame_get_buffer(dst, 1);
+    ret = out_pool_get_buffer(dst);
     if (ret < 0) {
       return ret;
     }
@@ -154,4 +229,5 @@ EM_PORT_API(int) scale_process(AVFrame* src, AVFrame* dst) {
 
 EM_PORT_API(int) scale_destroy() {
   sws_freeContext(sws_ctx);
+  out_pool_uninit();
 }